@@ -34,6 +34,8 @@
 //  * RegionDFTraits - It must be specialized to determine data-flow framework
 //                     for a hierarchy of regions.
 //  * solveDataFlow...() - It should be used to solve data-flow problem.
+//  * DFSolverKind - It should be used to choose an algorithm which solves
+//                   data-flow problem for a graph which contains cycles.
 //  * SmallDFNode - It can be inherited to represent nodes of a data-flow graph.
 //
 //===----------------------------------------------------------------------===//
@@ -41,12 +43,16 @@
 #ifndef TSAR_DATA_FLOW_H
 #define TSAR_DATA_FLOW_H
 
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/iterator_range.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/PostOrderIterator.h>
 #include <algorithm>
+#include <functional>
 #include <iterator>
+#include <queue>
 #include <type_traits>
 #include <vector>
 #include <bcl/utility.h>
@@ -120,6 +126,17 @@ template <class GraphType> struct Backward {
   inline Backward(const GraphType &G) : Graph(G) {}
 };
 
+/// Algorithm which is used to solve data-flow problem for a graph which
+/// contains cycles.
+enum class DFSolverKind {
+  /// Sweep all nodes of a graph until no data-flow value is changed
+  /// (see solveDataFlowIteratively()).
+  Iterative,
+  /// Evaluate transfer functions only for nodes which inputs may be changed
+  /// (see solveDataFlowWorklist()).
+  Worklist
+};
+
 /// \brief Iteratively solves data-flow problem.
 ///
 /// This computes IN and OUT for each node in the specified data-flow graph
@@ -136,7 +153,8 @@ template <class GraphType> struct Backward {
 /// The GraphTraits class should be specialized by
 /// DataFlowTraits<DFFwk>::GraphType.
 /// \pre The graph must not contain unreachable nodes.
-template<class DFFwk> void solveDataFlowIteratively(DFFwk DFF,
+/// \return Number of evaluations of transfer functions.
+template<class DFFwk> unsigned solveDataFlowIteratively(DFFwk DFF,
     typename DataFlowTraits<DFFwk>::GraphType DFG) {
   typedef DataFlowTraits<DFFwk> DFT;
   typedef typename DFT::ValueType ValueType;
@@ -151,6 +169,7 @@ template<class DFFwk> void solveDataFlowIteratively(DFFwk DFF,
   }
   DFT::initialize(GT::getEntryNode(DFG), DFF, DFG);
   DFT::setValue(DFT::boundaryCondition(DFF, DFG), GT::getEntryNode(DFG), DFF);
+  unsigned NumTransfers = 0;
   bool isChanged = true;
   do {
     isChanged = false;
@@ -164,10 +183,103 @@ template<class DFFwk> void solveDataFlowIteratively(DFFwk DFF,
            CI != CE; ++CI) {
         DFT::meetOperator(DFT::getValue(*CI, DFF), Value, DFF, DFG);
       }
+      ++NumTransfers;
       isChanged =
         DFT::transferFunction(std::move(Value), *I, DFF, DFG) || isChanged;
     }
   } while (isChanged);
+  return NumTransfers;
+}
+
+/// \brief Solves data-flow problem with a worklist of nodes in reverse
+/// post-order.
+///
+/// This computes IN and OUT for each node in the specified data-flow graph
+/// by successive approximation. In contrast to solveDataFlowIteratively()
+/// a transfer function is reevaluated only for successors of nodes which
+/// data-flow values have been changed. Nodes are extracted from the worklist
+/// in reverse post-order, so the number of evaluations for a graph with
+/// a small loop nesting depth is close to the number of nodes.
+/// The last computed value for each node can be obtained by calling
+/// the DataFlowTraits::getValue() function.
+/// The type of computed value (IN or OUT) depends on a data-flow direction
+/// (see DataFlowTratis). In case of a forward direction it is OUT,
+/// otherwise IN.
+/// \param [in, out] DFF Data-flow framework, it can not be null.
+/// \param [in, out] DFG Data-flow graph specified in the data-flow framework.
+/// Subgraph of this graph also can be used.
+/// \attention The DataFlowTraits class should be specialized by DFFwk.
+/// Note that DFFwk is generally a pointer type.
+/// The GraphTraits class should be specialized by
+/// DataFlowTraits<DFFwk>::GraphType and by
+/// llvm::Inverse<DataFlowTraits<DFFwk>::GraphType>.
+/// \pre The graph must not contain unreachable nodes.
+/// \return Number of evaluations of transfer functions.
+template<class DFFwk> unsigned solveDataFlowWorklist(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG) {
+  typedef DataFlowTraits<DFFwk> DFT;
+  typedef typename DFT::ValueType ValueType;
+  typedef typename DFT::GraphType GraphType;
+  typedef llvm::GraphTraits<GraphType> GT;
+  typedef llvm::GraphTraits<llvm::Inverse<GraphType>> IGT;
+  typedef typename GT::ChildIteratorType ChildIteratorType;
+  typedef typename IGT::ChildIteratorType SuccIteratorType;
+  typedef typename GT::NodeRef NodeRef;
+  typedef llvm::po_iterator<
+    GraphType, llvm::SmallPtrSet<NodeRef, 8>, false, IGT> po_iterator;
+  // Position of a node in reverse post-order is used as a priority
+  // of this node in the worklist.
+  std::vector<NodeRef> RPOT;
+  std::copy(po_iterator::begin(DFG), po_iterator::end(DFG),
+            std::back_inserter(RPOT));
+  std::reverse(RPOT.begin(), RPOT.end());
+  assert(!RPOT.empty() && RPOT.front() == GT::getEntryNode(DFG) &&
+    "The first node in the topological order differs from the entry node "
+    "in the data-flow framework!");
+  llvm::DenseMap<NodeRef, unsigned> RPONumbers;
+  for (unsigned I = 1, E = RPOT.size(); I < E; ++I) {
+    assert(GT::child_begin(RPOT[I]) != GT::child_end(RPOT[I]) &&
+      "Data-flow graph must not contain unreachable nodes!");
+    RPONumbers.try_emplace(RPOT[I], I);
+    DFT::initialize(RPOT[I], DFF, DFG);
+    DFT::setValue(DFT::topElement(DFF, DFG), RPOT[I], DFF);
+  }
+  DFT::initialize(GT::getEntryNode(DFG), DFF, DFG);
+  DFT::setValue(DFT::boundaryCondition(DFF, DFG), GT::getEntryNode(DFG), DFF);
+  // Transfer function must be evaluated at least once for each node except
+  // the entry node.
+  std::priority_queue<unsigned, std::vector<unsigned>, std::greater<unsigned>>
+    Worklist;
+  llvm::BitVector InWorklist(RPOT.size());
+  for (unsigned I = 1, E = RPOT.size(); I < E; ++I) {
+    Worklist.push(I);
+    InWorklist.set(I);
+  }
+  unsigned NumTransfers = 0;
+  while (!Worklist.empty()) {
+    auto Idx = Worklist.top();
+    Worklist.pop();
+    InWorklist.reset(Idx);
+    NodeRef N = RPOT[Idx];
+    ValueType Value(DFT::topElement(DFF, DFG));
+    for (ChildIteratorType CI = GT::child_begin(N), CE = GT::child_end(N);
+         CI != CE; ++CI) {
+      DFT::meetOperator(DFT::getValue(*CI, DFF), Value, DFF, DFG);
+    }
+    ++NumTransfers;
+    if (!DFT::transferFunction(std::move(Value), N, DFF, DFG))
+      continue;
+    for (SuccIteratorType SI = IGT::child_begin(N), SE = IGT::child_end(N);
+         SI != SE; ++SI) {
+      // Note, that the entry node is not presented in the list of numbers.
+      auto SuccItr = RPONumbers.find(*SI);
+      if (SuccItr == RPONumbers.end() || InWorklist.test(SuccItr->second))
+        continue;
+      Worklist.push(SuccItr->second);
+      InWorklist.set(SuccItr->second);
+    }
+  }
+  return NumTransfers;
 }
 
 /// \brief Solves data-flow problem in topological order during one iteration.
@@ -188,7 +300,8 @@ template<class DFFwk> void solveDataFlowIteratively(DFFwk DFF,
 /// The GraphTraits class should be specialized by
 /// DataFlowTraits<DFFwk>::GraphType.
 /// \pre The graph must not contain unreachable nodes.
-template<class DFFwk> void solveDataFlowTopologicaly(DFFwk DFF,
+/// \return Number of evaluations of transfer functions.
+template<class DFFwk> unsigned solveDataFlowTopologicaly(DFFwk DFF,
     typename DataFlowTraits<DFFwk>::GraphType DFG) {
   typedef DataFlowTraits<DFFwk> DFT;
   typedef typename DFT::ValueType ValueType;
@@ -224,14 +337,31 @@ template<class DFFwk> void solveDataFlowTopologicaly(DFFwk DFF,
   }
   DFT::initialize(GT::getEntryNode(DFG), DFF, DFG);
   DFT::setValue(DFT::boundaryCondition(DFF, DFG), GT::getEntryNode(DFG), DFF);
+  unsigned NumTransfers = 0;
   for (I = RPOT.rbegin(), ++I; I != E; ++I) {
     ValueType Value(DFT::topElement(DFF, DFG));
     for (ChildIteratorType CI = GT::child_begin(*I), CE = GT::child_end(*I);
          CI != CE; ++CI) {
       DFT::meetOperator(DFT::getValue(*CI, DFF), Value, DFF, DFG);
     }
+    ++NumTransfers;
     DFT::transferFunction(std::move(Value), *I, DFF, DFG);
   }
+  return NumTransfers;
+}
+
+/// \brief Solves data-flow problem for a graph which may contain cycles.
+///
+/// If the graph is acyclic the problem is solved in topological order in
+/// a single pass, otherwise the specified algorithm is used.
+/// \return Number of evaluations of transfer functions.
+template<class DFFwk> unsigned solveDataFlow(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG, DFSolverKind Kind) {
+  if (isDAG(DFG))
+    return solveDataFlowTopologicaly(DFF, DFG);
+  if (Kind == DFSolverKind::Worklist)
+    return solveDataFlowWorklist(DFF, DFG);
+  return solveDataFlowIteratively(DFF, DFG);
 }
 
 /// \brief Data-flow framework for a hierarchy of regions.
@@ -278,29 +408,32 @@ template<class DFFwk > struct RegionDFTraits {
 /// one node which is associated with the whole specified graph. When traversing
 /// from the specified graph to innermost graphs, regions will be consistently
 /// expanded to a data-flow graph. If it is possible the problem will be solved
-/// in topological order in a single pass, otherwise iteratively.
+/// in topological order in a single pass, otherwise with a specified
+/// algorithm.
 /// \param [in, out] DFF Data-flow framework, it can not be null.
 /// \param [in, out] DFG Data-flow graph specified in the data-flow framework.
 /// Subgraph of this graph also can be used.
+/// \param [in] Kind Algorithm to solve the problem for regions with cycles.
 /// \attention DataFlowTraits and RegionDFTraits classes should be specialized
 /// by DFFwk. Note that DFFwk is generally a pointer type.
 /// The llvm::GraphTraits class should be specialized by type of each
 /// regions in the hierarchy (not only for DataFlowTraits<DFFwk>::GraphType).
 /// Note that type of region is generally a pointer type.
 /// \pre The graph must not contain unreachable nodes.
-template<class DFFwk> void solveDataFlowUpward(DFFwk DFF,
-    typename DataFlowTraits<DFFwk>::GraphType DFG) {
+/// \return Number of evaluations of transfer functions in all regions.
+template<class DFFwk> unsigned solveDataFlowUpward(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG,
+    DFSolverKind Kind = DFSolverKind::Iterative) {
   typedef RegionDFTraits<DFFwk> RT;
   typedef typename RT::region_iterator region_iterator;
   RT::expand(DFF, DFG);
+  unsigned NumTransfers = 0;
   for (region_iterator I = RT::region_begin(DFG), E = RT::region_end(DFG);
        I != E; ++I)
-    solveDataFlowUpward(DFF, *I);
-  if (isDAG(DFG))
-    solveDataFlowTopologicaly(DFF, DFG);
-  else
-    solveDataFlowIteratively(DFF, DFG);
+    NumTransfers += solveDataFlowUpward(DFF, *I, Kind);
+  NumTransfers += solveDataFlow(DFF, DFG, Kind);
   RT::collapse(DFF, DFG);
+  return NumTransfers;
 }
 
 /// \brief Solves data-flow problem for the specified hierarchy of regions.
@@ -315,29 +448,30 @@ template<class DFFwk> void solveDataFlowUpward(DFFwk DFF,
 /// a one node in a data-flow graph associated with this region.
 /// The specified graph will be also collapsed
 /// If it is possible the problem will be solved in topological order
-/// in a single pass, otherwise iteratively.
+/// in a single pass, otherwise with a specified algorithm.
 /// \param [in, out] DFF Data-flow framework, it can not be null.
 /// \param [in, out] DFG Data-flow graph specified in the data-flow framework.
 /// Subgraph of this graph also can be used.
+/// \param [in] Kind Algorithm to solve the problem for regions with cycles.
 /// \attention DataFlowTraits and RegionDFTraits classes should b e specialized
 /// by DFFwk. Note that DFFwk is generally a pointer type.
 /// The llvm::GraphTraits class should be specialized by type of each
 /// regions in the hierarchy (not only for DataFlowTraits<DFFwk>::GraphType).
 /// Note that type of region is generally a pointer type.
 /// \pre The graph must not contain unreachable nodes.
-template<class DFFwk> void solveDataFlowDownward(DFFwk DFF,
-  typename DataFlowTraits<DFFwk>::GraphType DFG) {
+/// \return Number of evaluations of transfer functions in all regions.
+template<class DFFwk> unsigned solveDataFlowDownward(DFFwk DFF,
+  typename DataFlowTraits<DFFwk>::GraphType DFG,
+  DFSolverKind Kind = DFSolverKind::Iterative) {
   typedef RegionDFTraits<DFFwk> RT;
   typedef typename RT::region_iterator region_iterator;
   RT::expand(DFF, DFG);
-  if (isDAG(DFG))
-    solveDataFlowTopologicaly(DFF, DFG);
-  else
-    solveDataFlowIteratively(DFF, DFG);
+  unsigned NumTransfers = solveDataFlow(DFF, DFG, Kind);
   for (region_iterator I = RT::region_begin(DFG), E = RT::region_end(DFG);
        I != E; ++I)
-    solveDataFlowDownward(DFF, *I);
+    NumTransfers += solveDataFlowDownward(DFF, *I, Kind);
   RT::collapse(DFF, DFG);
+  return NumTransfers;
 }
 
 namespace detail{
@@ -0,0 +1,560 @@
+//===- FlatBimap.h ------ Flat Bidirectional Map ----------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a bidirectional map with the same interface as Bimap.
+// However, elements are stored in a contiguous array and both keys are
+// retrieved with the use of open addressing hash indexes which contain
+// positions of elements in this array. So, there are no per-element
+// allocations and there are no pointer chases on a search.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_FLAT_BIMAP_H
+#define TSAR_FLAT_BIMAP_H
+
+#include "tsar/ADT/FlatKeyIndex.h"
+#include <bcl/tagged.h>
+#include <llvm/ADT/DenseMapInfo.h>
+#include <llvm/ADT/Optional.h>
+#include <algorithm>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+namespace tsar {
+namespace detail {
+/// \brief Contiguous storage of elements in a flat bidirectional map.
+///
+/// Elements are stored in the insertion order. Removed elements leave holes
+/// which are skipped by iterators, so iterators and positions of other
+/// elements are not invalidated on removal. Holes are squeezed out by
+/// compact(), an owner of the storage must update its indexes after that.
+template<class ValueTy>
+class FlatStorage {
+  /// Holes are not squeezed out while there are few of them.
+  static constexpr std::size_t MinHoles = 16;
+
+public:
+  using size_type = std::size_t;
+
+  /// Bidirectional iterator which skips holes.
+  class iterator :
+    public std::iterator<
+        std::bidirectional_iterator_tag, ValueTy, std::ptrdiff_t,
+        const ValueTy *, const ValueTy &> {
+  public:
+    typedef ValueTy value_type;
+    typedef const ValueTy * pointer;
+    typedef const ValueTy & reference;
+
+    iterator() = default;
+
+    reference operator*() const { return *mStorage->mValues[mPos]; }
+    pointer operator->() const { return &operator*(); }
+
+    bool operator==(const iterator &RHS) const { return mPos == RHS.mPos; }
+    bool operator!=(const iterator &RHS) const { return mPos != RHS.mPos; }
+
+    iterator & operator--() {
+      do {
+        --mPos;
+      } while (!mStorage->mValues[mPos]);
+      return *this;
+    }
+    iterator & operator++() {
+      ++mPos;
+      mPos = mStorage->skip(mPos);
+      return *this;
+    }
+    iterator operator--(int) { auto Tmp = *this; --*this; return Tmp; }
+    iterator operator++(int) { auto Tmp = *this; ++*this; return Tmp; }
+
+    /// Return position of a referenced element in a storage.
+    unsigned getPosition() const noexcept { return mPos; }
+
+  private:
+    friend FlatStorage;
+    iterator(const FlatStorage *S, unsigned Pos) : mStorage(S), mPos(Pos) {}
+
+    const FlatStorage *mStorage = nullptr;
+    unsigned mPos = 0;
+  };
+
+  using reverse_iterator = std::reverse_iterator<iterator>;
+
+  FlatStorage() = default;
+  FlatStorage(const FlatStorage &) = default;
+  FlatStorage & operator=(const FlatStorage &) = default;
+
+  /// Moves elements from a specified storage, it becomes empty.
+  FlatStorage(FlatStorage &&Other) { swap(Other); }
+
+  /// Moves elements from a specified storage, it becomes empty.
+  FlatStorage & operator=(FlatStorage &&Other) {
+    FlatStorage Tmp(std::move(Other));
+    swap(Tmp);
+    return *this;
+  }
+
+  iterator begin() const { return iterator(this, skip(0)); }
+  iterator end() const { return iterator(this, mValues.size()); }
+
+  /// Return iterator which points to an element at a specified position.
+  iterator getIterator(unsigned Pos) const {
+    assert(Pos < mValues.size() && mValues[Pos] && "Position is invalid!");
+    return iterator(this, Pos);
+  }
+
+  /// Return an element at a specified position.
+  const ValueTy & operator[](unsigned Pos) const {
+    assert(Pos < mValues.size() && mValues[Pos] && "Position is invalid!");
+    return *mValues[Pos];
+  }
+
+  bool empty() const noexcept { return mSize == 0; }
+  size_type size() const noexcept { return mSize; }
+
+  /// Return the number of positions including holes.
+  size_type capacity() const noexcept { return mValues.size(); }
+
+  void reserve(size_type Size) { mValues.reserve(Size); }
+
+  void clear() {
+    mValues.clear();
+    mSize = 0;
+  }
+
+  /// Return true if there are too many holes in the storage.
+  bool needsCompaction() const noexcept {
+    return mValues.size() - mSize >= std::max(mSize, MinHoles);
+  }
+
+  /// Squeeze out holes, the order of elements is preserved.
+  void compact() {
+    auto To{mValues.begin()};
+    for (auto &V : mValues)
+      if (V) {
+        if (&*To != &V)
+          *To = std::move(V);
+        ++To;
+      }
+    mValues.erase(To, mValues.end());
+  }
+
+  /// Append an element to the storage, return its position.
+  template<class... ArgTy> unsigned push_back(ArgTy &&... Args) {
+    mValues.emplace_back(llvm::in_place, std::forward<ArgTy>(Args)...);
+    ++mSize;
+    return mValues.size() - 1;
+  }
+
+  /// Remove an element at a specified position.
+  void erase(unsigned Pos) {
+    assert(Pos < mValues.size() && mValues[Pos] && "Position is invalid!");
+    mValues[Pos].reset();
+    --mSize;
+  }
+
+  void swap(FlatStorage &Other) {
+    mValues.swap(Other.mValues);
+    std::swap(mSize, Other.mSize);
+  }
+
+private:
+  /// Return position of the first element which is not a hole starting
+  /// at a specified position.
+  unsigned skip(unsigned Pos) const {
+    for (unsigned EPos = mValues.size(); Pos < EPos && !mValues[Pos]; ++Pos);
+    return Pos;
+  }
+
+  std::vector<llvm::Optional<ValueTy>> mValues;
+  size_type mSize = 0;
+};
+}
+
+/// \brief Bidirectional associative container, where both values in a pair are
+/// treated as keys, which can be retrieved in quadratic time.
+///
+/// This container has the same interface as Bimap, so it can be used instead
+/// of Bimap. Pairs are stored in a contiguous array in the insertion order,
+/// so this container is preferable for maps which are built once and queried
+/// many times (for example, maps from AST-level to IR-level entities).
+///
+/// Invalidation of iterators, pointers and references referring to elements may
+/// occur when a new element is inserted into the container. If an element is
+/// removed from the container only entities referring the removed element are
+/// invalidated.
+///
+/// \pre FirstInfoTy and SecondInfoTy should provide at least two methods:
+/// - static unsigned getHashValue(const KeyTy &);
+/// - static bool isEqual(const KeyTy &, const KeyTy &).
+///
+/// \sa Bimap
+template<class FTy, class STy,
+  class FirstInfoTy = llvm::DenseMapInfo<bcl::add_alias_tagged_t<FTy, FTy>>,
+  class SecondInfoTy = llvm::DenseMapInfo<bcl::add_alias_tagged_t<STy, STy>>>
+class FlatBimap {
+  /// Type of this bidirectional map.
+  using Self = FlatBimap<FTy, STy, FirstInfoTy, SecondInfoTy>;
+
+public:
+  /// This tag can be used to access first key in a pair.
+  struct First {};
+
+  /// This tag can be used to access second key in a pair.
+  struct Second {};
+
+private:
+  using Taggeds = bcl::TypeList<bcl::add_alias_tagged<FTy, First>,
+                                bcl::add_alias_tagged<STy, Second>>;
+  using FirstTy = bcl::get_tagged_t<First, Taggeds>;
+  using SecondTy = bcl::get_tagged_t<Second, Taggeds>;
+
+public:
+  using value_type = bcl::tagged_pair<bcl::get_tagged<First, Taggeds>,
+                                      bcl::get_tagged<Second, Taggeds>>;
+  using reference = value_type &;
+  using const_reference = const value_type &;
+  using pointer = value_type *;
+  using const_pointer = const value_type *;
+
+private:
+  using Collection = detail::FlatStorage<value_type>;
+  using FirstIndex = detail::FlatKeyIndex<FirstTy, FirstInfoTy>;
+  using SecondIndex = detail::FlatKeyIndex<SecondTy, SecondInfoTy>;
+
+public:
+  using size_type = typename Collection::size_type;
+  using iterator = typename Collection::iterator;
+  using const_iterator = iterator;
+  using reverse_iterator = typename Collection::reverse_iterator;
+  using const_reverse_iterator = reverse_iterator;
+
+  /// Default constructor.
+  FlatBimap() = default;
+
+  /// Constructs the container with the contents of the range [I, EI).
+  template<class Itr> FlatBimap(Itr I, Itr EI) {
+    insert(I, EI);
+  }
+
+  /// Constructs the container with the contents of the initializer list.
+  FlatBimap(std::initializer_list<value_type> List) {
+    insert(List);
+  }
+
+  /// Replaces the contents with those identified by initializer list.
+  FlatBimap & operator=(std::initializer_list<value_type> List) {
+    clear();
+    insert(List);
+    return *this;
+  }
+
+  /// \brief Returns an iterator to the first element of the container.
+  ///
+  /// If the container is empty, the returned iterator will be equal to end().
+  iterator begin() const { return mColl.begin(); }
+
+  /// \brief Returns an iterator to the element following the last element of
+  /// the container.
+  iterator end() const { return mColl.end(); }
+
+  /// Returns an iterator to the first element of the container.
+  iterator cbegin() const { return begin(); }
+
+  /// Returns an iterator to the element following the last element of
+  /// the container.
+  iterator cend() const { return end(); }
+
+  /// Returns a reverse iterator to the first element of the reversed
+  /// container.
+  reverse_iterator rbegin() const { return reverse_iterator(end()); }
+
+  /// Returns a reverse iterator to the element following the last
+  /// element of the reversed container.
+  reverse_iterator rend() const { return reverse_iterator(begin()); }
+
+  /// Returns a reverse iterator to the first element of the reversed
+  /// container.
+  reverse_iterator crbegin() const { return rbegin(); }
+
+  /// Returns a reverse iterator to the element following the last
+  /// element of the reversed container.
+  reverse_iterator crend() const { return rend(); }
+
+  /// Returns true if the container has no elements.
+  bool empty() const { return mColl.empty(); }
+
+  /// Returns the number of elements in the container.
+  size_type size() const { return mColl.size(); }
+
+  /// Reserves space for a specified number of elements.
+  void reserve(size_type Size) {
+    mColl.reserve(Size);
+    mFirstIndex.reserve(Size);
+    mSecondIndex.reserve(Size);
+  }
+
+  /// Removes all elements from the container.
+  void clear() {
+    mFirstIndex.clear();
+    mSecondIndex.clear();
+    mColl.clear();
+  }
+
+  /// Exchanges the contents of the container with those of other.
+  void swap(Self &Other) {
+    mColl.swap(Other.mColl);
+    mFirstIndex.swap(Other.mFirstIndex);
+    mSecondIndex.swap(Other.mSecondIndex);
+  }
+
+  /// \brief Inserts element into the container, if the container doesn't
+  /// already contain an element with an equivalent key.
+  ///
+  /// \return Returns a pair consisting of an iterator to the inserted element
+  /// (or to the element that prevented the insertion) and a bool denoting
+  /// whether the insertion took place.
+  template<typename Pair,
+    typename = typename std::enable_if<
+      std::is_constructible<value_type, Pair&&>::value>::type>
+  std::pair<iterator, bool> insert(Pair&& Val) {
+    return insertValue(value_type(std::forward<Pair>(Val)));
+  }
+
+  /// Inserts copies of the elements in the initializer list to the container.
+  void insert(std::initializer_list<value_type> List) {
+    for (auto &Val : List)
+      insert(Val);
+  }
+
+  /// Inserts elements from range [I, EI).
+  template<class Itr>  void insert(Itr I, Itr EI) {
+    for ( ; I != EI; ++I)
+      insert(*I);
+  }
+
+  /// Inserts a new element into the container by constructing it in-place with
+  /// the given Args if there is no element with the key in the container.
+  template<typename... ArgTy>
+  std::pair<iterator, bool> emplace(ArgTy&&... Args) {
+    return insertValue(value_type(std::forward<ArgTy>(Args)...));
+  }
+
+  /// Finds an element with first key equivalent to First.
+  iterator find_first(const FirstTy &First) const {
+    auto Pos{mFirstIndex.lookup(First, isFirstAt(First))};
+    return Pos == FirstIndex::InvalidPos ? end() : mColl.getIterator(Pos);
+  }
+
+  /// Finds an element with second key equivalent to Second.
+  iterator find_second(const SecondTy &Second) const {
+    auto Pos{mSecondIndex.lookup(Second, isSecondAt(Second))};
+    return Pos == SecondIndex::InvalidPos ? end() : mColl.getIterator(Pos);
+  }
+
+  /// Finds an element with a key Tag equivalent to Key.
+  template<class Tag,
+    class = typename std::enable_if<
+      !std::is_void<bcl::get_tagged<Tag, Taggeds>>::value>::type>
+  iterator find(const bcl::get_tagged_t<Tag, Taggeds> &Key) const {
+    return taggedFindImp(
+      Key, std::is_same<
+        bcl::get_tagged<First, Taggeds>, bcl::get_tagged<Tag, Taggeds>>());
+  }
+
+  /// \brief Removes specified element from the container.
+  ///
+  /// \return Iterator following the removed element.
+  iterator erase(iterator I) {
+    assert(I != end() && "Iterator must refer element in the container!");
+    auto Pos{I.getPosition()};
+    ++I;
+    mFirstIndex.erase(mColl[Pos].first, Pos);
+    mSecondIndex.erase(mColl[Pos].second, Pos);
+    mColl.erase(Pos);
+    return I;
+  }
+
+  /// \brief Removes the elements in the range [I; EI), which must be
+  /// a valid range in *this.
+  ///
+  /// \return Iterator following the last removed element.
+  iterator erase(iterator I, iterator EI) {
+    while (I != EI)
+      I = erase(I);
+    return EI;
+  }
+
+  /// \brief Removes the element (if one exists) with the first key equivalent
+  /// to First.
+  ///
+  /// \return True if the element has been found and removed.
+  bool erase_first(const FirstTy &First) {
+    auto I{find_first(First)};
+    if (I == end())
+      return false;
+    erase(I);
+    return true;
+  }
+
+  /// \brief Removes the element (if one exists) with the second key equivalent
+  /// to Second.
+  ///
+  /// \return True if the element has been found and removed.
+  bool erase_second(const SecondTy &Second) {
+    auto I{find_second(Second)};
+    if (I == end())
+      return false;
+    erase(I);
+    return true;
+  }
+
+  /// \brief Removes the element (if one exists) with the key Tag equivalent to
+  /// Key.
+  ///
+  /// \return True if the element has been found and removed.
+  template<class Tag,
+    class = typename std::enable_if<
+      !std::is_void<bcl::get_tagged<Tag, Taggeds>>::value>::type>
+  bool erase(const bcl::get_tagged_t<Tag, Taggeds> &Key) {
+    return taggedEraseImp(
+      Key, std::is_same<
+        bcl::get_tagged<First, Taggeds>, bcl::get_tagged<Tag, Taggeds>>());
+  }
+
+private:
+  /// \brief Finds element with key equivalent to some of specified keys
+  /// (first or second).
+  ///
+  /// \return A pair comprises iterator referring element that has been found
+  /// and FALSE (if an element HAS BEEN found).
+  std::pair<iterator, bool> lookup(const value_type &Val) const {
+    auto I = find_first(Val.first);
+    if (I != end())
+      return std::make_pair(I, false);
+    I = find_second(Val.second);
+    if (I != end())
+      return std::make_pair(I, false);
+    return std::make_pair(end(), true);
+  }
+
+  /// Inserts a specified value if there is no element with the same keys.
+  std::pair<iterator, bool> insertValue(value_type &&Val) {
+    auto Res = lookup(Val);
+    if (!Res.second)
+      return Res;
+    if (mColl.needsCompaction()) {
+      mColl.compact();
+      mFirstIndex.clear();
+      mSecondIndex.clear();
+      for (auto I = begin(), EI = end(); I != EI; ++I)
+        insertKeys(I.getPosition());
+    }
+    auto Pos{mColl.push_back(std::move(Val))};
+    insertKeys(Pos);
+    return std::make_pair(mColl.getIterator(Pos), true);
+  }
+
+  /// Inserts keys from an element at a specified position into indexes.
+  void insertKeys(unsigned Pos) {
+    auto &Val{mColl[Pos]};
+    mFirstIndex.insert(Val.first, Pos, isFirstAt(Val.first));
+    mSecondIndex.insert(Val.second, Pos, isSecondAt(Val.second));
+  }
+
+  /// Returns a functor which checks whether the first key of an element at
+  /// a specified position is equivalent to Key.
+  auto isFirstAt(const FirstTy &Key) const {
+    return [this, &Key](unsigned Pos) {
+      return FirstInfoTy::isEqual(mColl[Pos].first, Key);
+    };
+  }
+
+  /// Returns a functor which checks whether the second key of an element at
+  /// a specified position is equivalent to Key.
+  auto isSecondAt(const SecondTy &Key) const {
+    return [this, &Key](unsigned Pos) {
+      return SecondInfoTy::isEqual(mColl[Pos].second, Key);
+    };
+  }
+
+  /// Overloaded method. Finds an element with first key equivalent to key.
+  iterator taggedFindImp(const FirstTy &Key, std::true_type) const {
+    return find_first(Key);
+  }
+
+  /// Overloaded method. Finds an element with second key equivalent to key.
+  iterator taggedFindImp(const SecondTy &Key, std::false_type) const {
+    return find_second(Key);
+  }
+
+  /// Overloaded method. Removes an element with the specified first key.
+  bool taggedEraseImp(const FirstTy &Key, std::true_type) {
+    return erase_first(Key);
+  }
+
+  /// Overloaded method. Removes an element with the specified second key.
+  bool taggedEraseImp(const SecondTy &Key, std::false_type) {
+    return erase_second(Key);
+  }
+
+  Collection mColl;
+  FirstIndex mFirstIndex;
+  SecondIndex mSecondIndex;
+};
+}
+
+namespace std {
+/// Specializes the std::swap algorithm for tsar::FlatBimap.
+template<class FirstTy, class SecondTy, class FirstInfoTy, class SecondInfoTy>
+inline void swap(
+    tsar::FlatBimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &LHS,
+    tsar::FlatBimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &RHS) {
+  LHS.swap(RHS);
+}
+
+/// Compares the contents of two bidirectional maps.
+template<class FirstTy, class SecondTy, class FirstInfoTy, class SecondInfoTy>
+bool operator==(
+    const tsar::FlatBimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &LHS,
+    const tsar::FlatBimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &RHS) {
+  if (&LHS == &RHS)
+    return true;
+  auto LHSItr = LHS.begin(), LHSEndItr = LHS.end();
+  auto RHSItr = RHS.begin(), RHSEndItr = RHS.end();
+  for (; LHSItr != LHSEndItr && RHSItr != RHSEndItr; ++LHSItr, ++RHSItr)
+    if (LHSItr->first != RHSItr->first || LHSItr->second != RHSItr->second)
+      return false;
+  if (LHSItr != LHSEndItr || RHSItr != RHSEndItr)
+    return false;
+  return true;
+}
+
+/// Compares the contents of two bidirectional maps.
+template<class FirstTy, class SecondTy, class FirstInfoTy, class SecondInfoTy>
+bool operator!=(
+    const tsar::FlatBimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &LHS,
+    const tsar::FlatBimap<FirstTy, SecondTy, FirstInfoTy, SecondInfoTy> &RHS) {
+  return !operator==(LHS, RHS);
+}
+}
+#endif//TSAR_FLAT_BIMAP_H
@@ -0,0 +1,231 @@
+//===- FlatKeyIndex.h ---- Flat Index Of Keys -------------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements an open addressing hash index which maps keys to
+// positions of elements in an external storage. Keys are not copied into
+// the index, so it can be used by containers which own their elements.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_FLAT_KEY_INDEX_H
+#define TSAR_FLAT_KEY_INDEX_H
+
+#include <llvm/Support/MathExtras.h>
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+namespace tsar {
+namespace detail {
+/// \brief Open addressing hash index which maps keys to positions of elements
+/// in a flat storage.
+///
+/// Each entry of the index contains a hash value of a key and a position of
+/// an element which contains this key, so entries are small and keys are not
+/// copied. An element is accessed only if a hash value of a key in an entry
+/// matches a hash value of a requested key. A special value of a position marks
+/// empty and removed entries, hence there is no need to reserve special values
+/// of keys (like llvm::DenseMapInfo::getEmptyKey()).
+///
+/// \pre KeyInfoTy should provide the method
+/// static unsigned getHashValue(const KeyTy &).
+template<class KeyTy, class KeyInfoTy>
+class FlatKeyIndex {
+  static constexpr unsigned EmptyPos = ~0u;
+  static constexpr unsigned TombstonePos = ~0u - 1;
+  static constexpr std::size_t MinCapacity = 16;
+
+  struct Entry {
+    unsigned Hash = 0;
+    unsigned Pos = EmptyPos;
+  };
+
+public:
+  /// This position is returned if a key is not found.
+  static constexpr unsigned InvalidPos = EmptyPos;
+
+  FlatKeyIndex() = default;
+  FlatKeyIndex(const FlatKeyIndex &) = default;
+  FlatKeyIndex & operator=(const FlatKeyIndex &) = default;
+
+  /// Moves keys from a specified index, the specified index becomes empty.
+  FlatKeyIndex(FlatKeyIndex &&Other) { swap(Other); }
+
+  /// Moves keys from a specified index, the specified index becomes empty.
+  FlatKeyIndex & operator=(FlatKeyIndex &&Other) {
+    FlatKeyIndex Tmp(std::move(Other));
+    swap(Tmp);
+    return *this;
+  }
+
+  /// Return number of keys in the index.
+  std::size_t size() const noexcept { return mNumEntries; }
+
+  /// Remove all keys from the index, the capacity is not changed.
+  void clear() {
+    if (mNumEntries == 0 && mNumTombstones == 0)
+      return;
+    std::fill(mEntries.begin(), mEntries.end(), Entry());
+    mNumEntries = mNumTombstones = 0;
+  }
+
+  /// Ensure that a specified number of keys can be inserted without rehashing.
+  void reserve(std::size_t NumEntries) {
+    auto Capacity{MinCapacity};
+    while (NumEntries * 4 >= Capacity * 3)
+      Capacity *= 2;
+    if (Capacity > mEntries.size())
+      rehash(Capacity);
+  }
+
+  /// \brief Return position of an element with a specified key or InvalidPos.
+  ///
+  /// The IsEqual(Pos) functor checks whether an element at a specified
+  /// position contains the key. A type of the key may differ from KeyTy
+  /// if KeyInfoTy provides an appropriate getHashValue() method.
+  template<class LookupKeyTy, class EqualFn>
+  unsigned lookup(const LookupKeyTy &Key, EqualFn &&IsEqual) const {
+    if (mNumEntries == 0)
+      return InvalidPos;
+    auto Hash{KeyInfoTy::getHashValue(Key)};
+    auto Mask{mEntries.size() - 1};
+    for (auto Idx{getHomeIdx(Hash)};; Idx = (Idx + 1) & Mask) {
+      auto &E{mEntries[Idx]};
+      if (E.Pos == EmptyPos)
+        return InvalidPos;
+      if (E.Pos != TombstonePos && E.Hash == Hash && IsEqual(E.Pos))
+        return E.Pos;
+    }
+  }
+
+  /// \brief Insert a key if it is not presented in the index.
+  ///
+  /// The IsEqual(Pos) functor checks whether an element at a specified
+  /// position contains the key.
+  /// \return False if a key is already presented in the index.
+  template<class EqualFn>
+  bool insert(const KeyTy &Key, unsigned Pos, EqualFn &&IsEqual) {
+    assert(Pos < TombstonePos && "Position is out of range!");
+    grow();
+    auto Hash{KeyInfoTy::getHashValue(Key)};
+    auto Mask{mEntries.size() - 1};
+    auto TombstoneIdx{mEntries.size()};
+    for (auto Idx{getHomeIdx(Hash)};; Idx = (Idx + 1) & Mask) {
+      auto &E{mEntries[Idx]};
+      if (E.Pos == EmptyPos) {
+        if (TombstoneIdx != mEntries.size()) {
+          Idx = TombstoneIdx;
+          --mNumTombstones;
+        }
+        mEntries[Idx].Hash = Hash;
+        mEntries[Idx].Pos = Pos;
+        ++mNumEntries;
+        return true;
+      }
+      if (E.Pos == TombstonePos) {
+        if (TombstoneIdx == mEntries.size())
+          TombstoneIdx = Idx;
+      } else if (E.Hash == Hash && IsEqual(E.Pos)) {
+        return false;
+      }
+    }
+  }
+
+  /// Remove a key which is mapped to a specified position.
+  ///
+  /// \return True if a key has been removed.
+  bool erase(const KeyTy &Key, unsigned Pos) {
+    if (mNumEntries == 0)
+      return false;
+    auto Hash{KeyInfoTy::getHashValue(Key)};
+    auto Mask{mEntries.size() - 1};
+    for (auto Idx{getHomeIdx(Hash)};; Idx = (Idx + 1) & Mask) {
+      auto &E{mEntries[Idx]};
+      if (E.Pos == EmptyPos)
+        return false;
+      if (E.Pos == Pos && E.Hash == Hash) {
+        E.Pos = TombstonePos;
+        --mNumEntries;
+        ++mNumTombstones;
+        return true;
+      }
+    }
+  }
+
+  /// Return the approximate size (in bytes) of the index.
+  std::size_t getMemorySize() const noexcept {
+    return mEntries.capacity() * sizeof(Entry);
+  }
+
+  void swap(FlatKeyIndex &Other) {
+    mEntries.swap(Other.mEntries);
+    std::swap(mNumEntries, Other.mNumEntries);
+    std::swap(mNumTombstones, Other.mNumTombstones);
+    std::swap(mShift, Other.mShift);
+  }
+
+private:
+  /// \brief Return index of the first entry in a probe sequence for a key.
+  ///
+  /// Hash values of close keys are often close too (for example, hash values
+  /// of pointers in llvm::DenseMapInfo). Such values form long runs of
+  /// occupied entries which slow down linear probing. So, the hash value
+  /// is scrambled with the Fibonacci hashing and the high bits are used.
+  std::size_t getHomeIdx(unsigned Hash) const {
+    return static_cast<std::size_t>(
+      (static_cast<uint64_t>(Hash) * 0x9E3779B97F4A7C15ull) >> mShift);
+  }
+
+  /// Rehash the index if there may be no empty entries after insertion of
+  /// a new key. The load factor is kept below 3/4 and at least 1/8 of entries
+  /// are empty, so a probe sequence always terminates.
+  void grow() {
+    auto Capacity{mEntries.size()};
+    if ((mNumEntries + 1) * 4 >= Capacity * 3)
+      rehash(std::max(Capacity * 2, MinCapacity));
+    else if (Capacity - (mNumEntries + mNumTombstones + 1) <= Capacity / 8)
+      rehash(Capacity);
+  }
+
+  void rehash(std::size_t Capacity) {
+    std::vector<Entry> Entries(Capacity);
+    Entries.swap(mEntries);
+    mShift = 64 - llvm::Log2_64(Capacity);
+    auto Mask{Capacity - 1};
+    for (auto &E : Entries) {
+      if (E.Pos == EmptyPos || E.Pos == TombstonePos)
+        continue;
+      auto Idx{getHomeIdx(E.Hash)};
+      while (mEntries[Idx].Pos != EmptyPos)
+        Idx = (Idx + 1) & Mask;
+      mEntries[Idx] = E;
+    }
+    mNumTombstones = 0;
+  }
+
+  std::vector<Entry> mEntries;
+  std::size_t mNumEntries = 0;
+  std::size_t mNumTombstones = 0;
+  unsigned mShift = 64;
+};
+}
+}
+#endif//TSAR_FLAT_KEY_INDEX_H
@@ -422,9 +422,7 @@ public:
     auto I = mFirstToSecond.find(First);
     if (I == mFirstToSecond.end())
       return false;
-    auto Node = *I;
-    mFirstToSecond.erase(I);
-    mColl.erase(InternalItr(Node));
+    erase(iterator(I->second));
     return true;
   }
 
@@ -436,9 +434,7 @@ public:
     auto I = mSecondToFirst.find(Second);
     if (I == mSecondToFirst.end())
       return false;
-    auto Node = *I;
-    mSecondToFirst.erase(I);
-    mColl.erase(InternalItr(Node));
+    erase(iterator(I->second));
     return true;
   }
 
@@ -0,0 +1,316 @@
+//===- PersistentSlab.h --- Slab Of Persistent Buckets ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a chunked slab of buckets and iterators over it.
+// Buckets are never moved, so a persistent reference to a bucket is a slot
+// index in the slab which is not updated when a container changes.
+// SlabPersistentMap and SlabPersistentSet are built on top of it.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_PERSISTENT_SLAB_H
+#define TSAR_PERSISTENT_SLAB_H
+
+#include <llvm/ADT/DenseMapInfo.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace tsar {
+namespace detail {
+/// \brief Chunked slab of buckets which are addressed by slot indexes.
+///
+/// Memory is allocated by chunks of a fixed size and chunks are never
+/// reallocated, so buckets are not moved while the slab grows. Each slot has
+/// a stamp which is odd for an occupied slot and which is incremented
+/// whenever a bucket is placed into or removed from the slot. A persistent
+/// reference remembers a slot and a stamp, so it detects removal of
+/// a referenced bucket even if the slot has been reused.
+///
+/// The slab manages raw memory only. An owner constructs and destroys buckets.
+/// The slab is reference counted: persistent references keep it alive, so
+/// they may be safely checked after the owner has been destroyed.
+template<class BucketT>
+class PersistentSlab : public llvm::RefCountedBase<PersistentSlab<BucketT>> {
+  static constexpr unsigned ChunkShift = 8;
+  static constexpr unsigned ChunkSize = 1u << ChunkShift;
+  static constexpr unsigned ChunkMask = ChunkSize - 1;
+
+  using StorageT =
+    typename std::aligned_storage<sizeof(BucketT), alignof(BucketT)>::type;
+  using ChunkT = std::unique_ptr<StorageT[]>;
+
+public:
+  /// This slot does not refer to any bucket.
+  static constexpr unsigned InvalidSlot = ~0u;
+
+  /// Return number of occupied slots.
+  unsigned size() const noexcept { return mSize; }
+
+  /// Return number of slots including free ones.
+  unsigned capacity() const noexcept {
+    return static_cast<unsigned>(mStamps.size());
+  }
+
+  /// Return stamp of a slot or 0 if there is no such slot.
+  unsigned getStamp(unsigned Slot) const noexcept {
+    return Slot < mStamps.size() ? mStamps[Slot] : 0;
+  }
+
+  /// Return true if a specified slot is occupied.
+  bool isOccupied(unsigned Slot) const noexcept {
+    return getStamp(Slot) & 1u;
+  }
+
+  /// Return memory for a bucket in a specified slot.
+  BucketT *getBucket(unsigned Slot) const noexcept {
+    assert(Slot < mStamps.size() && "Slot is out of range!");
+    return reinterpret_cast<BucketT *>(
+      &mChunks[Slot >> ChunkShift][Slot & ChunkMask]);
+  }
+
+  /// Return the first occupied slot starting from a specified one or
+  /// capacity() if there is no such slot.
+  unsigned skipFree(unsigned Slot) const noexcept {
+    for (auto E{capacity()}; Slot < E; ++Slot)
+      if (mStamps[Slot] & 1u)
+        return Slot;
+    return capacity();
+  }
+
+  /// Mark a free slot as occupied and return it. A bucket should be
+  /// constructed in the slot after that.
+  unsigned allocate() {
+    unsigned Slot;
+    if (!mFreeSlots.empty()) {
+      Slot = mFreeSlots.back();
+      mFreeSlots.pop_back();
+    } else {
+      Slot = capacity();
+      mStamps.push_back(0);
+    }
+    // Chunks may be released by shrink(), so they are allocated on demand.
+    while ((Slot >> ChunkShift) >= mChunks.size())
+      mChunks.emplace_back(new StorageT[ChunkSize]);
+    assert(!isOccupied(Slot) && "Slot must be free!");
+    ++mStamps[Slot];
+    ++mSize;
+    return Slot;
+  }
+
+  /// Mark an occupied slot as free. A bucket should be destroyed before that.
+  void release(unsigned Slot) {
+    assert(isOccupied(Slot) && "Slot must be occupied!");
+    ++mStamps[Slot];
+    --mSize;
+    mFreeSlots.push_back(Slot);
+  }
+
+  /// Ensure that a specified number of slots can be occupied without
+  /// reallocation of internal arrays.
+  void reserve(unsigned NumSlots) {
+    if (NumSlots <= capacity())
+      return;
+    mStamps.reserve(NumSlots);
+    mChunks.reserve((NumSlots + ChunkMask) >> ChunkShift);
+  }
+
+  /// Release memory of chunks. All slots must be free.
+  ///
+  /// Stamps are kept, so persistent references to removed buckets will not
+  /// become valid after the slab has been filled again.
+  void shrink() {
+    assert(mSize == 0 && "All slots must be free!");
+    mChunks.clear();
+    mFreeSlots.clear();
+    for (auto I{capacity()}; I > 0; --I)
+      mFreeSlots.push_back(I - 1);
+  }
+
+  /// Make free slots be occupied in an ascending order.
+  void sortFreeSlots() {
+    std::sort(mFreeSlots.begin(), mFreeSlots.end(), std::greater<unsigned>());
+  }
+
+  /// Return the approximate size (in bytes) of the slab.
+  std::size_t getMemorySize() const noexcept {
+    return mChunks.size() * ChunkSize * sizeof(StorageT) +
+           mStamps.capacity() * sizeof(unsigned) +
+           mFreeSlots.capacity() * sizeof(unsigned);
+  }
+
+private:
+  std::vector<ChunkT> mChunks;
+  std::vector<unsigned> mStamps;
+  std::vector<unsigned> mFreeSlots;
+  unsigned mSize = 0;
+};
+}
+
+/// \brief This class is used to iterate over all buckets in a slab-based
+/// persistent container.
+///
+/// Unlike iterators of NotPersistentIterator, it is not invalidated when
+/// a new bucket is inserted into the container. However, it may be
+/// invalidated on removal and it does not see buckets which are inserted
+/// into slots after the current one. It can be converted to a persistent
+/// iterator.
+template<bool IsConst, class BucketT>
+class SlabIterator {
+  template<bool, class> friend class SlabIterator;
+  template<bool, class> friend class SlabPersistentIterator;
+  using SlabT = detail::PersistentSlab<BucketT>;
+public:
+  using difference_type = std::ptrdiff_t;
+  using value_type =
+    typename std::conditional<IsConst, const BucketT, BucketT>::type;
+  using pointer = value_type *;
+  using reference = value_type &;
+  using iterator_category = std::forward_iterator_tag;
+
+  SlabIterator() = default;
+
+  SlabIterator(SlabT *Slab, unsigned Slot) : mSlab(Slab), mSlot(Slot) {}
+
+  template<bool IsConstSrc,
+    class = typename std::enable_if<!IsConstSrc && IsConst>::type>
+  SlabIterator(const SlabIterator<IsConstSrc, BucketT> &Itr) :
+    mSlab(Itr.mSlab), mSlot(Itr.mSlot) {}
+
+  reference operator*() const {
+    assert(mSlab && mSlab->isOccupied(mSlot) &&
+      "Dereference of invalid iterator!");
+    return *mSlab->getBucket(mSlot);
+  }
+  pointer operator->() const { return &operator*(); }
+
+  bool operator==(const SlabIterator<true, BucketT> &RHS) const {
+    return mSlot == RHS.mSlot && mSlab == RHS.mSlab;
+  }
+  bool operator!=(const SlabIterator<true, BucketT> &RHS) const {
+    return !operator==(RHS);
+  }
+
+  SlabIterator & operator++() {
+    mSlot = mSlab->skipFree(mSlot + 1);
+    return *this;
+  }
+  SlabIterator operator++(int) {
+    auto Tmp = *this; ++*this; return Tmp;
+  }
+
+  /// Return slot of a bucket this iterator points to.
+  unsigned getSlot() const noexcept { return mSlot; }
+
+private:
+  SlabT *mSlab = nullptr;
+  unsigned mSlot = 0;
+};
+
+/// \brief This is persistent iterator which remains valid when insertion
+/// into a slab-based persistent container occurs.
+///
+/// The iterator stores a slot index and a stamp of this slot, so insertions
+/// and rehashing of a container never access persistent iterators. The
+/// iterator is invalidated on removal of the bucket it points to and on
+/// destruction of the container. It can not be used to traverse over
+/// buckets. It can be implicitly constructed from a SlabIterator.
+template<bool IsConst, class BucketT>
+class SlabPersistentIterator {
+  template<bool, class> friend class SlabPersistentIterator;
+  friend struct llvm::DenseMapInfo<SlabPersistentIterator>;
+  using SlabT = detail::PersistentSlab<BucketT>;
+public:
+  using value_type =
+    typename std::conditional<IsConst, const BucketT, BucketT>::type;
+  using pointer = value_type *;
+  using reference = value_type &;
+
+  SlabPersistentIterator() = default;
+
+  /// Creates persistent iterator which points to a specified bucket.
+  /// Note, that source iterator should not be result of end().
+  template<bool IsConstSrc,
+    class = typename std::enable_if<!IsConstSrc || IsConst>::type>
+  SlabPersistentIterator(const SlabIterator<IsConstSrc, BucketT> &Itr) :
+      mSlab(Itr.mSlab), mSlot(Itr.mSlot), mStamp(Itr.mSlab->getStamp(mSlot)) {
+    assert(isValid() && "Iterator must point to a bucket!");
+  }
+
+  template<bool IsConstSrc,
+    class = typename std::enable_if<!IsConstSrc && IsConst>::type>
+  SlabPersistentIterator(
+      const SlabPersistentIterator<IsConstSrc, BucketT> &Itr) :
+    mSlab(Itr.mSlab), mSlot(Itr.mSlot), mStamp(Itr.mStamp) {}
+
+  reference operator*() const {
+    assert(isValid() && "Dereference of invalid persistent iterator!");
+    return *mSlab->getBucket(mSlot);
+  }
+
+  pointer operator->() const { return &operator*(); }
+
+  bool operator==(const SlabPersistentIterator &RHS) const {
+    return mSlot == RHS.mSlot && mStamp == RHS.mStamp && mSlab == RHS.mSlab;
+  }
+
+  bool operator!=(const SlabPersistentIterator &RHS) const {
+    return !operator==(RHS);
+  }
+
+  bool isValid() const noexcept {
+    return mSlab && mSlab->getStamp(mSlot) == mStamp;
+  }
+  operator bool () const noexcept { return isValid(); }
+
+  /// Return slot of a bucket this iterator points to.
+  unsigned getSlot() const noexcept { return mSlot; }
+
+private:
+  /// Creates a special iterator which does not point to any bucket.
+  explicit SlabPersistentIterator(unsigned Slot) : mSlot(Slot) {}
+
+  llvm::IntrusiveRefCntPtr<SlabT> mSlab;
+  unsigned mSlot = SlabT::InvalidSlot;
+  unsigned mStamp = 0;
+};
+}
+
+namespace llvm {
+template<bool IsConst, class BucketT>
+struct DenseMapInfo<tsar::SlabPersistentIterator<IsConst, BucketT>> {
+  using Iterator = tsar::SlabPersistentIterator<IsConst, BucketT>;
+  static inline Iterator getEmptyKey() { return Iterator(~0u - 1); }
+  static inline Iterator getTombstoneKey() { return Iterator(~0u - 2); }
+  static unsigned getHashValue(const Iterator &Val) {
+    return DenseMapInfo<std::pair<const void *, unsigned>>::getHashValue(
+      std::make_pair(Val.mSlab.get(), Val.mSlot));
+  }
+  static bool isEqual(const Iterator &LHS, const Iterator &RHS) {
+    return LHS == RHS;
+  }
+};
+}
+#endif//TSAR_PERSISTENT_SLAB_H
@@ -0,0 +1,423 @@
+//===- SlabPersistentMap.h - Slab-Based Persistent Map ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a persistent map with the same interface as
+// PersistentMap. However, buckets are stored in a chunked slab and are never
+// moved, so persistent iterators are slot indexes which are not updated when
+// the map grows.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_SLAB_PERSISTENT_MAP_H
+#define TSAR_SLAB_PERSISTENT_MAP_H
+
+#include "tsar/ADT/FlatKeyIndex.h"
+#include "tsar/ADT/PersistentSlab.h"
+#include <llvm/ADT/DenseMap.h>
+
+namespace tsar {
+/// \brief This map is similar to `llvm::DenseMap` but it also provides
+/// persistent iterators which are not invalidated while the map changes.
+///
+/// This map has the same interface as PersistentMap. However, PersistentMap
+/// attaches a list of persistent references to each bucket and patches these
+/// lists whenever buckets are moved. This map stores buckets in a chunked slab
+/// where they are never moved, and an open addressing index maps keys to slots
+/// in the slab. So, persistent iterators are not accessed on insertion, on
+/// rehashing and on removal of other buckets.
+///
+/// This class provides iterators of two kinds:
+/// - General iterator which iterates over buckets in the order of slots.
+/// - Persistent iterator which is never invalidated (except removal appropriate
+/// element from the map). However, it can not be used to iterate over
+/// buckets. It can be implicitly constructed from a general iterator.
+///
+/// Note, that special keys (llvm::DenseMapInfo::getEmptyKey() and
+/// getTombstoneKey()) are not used, so they may be inserted into the map.
+///
+/// \pre BucketT should provide getFirst() and getSecond() methods to access
+/// a key and a value correspondingly. They are constructed and destroyed
+/// separately as in `llvm::DenseMap`.
+template<class KeyT, class ValueT,
+  class KeyInfoT = llvm::DenseMapInfo<KeyT>,
+  class BucketT = llvm::detail::DenseMapPair<KeyT, ValueT>>
+class SlabPersistentMap {
+  using SlabT = detail::PersistentSlab<BucketT>;
+  using IndexT = detail::FlatKeyIndex<KeyT, KeyInfoT>;
+
+public:
+  using size_type = unsigned;
+  using key_type = KeyT;
+  using mapped_type = ValueT;
+  using value_type = BucketT;
+
+  using iterator = SlabIterator<false, BucketT>;
+  using const_iterator = SlabIterator<true, BucketT>;
+
+  using persistent_iterator = SlabPersistentIterator<false, BucketT>;
+  using const_persistent_iterator = SlabPersistentIterator<true, BucketT>;
+
+  /// Destroys all buckets, all persistent iterators become invalid.
+  ~SlabPersistentMap() { destroyAll(); }
+
+  /// Creates a copy of a specified map, persistent iterators still point into
+  /// the original map.
+  SlabPersistentMap(const SlabPersistentMap &Other) { copyFrom(Other); }
+
+  /// Creates a copy of a specified map, persistent iterators still point into
+  /// the original map.
+  SlabPersistentMap & operator=(const SlabPersistentMap &Other) {
+    if (this != &Other)
+      copyFrom(Other);
+    return *this;
+  }
+
+  /// Moves buckets from a specified map, persistent iterators follow them.
+  SlabPersistentMap(SlabPersistentMap &&Other) :
+    mSlab(std::move(Other.mSlab)), mIndex(std::move(Other.mIndex)) {}
+
+  /// Moves buckets from a specified map, persistent iterators follow them.
+  SlabPersistentMap & operator=(SlabPersistentMap &&Other) {
+    if (this != &Other) {
+      destroyAll();
+      mSlab = std::move(Other.mSlab);
+      mIndex = std::move(Other.mIndex);
+    }
+    return *this;
+  }
+
+  /// Creates a map with an optional \p InitialReserve that guarantee
+  /// that this number of elements can be inserted in the map without grow()
+  explicit SlabPersistentMap(unsigned InitialReserve = 0) {
+    init(InitialReserve);
+  }
+
+  /// Creates a map from a range of pairs.
+  template<typename InputIt>
+  SlabPersistentMap(const InputIt &I, const InputIt &E) {
+    init(std::distance(I, E));
+    insert(I, E);
+  }
+
+  /// Returns iterator that points at the beginning of this map.
+  iterator begin() {
+    return mSlab ? iterator(mSlab.get(), mSlab->skipFree(0)) : end();
+  }
+
+  /// Returns iterator that points at the beginning of this map.
+  const_iterator begin() const {
+    return const_cast<SlabPersistentMap *>(this)->begin();
+  }
+
+  /// Returns iterator that points at the ending of this map.
+  iterator end() {
+    return mSlab ? iterator(mSlab.get(), mSlab->capacity()) : iterator();
+  }
+
+  /// Returns iterator that points at the ending of this map.
+  const_iterator end() const {
+    return const_cast<SlabPersistentMap *>(this)->end();
+  }
+
+  /// Returns true if there are not buckets in the map.
+  bool empty() const { return size() == 0; }
+
+  /// Returns number of buckets in the map.
+  unsigned size() const { return mSlab ? mSlab->size() : 0; }
+
+  /// Clears the map. All persistent iterators become invalid.
+  void clear() {
+    if (!mSlab)
+      return;
+    destroyBuckets();
+    mSlab->sortFreeSlots();
+    mIndex.clear();
+  }
+
+  /// Return 1 if the specified key is in the map, 0 otherwise.
+  size_type count(const KeyT &Key) const {
+    return lookupSlot(Key) != SlabT::InvalidSlot ? 1 : 0;
+  }
+
+  /// Finds a key,value pair with a specified key.
+  iterator find(const KeyT &Key) { return find_as(Key); }
+
+  /// Finds a key,value pair with a specified key.
+  const_iterator find(const KeyT &Key) const { return find_as(Key); }
+
+  /// \brief Alternate version of find() which allows a different, and possibly
+  /// less expensive, key type.
+  ///
+  /// The DenseMapInfo is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key
+  /// type used.
+  template<class LookupKeyT>
+  iterator find_as(const LookupKeyT &Key) {
+    auto Slot{lookupSlot(Key)};
+    return Slot == SlabT::InvalidSlot ? end() : iterator(mSlab.get(), Slot);
+  }
+
+  /// \brief Alternate version of find() which allows a different, and possibly
+  /// less expensive, key type.
+  ///
+  /// The DenseMapInfo is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key
+  /// type used.
+  template<class LookupKeyT>
+  const_iterator find_as(const LookupKeyT &Key) const {
+    return const_cast<SlabPersistentMap *>(this)->find_as(Key);
+  }
+
+  /// Return the entry for the specified key, or a default constructed value if
+  /// no such entry exists.
+  ValueT lookup(const KeyT &Key) const {
+    auto I = find(Key);
+    return (I == end()) ? ValueT() : I->getSecond();
+  }
+
+  /// Swaps two maps, persistent iterators follow their buckets.
+  void swap(SlabPersistentMap &RHS) {
+    std::swap(mSlab, RHS.mSlab);
+    mIndex.swap(RHS.mIndex);
+  }
+
+  /// Creates a copy of a specified map, persistent iterators still point into
+  /// the original map.
+  void copyFrom(const SlabPersistentMap &Other) {
+    clear();
+    init(Other.size());
+    for (auto &B : Other)
+      try_emplace(B.getFirst(), B.getSecond());
+  }
+
+  /// Initializes a map with an \p InitNumEntries that guarantee
+  /// that this number of elements can be inserted in the map without grow().
+  void init(unsigned InitNumEntries) { reserve(InitNumEntries); }
+
+  /// Increases the number of elements which can be inserted in the map without
+  /// reallocation.
+  void grow(unsigned AtLeast) { reserve(AtLeast); }
+
+  /// Grow the map so that it can contain at least \p NumEntries items
+  /// before resizing again.
+  void reserve(size_type NumEntries) {
+    if (NumEntries == 0)
+      return;
+    getOrCreateSlab().reserve(NumEntries);
+    mIndex.reserve(NumEntries);
+  }
+
+  /// Removes all elements and releases memory. All persistent iterators
+  /// become invalid.
+  void shrink_and_clear() {
+    if (!mSlab)
+      return;
+    destroyBuckets();
+    mSlab->shrink();
+    IndexT().swap(mIndex);
+  }
+
+  /// Inserts key,value pair into the map if the key isn't already in the map.
+  /// If the key is already in the map, it returns false and doesn't update the
+  /// value.
+  std::pair<iterator, bool> insert(const std::pair<KeyT, ValueT> &KV) {
+    return try_emplace(KV.first, KV.second);
+  }
+
+  /// Inserts key.value pair into the map if the key isn't already in the map.
+  /// If the key is already in the map, it returns false and doesn't update the
+  /// value.
+  std::pair<iterator, bool> insert(std::pair<KeyT, ValueT> &&KV) {
+    return try_emplace(std::move(KV.first), std::move(KV.second));
+  }
+
+  /// Range insertion of pairs.
+  template<typename InputIt>
+  void insert(InputIt I, InputIt E) {
+    for (; I != E; ++I)
+      insert(*I);
+  }
+
+  /// Inserts key,value pair into the map if the key isn't already in the map.
+  /// The value is constructed in-place if the key is not in the map, otherwise
+  /// it is not moved.
+  template<class... Ts>
+  std::pair<iterator, bool> try_emplace(const KeyT &Key, Ts &&... Args) {
+    auto Slot{lookupSlot(Key)};
+    if (Slot != SlabT::InvalidSlot)
+      return std::make_pair(iterator(mSlab.get(), Slot), false);
+    return std::make_pair(insertBucket(Key, std::forward<Ts>(Args)...), true);
+  }
+
+  /// Inserts key,value pair into the map if the key isn't already in the map.
+  /// The value is constructed in-place if the key is not in the map, otherwise
+  /// it is not moved.
+  template<class... Ts>
+  std::pair<iterator, bool> try_emplace(KeyT &&Key, Ts &&... Args) {
+    auto Slot{lookupSlot(Key)};
+    if (Slot != SlabT::InvalidSlot)
+      return std::make_pair(iterator(mSlab.get(), Slot), false);
+    return std::make_pair(
+      insertBucket(std::move(Key), std::forward<Ts>(Args)...), true);
+  }
+
+  /// Alternate version of insert() which allows a different, and possibly
+  /// less expensive, key type.
+  /// The DenseMapInfo is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key
+  /// type used.
+  template <typename LookupKeyT>
+  std::pair<iterator, bool> insert_as(
+      std::pair<KeyT, ValueT> &&KV, const LookupKeyT &Val) {
+    auto Slot{lookupSlot(Val)};
+    if (Slot != SlabT::InvalidSlot)
+      return std::make_pair(iterator(mSlab.get(), Slot), false);
+    return std::make_pair(
+      insertBucket(std::move(KV.first), std::move(KV.second)), true);
+  }
+
+  /// Erases an element with a specified key if it exists in the map.
+  bool erase(const KeyT &Key) {
+    auto Slot{lookupSlot(Key)};
+    if (Slot == SlabT::InvalidSlot)
+      return false;
+    eraseSlot(Slot);
+    return true;
+  }
+
+  /// Erases an element from the map.
+  void erase(iterator I) { eraseSlot(I.getSlot()); }
+
+  /// Erases an element from the map.
+  void erase(persistent_iterator I) {
+    assert(I && "Persistent iterator must be valid!");
+    eraseSlot(I.getSlot());
+  }
+
+  /// Erases an element from the map.
+  void erase(const_persistent_iterator I) {
+    assert(I && "Persistent iterator must be valid!");
+    eraseSlot(I.getSlot());
+  }
+
+  /// Use default constructor to insert a key,value pair if it is not exist yet.
+  value_type & FindAndConstruct(const KeyT &Key) {
+    return *try_emplace(Key).first;
+  }
+
+  /// Returns value with a specified key.
+  ///
+  /// Use default constructor to insert a key,value pair if it is not exist yet.
+  ValueT & operator[](const KeyT &Key) {
+    return FindAndConstruct(Key).getSecond();
+  }
+
+  /// Use default constructor to insert a key,value pair if it is not exist yet.
+  value_type & FindAndConstruct(KeyT &&Key) {
+    return *try_emplace(std::move(Key)).first;
+  }
+
+  /// Returns value with a specified key.
+  ///
+  /// Use default constructor to insert a key,value pair if it is not exist yet.
+  ValueT & operator[](KeyT &&Key) {
+    return FindAndConstruct(std::move(Key)).getSecond();
+  }
+
+  /// Return the approximate size (in bytes) of the actual map.
+  /// If entries are pointers to objects, the size of the referenced objects
+  /// are not included.
+  std::size_t getMemorySize() const {
+    return (mSlab ? mSlab->getMemorySize() : 0) + mIndex.getMemorySize();
+  }
+
+private:
+  SlabT &getOrCreateSlab() {
+    if (!mSlab)
+      mSlab = new SlabT;
+    return *mSlab;
+  }
+
+  /// Return a slot of a bucket with a specified key or InvalidSlot.
+  template<class LookupKeyT>
+  unsigned lookupSlot(const LookupKeyT &Key) const {
+    if (!mSlab)
+      return SlabT::InvalidSlot;
+    auto Slot{mIndex.lookup(Key, [this, &Key](unsigned Pos) {
+      return KeyInfoT::isEqual(Key, mSlab->getBucket(Pos)->getFirst());
+    })};
+    return Slot == IndexT::InvalidPos ? SlabT::InvalidSlot : Slot;
+  }
+
+  /// Constructs a new bucket, the key must not be presented in the map.
+  template<class KeyArgT, class... Ts>
+  iterator insertBucket(KeyArgT &&Key, Ts &&... Args) {
+    auto &Slab{getOrCreateSlab()};
+    auto Slot{Slab.allocate()};
+    auto *B{Slab.getBucket(Slot)};
+    ::new (&B->getFirst()) KeyT(std::forward<KeyArgT>(Key));
+    ::new (&B->getSecond()) ValueT(std::forward<Ts>(Args)...);
+    mIndex.insert(B->getFirst(), Slot, [](unsigned) { return false; });
+    return iterator(&Slab, Slot);
+  }
+
+  /// Destroys a bucket in a specified slot, its persistent iterators
+  /// become invalid.
+  void eraseSlot(unsigned Slot) {
+    assert(mSlab && mSlab->isOccupied(Slot) && "Bucket must be occupied!");
+    auto *B{mSlab->getBucket(Slot)};
+    mIndex.erase(B->getFirst(), Slot);
+    B->getSecond().~ValueT();
+    B->getFirst().~KeyT();
+    mSlab->release(Slot);
+  }
+
+  /// Destroys all buckets, the index is not updated.
+  void destroyBuckets() {
+    for (auto Slot{mSlab->skipFree(0)}, E{mSlab->capacity()}; Slot < E;
+         Slot = mSlab->skipFree(Slot + 1)) {
+      auto *B{mSlab->getBucket(Slot)};
+      B->getSecond().~ValueT();
+      B->getFirst().~KeyT();
+      mSlab->release(Slot);
+    }
+  }
+
+  /// Destroys all buckets and releases memory which is not referenced from
+  /// persistent iterators.
+  void destroyAll() {
+    if (!mSlab)
+      return;
+    destroyBuckets();
+    mSlab->shrink();
+    mSlab.reset();
+  }
+
+  llvm::IntrusiveRefCntPtr<SlabT> mSlab;
+  IndexT mIndex;
+};
+
+template<typename KeyT, typename ValueT, typename KeyInfoT, typename BucketT>
+static inline std::size_t capacity_in_bytes(
+    const SlabPersistentMap<KeyT, ValueT, KeyInfoT, BucketT> &X) {
+  return X.getMemorySize();
+}
+}
+#endif//TSAR_SLAB_PERSISTENT_MAP_H
@@ -0,0 +1,350 @@
+//===- SlabPersistentSet.h - Slab-Based Persistent Set ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a persistent set with the same interface as
+// PersistentSet. However, values are stored in a chunked slab and are never
+// moved, so persistent iterators are slot indexes which are not updated when
+// the set grows.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_SLAB_PERSISTENT_SET_H
+#define TSAR_SLAB_PERSISTENT_SET_H
+
+#include "tsar/ADT/FlatKeyIndex.h"
+#include "tsar/ADT/PersistentSlab.h"
+
+namespace tsar {
+/// \brief This set is similar to `llvm::DenseSet` but it also provides
+/// persistent iterators which are not invalidated while the set changes.
+///
+/// This set has the same interface as PersistentSet, see SlabPersistentMap
+/// for details about implementation.
+///
+/// This class provides iterators of two kinds:
+/// - General iterator which iterates over values in the order of slots.
+/// - Persistent iterator which is never invalidated (except removal appropriate
+/// element from the set). However, it can not be used to iterate over
+/// values. It can be implicitly constructed from a general iterator.
+template<class ValueT, class ValueInfoT = llvm::DenseMapInfo<ValueT>>
+class SlabPersistentSet {
+  using SlabT = detail::PersistentSlab<ValueT>;
+  using IndexT = detail::FlatKeyIndex<ValueT, ValueInfoT>;
+
+public:
+  using size_type = unsigned;
+  using key_type = ValueT;
+  using value_type = ValueT;
+
+  using iterator = SlabIterator<false, ValueT>;
+  using const_iterator = SlabIterator<true, ValueT>;
+
+  using persistent_iterator = SlabPersistentIterator<false, ValueT>;
+  using const_persistent_iterator = SlabPersistentIterator<true, ValueT>;
+
+  /// Destroys all values, all persistent iterators become invalid.
+  ~SlabPersistentSet() { destroyAll(); }
+
+  /// Creates a copy of a specified set, persistent iterators still point into
+  /// the original set.
+  SlabPersistentSet(const SlabPersistentSet &Other) { copyFrom(Other); }
+
+  /// Creates a copy of a specified set, persistent iterators still point into
+  /// the original set.
+  SlabPersistentSet & operator=(const SlabPersistentSet &Other) {
+    if (this != &Other)
+      copyFrom(Other);
+    return *this;
+  }
+
+  /// Moves values from a specified set, persistent iterators follow them.
+  SlabPersistentSet(SlabPersistentSet &&Other) :
+    mSlab(std::move(Other.mSlab)), mIndex(std::move(Other.mIndex)) {}
+
+  /// Moves values from a specified set, persistent iterators follow them.
+  SlabPersistentSet & operator=(SlabPersistentSet &&Other) {
+    if (this != &Other) {
+      destroyAll();
+      mSlab = std::move(Other.mSlab);
+      mIndex = std::move(Other.mIndex);
+    }
+    return *this;
+  }
+
+  /// Creates a set with an optional \p InitialReserve that guarantee
+  /// that this number of elements can be inserted in the set without grow()
+  explicit SlabPersistentSet(unsigned InitialReserve = 0) {
+    init(InitialReserve);
+  }
+
+  /// Creates a set from a range of values.
+  template<typename InputIt>
+  SlabPersistentSet(const InputIt &I, const InputIt &E) {
+    init(std::distance(I, E));
+    insert(I, E);
+  }
+
+  /// Returns iterator that points at the beginning of this set.
+  iterator begin() {
+    return mSlab ? iterator(mSlab.get(), mSlab->skipFree(0)) : end();
+  }
+
+  /// Returns iterator that points at the beginning of this set.
+  const_iterator begin() const {
+    return const_cast<SlabPersistentSet *>(this)->begin();
+  }
+
+  /// Returns iterator that points at the ending of this set.
+  iterator end() {
+    return mSlab ? iterator(mSlab.get(), mSlab->capacity()) : iterator();
+  }
+
+  /// Returns iterator that points at the ending of this set.
+  const_iterator end() const {
+    return const_cast<SlabPersistentSet *>(this)->end();
+  }
+
+  /// Returns true if there are not values in the set.
+  bool empty() const { return size() == 0; }
+
+  /// Returns number of values in the set.
+  unsigned size() const { return mSlab ? mSlab->size() : 0; }
+
+  /// Clears the set. All persistent iterators become invalid.
+  void clear() {
+    if (!mSlab)
+      return;
+    destroyValues();
+    mSlab->sortFreeSlots();
+    mIndex.clear();
+  }
+
+  /// Return 1 if the specified value is in the set, 0 otherwise.
+  size_type count(const ValueT &V) const {
+    return lookupSlot(V) != SlabT::InvalidSlot ? 1 : 0;
+  }
+
+  /// Finds a specified value.
+  iterator find(const ValueT &V) { return find_as(V); }
+
+  /// Finds a specified value.
+  const_iterator find(const ValueT &V) const { return find_as(V); }
+
+  /// \brief Alternate version of find() which allows a different, and possibly
+  /// less expensive, key type.
+  ///
+  /// The DenseMapInfo is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, ValueT) for each key
+  /// type used.
+  template<class LookupKeyT>
+  iterator find_as(const LookupKeyT &Key) {
+    auto Slot{lookupSlot(Key)};
+    return Slot == SlabT::InvalidSlot ? end() : iterator(mSlab.get(), Slot);
+  }
+
+  /// \brief Alternate version of find() which allows a different, and possibly
+  /// less expensive, key type.
+  ///
+  /// The DenseMapInfo is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, ValueT) for each key
+  /// type used.
+  template<class LookupKeyT>
+  const_iterator find_as(const LookupKeyT &Key) const {
+    return const_cast<SlabPersistentSet *>(this)->find_as(Key);
+  }
+
+  /// Swaps two sets, persistent iterators follow their values.
+  void swap(SlabPersistentSet &RHS) {
+    std::swap(mSlab, RHS.mSlab);
+    mIndex.swap(RHS.mIndex);
+  }
+
+  /// Creates a copy of a specified set, persistent iterators still point into
+  /// the original set.
+  void copyFrom(const SlabPersistentSet &Other) {
+    clear();
+    init(Other.size());
+    for (auto &V : Other)
+      insert(V);
+  }
+
+  /// Initializes a set with an \p InitNumEntries that guarantee
+  /// that this number of elements can be inserted in the set without grow().
+  void init(unsigned InitNumEntries) { reserve(InitNumEntries); }
+
+  /// Increases the number of elements which can be inserted in the set without
+  /// reallocation.
+  void grow(unsigned AtLeast) { reserve(AtLeast); }
+
+  /// Grow the set so that it can contain at least \p NumEntries items
+  /// before resizing again.
+  void reserve(size_type NumEntries) {
+    if (NumEntries == 0)
+      return;
+    getOrCreateSlab().reserve(NumEntries);
+    mIndex.reserve(NumEntries);
+  }
+
+  /// Removes all elements and releases memory. All persistent iterators
+  /// become invalid.
+  void shrink_and_clear() {
+    if (!mSlab)
+      return;
+    destroyValues();
+    mSlab->shrink();
+    IndexT().swap(mIndex);
+  }
+
+  /// Inserts a value into the set if it isn't already in the set.
+  std::pair<iterator, bool> insert(const ValueT &V) { return insert_as(V, V); }
+
+  /// Inserts a value into the set if it isn't already in the set.
+  std::pair<iterator, bool> insert(ValueT &&V) {
+    auto Slot{lookupSlot(V)};
+    if (Slot != SlabT::InvalidSlot)
+      return std::make_pair(iterator(mSlab.get(), Slot), false);
+    return std::make_pair(insertValue(std::move(V)), true);
+  }
+
+  /// Alternate version of insert() which allows a different, and possibly
+  /// less expensive, key type.
+  template <typename LookupKeyT>
+  std::pair<iterator, bool> insert_as(const ValueT &V, const LookupKeyT &Key) {
+    auto Slot{lookupSlot(Key)};
+    if (Slot != SlabT::InvalidSlot)
+      return std::make_pair(iterator(mSlab.get(), Slot), false);
+    return std::make_pair(insertValue(V), true);
+  }
+
+  /// Alternate version of insert() which allows a different, and possibly
+  /// less expensive, key type.
+  template <typename LookupKeyT>
+  std::pair<iterator, bool> insert_as(ValueT &&V, const LookupKeyT &Key) {
+    auto Slot{lookupSlot(Key)};
+    if (Slot != SlabT::InvalidSlot)
+      return std::make_pair(iterator(mSlab.get(), Slot), false);
+    return std::make_pair(insertValue(std::move(V)), true);
+  }
+
+  /// Range insertion of values.
+  template<typename InputIt>
+  void insert(InputIt I, InputIt E) {
+    for (; I != E; ++I)
+      insert(*I);
+  }
+
+  /// Erases a specified value if it exists in the set.
+  bool erase(const ValueT &V) {
+    auto Slot{lookupSlot(V)};
+    if (Slot == SlabT::InvalidSlot)
+      return false;
+    eraseSlot(Slot);
+    return true;
+  }
+
+  /// Erases an element from the set.
+  void erase(iterator I) { eraseSlot(I.getSlot()); }
+
+  /// Erases an element from the set.
+  void erase(persistent_iterator I) {
+    assert(I && "Persistent iterator must be valid!");
+    eraseSlot(I.getSlot());
+  }
+
+  /// Erases an element from the set.
+  void erase(const_persistent_iterator I) {
+    assert(I && "Persistent iterator must be valid!");
+    eraseSlot(I.getSlot());
+  }
+
+  /// Return the approximate size (in bytes) of the actual set.
+  /// If entries are pointers to objects, the size of the referenced objects
+  /// are not included.
+  std::size_t getMemorySize() const {
+    return (mSlab ? mSlab->getMemorySize() : 0) + mIndex.getMemorySize();
+  }
+
+private:
+  SlabT &getOrCreateSlab() {
+    if (!mSlab)
+      mSlab = new SlabT;
+    return *mSlab;
+  }
+
+  /// Return a slot of a specified value or InvalidSlot.
+  template<class LookupKeyT>
+  unsigned lookupSlot(const LookupKeyT &Key) const {
+    if (!mSlab)
+      return SlabT::InvalidSlot;
+    auto Slot{mIndex.lookup(Key, [this, &Key](unsigned Pos) {
+      return ValueInfoT::isEqual(Key, *mSlab->getBucket(Pos));
+    })};
+    return Slot == IndexT::InvalidPos ? SlabT::InvalidSlot : Slot;
+  }
+
+  /// Constructs a new value, it must not be presented in the set.
+  template<class ArgT> iterator insertValue(ArgT &&V) {
+    auto &Slab{getOrCreateSlab()};
+    auto Slot{Slab.allocate()};
+    auto *B{::new (Slab.getBucket(Slot)) ValueT(std::forward<ArgT>(V))};
+    mIndex.insert(*B, Slot, [](unsigned) { return false; });
+    return iterator(&Slab, Slot);
+  }
+
+  /// Destroys a value in a specified slot, its persistent iterators
+  /// become invalid.
+  void eraseSlot(unsigned Slot) {
+    assert(mSlab && mSlab->isOccupied(Slot) && "Value must be occupied!");
+    auto *B{mSlab->getBucket(Slot)};
+    mIndex.erase(*B, Slot);
+    B->~ValueT();
+    mSlab->release(Slot);
+  }
+
+  /// Destroys all values, the index is not updated.
+  void destroyValues() {
+    for (auto Slot{mSlab->skipFree(0)}, E{mSlab->capacity()}; Slot < E;
+         Slot = mSlab->skipFree(Slot + 1)) {
+      mSlab->getBucket(Slot)->~ValueT();
+      mSlab->release(Slot);
+    }
+  }
+
+  /// Destroys all values and releases memory which is not referenced from
+  /// persistent iterators.
+  void destroyAll() {
+    if (!mSlab)
+      return;
+    destroyValues();
+    mSlab->shrink();
+    mSlab.reset();
+  }
+
+  llvm::IntrusiveRefCntPtr<SlabT> mSlab;
+  IndexT mIndex;
+};
+
+template<typename ValueT, typename ValueInfoT>
+static inline std::size_t capacity_in_bytes(
+    const SlabPersistentSet<ValueT, ValueInfoT> &X) {
+  return X.getMemorySize();
+}
+}
+#endif//TSAR_SLAB_PERSISTENT_SET_H
@@ -26,10 +26,15 @@
 #ifndef TSAR_SPANNING_TREE_RELATION_H
 #define TSAR_SPANNING_TREE_RELATION_H
 
-#include "GraphNumbering.h"
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/Optional.h>
+#include <llvm/ADT/SmallVector.h>
+#include <algorithm>
+#include <tuple>
 #include <type_traits>
+#include <vector>
 
 namespace tsar {
 /// Represents node relation in a tree.
@@ -44,38 +49,94 @@ enum TreeRelation : int8_t {
   NUMBER_TR = INVALID_TR
 };
 
-/// This determine relation between two nodes in a spanning tree.
+/// \brief This determine relation between two nodes in a spanning tree.
+///
+/// Each node gets a compact index at construction. Nodes are indexed in
+/// preorder of a depth-first traversal of a graph, so descendants of each node
+/// occupy a contiguous range of indexes which follows the index of this node.
+/// Parents and last descendants of nodes are stored in contiguous arrays,
+/// so relation between two known indexes is checked in O(1) without any
+/// lookups. Note, that this is equivalent to comparison of preorder and
+/// reverse postorder numbers of nodes.
 template<class GraphType>
 class SpanningTreeRelation {
-  using NodeRef = typename llvm::GraphTraits<GraphType>::NodeRef;
+  using GT = llvm::GraphTraits<GraphType>;
 public:
+  using NodeRef = typename GT::NodeRef;
+
+  /// Compact index of a node in a spanning tree.
+  using IndexTy = unsigned;
+
+  /// This value is used if an index is unknown (for example, the root node
+  /// of a spanning tree has no parent).
+  static constexpr IndexTy InvalidIndex = ~IndexTy(0);
 
   /// Performs initialization to determine relation of two nodes.
   explicit SpanningTreeRelation(const GraphType &G) {
-    numberGraph(G, &mNumbering);
+    using ChildItrTy = typename GT::ChildIteratorType;
+    auto Size = GT::size(G);
+    mIndexes.reserve(Size);
+    mNodes.reserve(Size);
+    mParents.reserve(Size);
+    mLasts.reserve(Size);
+    llvm::SmallVector<std::tuple<NodeRef, ChildItrTy, IndexTy>, 16> Stack;
+    auto visit = [this, &Stack](NodeRef N, IndexTy Parent) {
+      IndexTy Idx = mNodes.size();
+      mIndexes.try_emplace(N, Idx);
+      mNodes.push_back(N);
+      mParents.push_back(Parent);
+      mLasts.push_back(Idx);
+      Stack.emplace_back(N, GT::child_begin(N), Idx);
+    };
+    visit(GT::getEntryNode(G), InvalidIndex);
+    while (!Stack.empty()) {
+      auto &Top = Stack.back();
+      if (std::get<1>(Top) == GT::child_end(std::get<0>(Top))) {
+        mLasts[std::get<2>(Top)] = mNodes.size() - 1;
+        Stack.pop_back();
+        continue;
+      }
+      NodeRef Child = *std::get<1>(Top)++;
+      if (!mIndexes.count(Child))
+        visit(Child, std::get<2>(Top));
+    }
+  }
+
+  /// Returns number of nodes in a spanning tree.
+  std::size_t size() const noexcept { return mNodes.size(); }
+
+  /// Returns true if a specified node is a node of a spanning tree.
+  bool contains(NodeRef N) const { return mIndexes.count(N); }
+
+  /// Returns compact index of a specified node.
+  IndexTy getIndex(NodeRef N) const {
+    auto Itr = mIndexes.find(N);
+    assert(Itr != mIndexes.end() && "Node must be a node of a spanning tree!");
+    return Itr->second;
+  }
+
+  /// Returns a node with a specified index.
+  NodeRef getNode(IndexTy Idx) const {
+    assert(Idx < mNodes.size() && "Index is out of range!");
+    return mNodes[Idx];
+  }
+
+  /// Determines relation between two nodes with specified indexes.
+  TreeRelation compareByIndex(IndexTy LHS, IndexTy RHS) const {
+    assert(LHS < mNodes.size() && "LHS must be a node of a spanning tree!");
+    assert(RHS < mNodes.size() && "RHS must be a node of a spanning tree!");
+    if (LHS == RHS)
+      return TR_EQUAL;
+    if (LHS < RHS)
+      return RHS <= mLasts[LHS] ? TR_ANCESTOR : TR_UNREACHABLE;
+    return LHS <= mLasts[RHS] ? TR_DESCENDANT : TR_UNREACHABLE;
   }
 
   /// Determines relation between two nodes in a spanning tree.
   TreeRelation compare(NodeRef LHS, NodeRef RHS) const {
     if (LHS == RHS)
       return TR_EQUAL;
-    auto LeftItr = mNumbering.find(LHS);
-    auto RightItr = mNumbering.find(RHS);
-    assert(LeftItr != mNumbering.end() &&
-      "LHS must be a node of a spanning tree!");
-    assert(RightItr != mNumbering.end() &&
-      "RHS must be a node of a spanning tree!");
-    if (LeftItr->template get<Preorder>() <
-            RightItr->template get<Preorder>() &&
-        LeftItr->template get<ReversePostorder>() <
-            RightItr->template get<ReversePostorder>())
-      return TR_ANCESTOR;
-    if (LeftItr->template get<Preorder>() >
-            RightItr->template get<Preorder>() &&
-      LeftItr->template get<ReversePostorder>() >
-            RightItr->template get<ReversePostorder>())
-      return TR_DESCENDANT;
-    return TR_UNREACHABLE;
+    return compareByIndex(getIndex(LHS), getIndex(RHS));
   }
 
   bool isEqual(NodeRef LHS, NodeRef RHS) const {
@@ -97,8 +158,94 @@ public:
     return compare(LHS, RHS) == TR_UNREACHABLE;
   }
 
+  /// Returns a parent of a specified node in a spanning tree or `None` if
+  /// a specified node is a root of the tree.
+  llvm::Optional<NodeRef> getParent(NodeRef N) const {
+    auto Parent = mParents[getIndex(N)];
+    if (Parent == InvalidIndex)
+      return llvm::None;
+    return mNodes[Parent];
+  }
+
+  /// Returns all descendants of a specified node (excluding the node itself)
+  /// in preorder.
+  llvm::ArrayRef<NodeRef> descendants(NodeRef N) const {
+    auto Idx = getIndex(N);
+    return llvm::makeArrayRef(mNodes).slice(Idx + 1, mLasts[Idx] - Idx);
+  }
+
+  /// Appends to a specified list all nodes from a range [BeginItr, EndItr)
+  /// which are descendants of a specified node `Of`.
+  template<class ItrTy, class ListTy>
+  void findDescendants(NodeRef Of, ItrTy BeginItr, ItrTy EndItr,
+      ListTy &Descendants) const {
+    auto OfIdx = getIndex(Of);
+    for (auto I = BeginItr; I != EndItr; ++I) {
+      auto Idx = getIndex(*I);
+      if (OfIdx < Idx && Idx <= mLasts[OfIdx])
+        Descendants.push_back(*I);
+    }
+  }
+
+  /// \brief Appends to a specified list all nodes from a specified set
+  /// which are descendants of a specified node `Of`.
+  ///
+  /// If the number of descendants is less then the size of the set, this
+  /// method looks up descendants in the set. Otherwise, it checks each
+  /// node from the set. The set must provide count() and size() methods.
+  template<class SetTy, class ListTy>
+  void findDescendants(NodeRef Of, const SetTy &Set,
+      ListTy &Descendants) const {
+    auto Range = descendants(Of);
+    if (Range.size() < Set.size()) {
+      for (auto N : Range)
+        if (Set.count(N))
+          Descendants.push_back(N);
+    } else {
+      findDescendants(Of, Set.begin(), Set.end(), Descendants);
+    }
+  }
+
+  /// Finds a lowest common ancestor for specified nodes (the result may be
+  /// equal to one of the specified nodes).
+  NodeRef findNearestCommonAncestor(NodeRef LHS, NodeRef RHS) const {
+    return mNodes[findNearestCommonAncestor(getIndex(LHS), getIndex(RHS))];
+  }
+
+  /// \brief Finds a lowest common ancestor for specified nodes
+  /// in a spanning tree (result is not equal to any node).
+  ///
+  /// This is a faster alternative to findLCA(), which does not require
+  /// an inverse graph.
+  /// \pre The specified iterator range must not be empty.
+  template<class ItrTy>
+  llvm::Optional<NodeRef> findLCA(ItrTy BeginItr, ItrTy EndItr) const {
+    assert(BeginItr != EndItr &&
+      "At least one node must be in a iterator range!");
+    auto I = BeginItr;
+    auto LCA = getIndex(*I);
+    for (++I; I != EndItr; ++I)
+      LCA = findNearestCommonAncestor(LCA, getIndex(*I));
+    // The common ancestor must not be equal to any of specified nodes.
+    if (std::none_of(BeginItr, EndItr,
+                     [this, LCA](NodeRef N) { return getIndex(N) == LCA; }))
+      return mNodes[LCA];
+    if (mParents[LCA] == InvalidIndex)
+      return llvm::None;
+    return mNodes[mParents[LCA]];
+  }
+
 private:
-  GraphNumbering<NodeRef> mNumbering;
+  IndexTy findNearestCommonAncestor(IndexTy LHS, IndexTy RHS) const {
+    for (; !(LHS <= RHS && RHS <= mLasts[LHS]); LHS = mParents[LHS])
+      assert(mParents[LHS] != InvalidIndex && "Nodes must be connected!");
+    return LHS;
+  }
+
+  llvm::DenseMap<NodeRef, IndexTy> mIndexes;
+  std::vector<NodeRef> mNodes;
+  std::vector<IndexTy> mParents;
+  std::vector<IndexTy> mLasts;
 };
 
 /// \brief Returns a parent of a specified node in a spanning tree of a graph.
@@ -26,7 +26,7 @@
 #ifndef TSAR_CLANG_DI_MEMORY_MATCHER_H
 #define TSAR_CLANG_DI_MEMORY_MATCHER_H
 
-#include "tsar/ADT/Bimap.h"
+#include "tsar/ADT/FlatBimap.h"
 #include "tsar/Analysis/Clang/Passes.h"
 #include "tsar/Support/Tags.h"
 #include <bcl/utility.h>
@@ -47,7 +47,7 @@ class DIVariable;
 /// Note that matcher contains canonical declarations (Decl::getCanonicalDecl).
 class ClangDIMemoryMatcherPass : public FunctionPass, private bcl::Uncopyable {
 public:
-  using DIMemoryMatcher = tsar::Bimap <
+  using DIMemoryMatcher = tsar::FlatBimap <
     bcl::tagged<clang::VarDecl *, tsar::AST>,
     bcl::tagged<llvm::DIVariable *, tsar::MD>>;
 
@@ -27,12 +27,12 @@
 #ifndef TSAR_MEMORY_MATCHER_H
 #define TSAR_MEMORY_MATCHER_H
 
-#include "tsar/ADT/Bimap.h"
-#include "tsar/ADT/ListBimap.h"
+#include "tsar/ADT/FlatListBimap.h"
 #include "tsar/Support/AnalysisWrapperPass.h"
 #include "tsar/Support/Tags.h"
 #include <bcl/utility.h>
 #include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/DenseSet.h>
 
 namespace clang {
 class FuncDecl;
@@ -48,7 +48,7 @@ namespace tsar {
 ///
 /// Note that matcher contains canonical declarations (Decl::getCanonicalDecl).
 struct MemoryMatchInfo : private bcl::Uncopyable {
-  typedef tsar::ListBimap<
+  typedef tsar::FlatListBimap<
     bcl::tagged<clang::VarDecl*, tsar::AST>,
     bcl::tagged<llvm::Value *, tsar::IR>> MemoryMatcher;
 
@@ -0,0 +1,43 @@
+//===---- ColdLoops.h ------- Cold Loops Storage ----------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a storage of loops which weights are too small to be
+// worth precise analysis. Accesses in such loops are analyzed conservatively,
+// so expensive dependence tests can be skipped.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_COLD_LOOPS_H
+#define TSAR_COLD_LOOPS_H
+
+#include "tsar/Support/AnalysisWrapperPass.h"
+#include "tsar/Support/Tags.h"
+#include <llvm/ADT/DenseSet.h>
+
+namespace tsar {
+/// Set of identifiers (LoopID metadata) of cold loops.
+using ColdLoopSet = llvm::DenseSet<ObjectID>;
+}
+
+namespace llvm {
+/// Wrapper to access a set of cold loops.
+using ColdLoopsWrapper = AnalysisWrapperPass<tsar::ColdLoopSet>;
+}
+#endif//TSAR_COLD_LOOPS_H
@@ -27,8 +27,8 @@
 #define TSAR_DI_MEMORY_TRAIT_H
 
 #include "tsar/ADT/DenseMapTraits.h"
-#include "tsar/ADT/PersistentMap.h"
 #include "tsar/ADT/PersistentIteratorInfo.h"
+#include "tsar/ADT/SlabPersistentMap.h"
 #include "tsar/Analysis/Memory/DIEstimateMemory.h"
 #include "tsar/Analysis/Memory/DIMemoryHandle.h"
 #include "tsar/Analysis/Memory/MemoryTrait.h"
@@ -190,8 +190,13 @@ using DIMemoryTraitSet = bcl::TraitSet<MemoryDescriptor,
 class DIMemoryTraitHandle;
 class DIMemoryTrait;
 
-/// This is a set of metadata-level memory traits in a region of a code.
-using DIMemoryTraitRegionPool = PersistentMap<
+/// \brief This is a set of metadata-level memory traits in a region of a code.
+///
+/// Traits of each memory location occupy a slot in a slab, so persistent
+/// references to traits (see DIMemoryTraitRef) are slot indexes. Removal of
+/// a memory location and its replacement on RAUW free a slot and reuse it
+/// without accessing other references to traits.
+using DIMemoryTraitRegionPool = SlabPersistentMap<
   DIMemoryTraitHandle, DIMemoryTraitSet, DIMemoryMapInfo, DIMemoryTrait>;
 
 /// This removes traits from a set on memory location destruction and changes
@@ -40,6 +40,8 @@
 #ifndef LLVM_ANALYSIS_DEPENDENCEANALYSIS_H
 #define LLVM_ANALYSIS_DEPENDENCEANALYSIS_H
 
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallBitVector.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/IR/Instructions.h"
@@ -336,6 +338,26 @@ inline namespace tsar_impl {
                                         bool PossiblyLoopIndependent,
                                         unsigned short *ConfusedLevels = nullptr);
 
+    /// Tests for a dependence between the Src and Dst instructions and
+    /// memoizes the result.
+    ///
+    /// This method is similar to depends(), however the returned dependence
+    /// is owned by this object, so repeated queries for the same pair of
+    /// instructions (for example, from different loops in a loop nest) do not
+    /// repeat dependence tests. The result remains valid while this object
+    /// exists.
+    const Dependence *dependsCached(Instruction *Src, Instruction *Dst,
+                                    bool PossiblyLoopIndependent,
+                                    unsigned short *ConfusedLevels = nullptr);
+
+    /// Returns a memoized result of dependence test for the Src and Dst
+    /// instructions or `None` if the test has not been performed yet.
+    ///
+    /// This method does not perform dependence tests.
+    Optional<const Dependence *> getCachedDependence(
+        Instruction *Src, Instruction *Dst, bool PossiblyLoopIndependent,
+        unsigned short *ConfusedLevels = nullptr) const;
+
     /// getSplitIteration - Give a dependence that's splittable at some
     /// particular level, return the iteration that should be used to split
     /// the loop.
@@ -706,6 +728,17 @@ inline namespace tsar_impl {
                  const SmallBitVector &Loops,
                  FullDependence &Result) const;
 
+    /// testExact - Tests all linear subscript pairs of the Src and Dst
+    /// instructions simultaneously with an exact integer programming test.
+    /// Returns true if dependence disproved.
+    /// Otherwise, removes impossible directions from the Result.
+    /// The test is bounded by a budget, it gives up if the budget is
+    /// exhausted.
+    bool testExact(ArrayRef<Subscript> Pairs,
+                   const Instruction *Src,
+                   const Instruction *Dst,
+                   FullDependence &Result) const;
+
     /// strongSIVtest - Tests the strong SIV subscript pair (Src and Dst)
     /// for dependence.
     /// Things of the form [c1 + a*i] and [c2 + a*i],
@@ -993,6 +1026,43 @@ inline namespace tsar_impl {
 
     bool tryDelinearize(Instruction *Src, Instruction *Dst,
                         SmallVectorImpl<Subscript> &Pair);
+
+    /// Memoized result of a dependence test and the number of confused
+    /// levels for a pair of instructions.
+    struct CachedDependence {
+      std::unique_ptr<Dependence> Dep;
+      unsigned short ConfusedLevels = 0;
+    };
+
+    /// Memoized classification of a subscript pair.
+    ///
+    /// Loops and ConfusedLevels are not meaningful for nonlinear subscripts.
+    struct CachedClassification {
+      Subscript::ClassificationKind Kind;
+      SmallBitVector Loops;
+      unsigned short ConfusedLevels;
+    };
+
+    /// Outcome of the ZIV test.
+    enum class ZIVOutcome : uint8_t { Dependent, Independent, Unknown };
+
+    /// Results of dependence tests for (Src, Dst, PossiblyLoopIndependent).
+    ///
+    /// Loop nests which surround Src and Dst are implied by instructions, so
+    /// they are not included in the key.
+    DenseMap<std::tuple<const Instruction *, const Instruction *, unsigned>,
+             CachedDependence> DependenceCache;
+
+    /// Classifications of subscript pairs. A key is (Src subscript,
+    /// Src loop nest, Dst subscript, Dst loop nest, whether confused levels
+    /// are requested).
+    DenseMap<std::tuple<const SCEV *, const Loop *, const SCEV *, const Loop *,
+                        unsigned>,
+             CachedClassification> ClassificationCache;
+
+    /// Outcomes of the ZIV test for pairs of subscripts.
+    mutable DenseMap<std::pair<const SCEV *, const SCEV *>, ZIVOutcome>
+        ZIVCache;
   }; // class DependenceInfo
 
   /// AnalysisPass to compute dependence information in a function
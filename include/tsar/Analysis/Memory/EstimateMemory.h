@@ -70,8 +70,10 @@
 #include <llvm/ADT/TinyPtrVector.h>
 #include <llvm/Analysis/AliasAnalysis.h>
 #include <llvm/Pass.h>
+#include <llvm/Support/Allocator.h>
 #include <array>
 #include <iterator>
+#include <memory>
 #include <tuple>
 #include <vector>
 
@@ -182,14 +184,27 @@ AliasDescriptor mergeAliasRelation(
 AliasDescriptor aliasRelation(llvm::AAResults &AA, const llvm::DataLayout &DL,
   const llvm::MemoryLocation &LHS, const llvm::MemoryLocation &RHS);
 
+/// This determines alias relation of a first memory location to a second one,
+/// alias queries are performed in a batch mode.
+AliasDescriptor aliasRelation(llvm::BatchAAResults &AA, const llvm::DataLayout &DL,
+  const llvm::MemoryLocation &LHS, const llvm::MemoryLocation &RHS);
+
 /// This determines alias relation of a first estimate location to a second one.
 AliasDescriptor aliasRelation(llvm::AAResults &AA, const llvm::DataLayout &DL,
   const EstimateMemory &LHS, const EstimateMemory &RHS);
 
+/// This determines alias relation of a first estimate location to a second one,
+/// alias queries are performed in a batch mode.
+AliasDescriptor aliasRelation(llvm::BatchAAResults &AA, const llvm::DataLayout &DL,
+  const EstimateMemory &LHS, const EstimateMemory &RHS);
+
 /// This determines alias relation between a specified estimate location'EM' and
 /// locations from a specified range [BeginItr, EndItr).
-template<class ItrTy>
-AliasDescriptor aliasRelation(llvm::AAResults &AA, const llvm::DataLayout &DL,
+///
+/// \tparam AATy Alias analysis results (llvm::AAResults or
+/// llvm::BatchAAResults).
+template<class AATy, class ItrTy>
+AliasDescriptor aliasRelation(AATy &AA, const llvm::DataLayout &DL,
   const EstimateMemory &EM, const ItrTy &BeginItr, const ItrTy &EndItr) {
   auto I = BeginItr;
   auto MergedAD = aliasRelation(AA, DL, EM, *I);
@@ -749,15 +764,16 @@ protected:
   ///
   /// This method is potentially slow because in the worst cast it uses
   /// AAResults::alias() method to compare all possible pairs of ambiguous
-  /// pointers.
+  /// pointers. So, alias queries are performed in a batch mode which memoizes
+  /// their results.
   /// \return True in case of alias relation, if a known location is found it
   /// is returned as a second part of a pair.
   std::pair<bool, EstimateMemory *> slowMayAlias(
-    const EstimateMemory &EM, llvm::AAResults &AA);
+    const EstimateMemory &EM, llvm::BatchAAResults &AA);
 
   /// This is a stub for nodes which does not support slowMayAlias().
   std::pair<bool, EstimateMemory *> slowMayAliasImp(
-      const EstimateMemory &/*EM*/, llvm::AAResults &/*AA*/) {
+      const EstimateMemory &/*EM*/, llvm::BatchAAResults &/*AA*/) {
     llvm_unreachable("slowMayAlias() is not implemented for this node!");
     return std::make_pair(false, nullptr);
   }
@@ -780,11 +796,11 @@ protected:
     return std::make_pair(false, nullptr);
   }
 
-  Kind mKind;
   mutable AliasNode *mParent = nullptr;
   ChildList mChildren;
   mutable AliasNode *mForward = nullptr;
   mutable unsigned mRefCount = 0;
+  Kind mKind;
 };
 
 /// This represents a root of an alias tree.
@@ -853,7 +869,7 @@ private:
 
   /// Implementation for appropriate function from the base class.
   std::pair<bool, EstimateMemory *> slowMayAliasImp(
-    const EstimateMemory &EM, llvm::AAResults &AA);
+    const EstimateMemory &EM, llvm::BatchAAResults &AA);
 
   /// Implementation for appropriate function from the base class.
   std::pair<bool, llvm::Instruction *> slowMayAliasUnknownImp(
@@ -924,7 +940,7 @@ private:
 
   /// Implementation for appropriate function from the base class.
   std::pair<bool, EstimateMemory *> slowMayAliasImp(
-    const EstimateMemory &EM, llvm::AAResults &AA);
+    const EstimateMemory &EM, llvm::BatchAAResults &AA);
 
   /// Implementation for appropriate function from the base class.
   std::pair<bool, llvm::Instruction *> slowMayAliasUnknownImp(
@@ -949,7 +965,10 @@ class AliasTree {
   using StrippedMap = llvm::DenseMap<const llvm::Value *, BaseList>;
 
   /// Pool to store pointers to all alias nodes, including forwarding.
-  using AliasNodePool = llvm::ilist<AliasNode,
+  ///
+  /// Memory for nodes is allocated in an alias tree, so the pool does not own
+  /// nodes.
+  using AliasNodePool = llvm::simple_ilist<AliasNode,
     llvm::ilist_tag<Pool>, llvm::ilist_sentinel_tracking<true>>;
 
   /// This is used to iterate over all nodes in tree excluding forwarding.
@@ -1010,24 +1029,30 @@ public:
   /// Size of an alias tree.
   using size_type = AliasNodePool::size_type;
 
-  /// Creates empty alias tree.
+  /// \brief Creates empty alias tree.
+  ///
+  /// Alias queries are performed in a batch mode, so their results are
+  /// memoized while this tree exists only. IR must not be changed while
+  /// the tree is alive.
   AliasTree(llvm::AAResults &AA,
       const llvm::DataLayout &DL, const llvm::DominatorTree &DT) :
-    mAA(&AA), mDL(&DL), mDT(&DT), mTopLevelNode(new AliasTopNode) {
-    mNodes.push_back(mTopLevelNode);
+    mAA(&AA), mBatchAA(std::make_unique<llvm::BatchAAResults>(AA)), mDL(&DL),
+    mDT(&DT), mTopLevelNode(make<AliasTopNode>()) {
+    mNodes.push_back(*mTopLevelNode);
   }
 
   /// Destroys alias tree.
-  ~AliasTree() {
-    for (auto &Pair : mBases) {
-      for (auto *EM : Pair.second)
-        delete EM;
-    }
-  }
+  ///
+  /// All nodes and estimate memory locations are released at once together
+  /// with the memory allocator of this tree.
+  ~AliasTree();
 
   /// Returns the underlying alias analysis object used by this tree.
   llvm::AAResults & getAliasAnalysis() const noexcept { return *mAA; }
 
+  /// Returns alias analysis in a batch mode which is used to build this tree.
+  llvm::BatchAAResults & getBatchAA() const noexcept { return *mBatchAA; }
+
   /// Returns a dominator tree used by this alias tree.
   const llvm::DominatorTree & getDomTree() const noexcept { return *mDT; }
 
@@ -1153,15 +1178,22 @@ public:
   void viewOnly() const;
 
 private:
+  /// Constructs a new object (alias node or estimate memory location) in
+  /// memory which is allocated by this tree.
+  template<class T, class... ArgTs> T * make(ArgTs &&... Args) {
+    ++mNumObjects;
+    return new (mAllocator.Allocate<T>()) T(std::forward<ArgTs>(Args)...);
+  }
+
   /// Allocates memory for a new child node of a specified parent and increases
   /// value of each count from a specified list of counts.
   template<class NodeTy, class CountTy, std::size_t CountNum>
   NodeTy * make_node(
       AliasNode &Parent, std::array<CountTy *, CountNum> Counts) {
-    auto *NewNode = new NodeTy;
+    auto *NewNode = make<NodeTy>();
     for (auto Count : Counts)
       ++(*Count);
-    mNodes.push_back(NewNode);
+    mNodes.push_back(*NewNode);
     NewNode->setParent(Parent, *this);
     return NewNode;
   }
@@ -1201,8 +1233,13 @@ private:
     insert(const llvm::MemoryLocation &Base);
 
   llvm::AAResults *mAA;
+  std::unique_ptr<llvm::BatchAAResults> mBatchAA;
   const llvm::DataLayout *mDL;
   const llvm::DominatorTree *mDT;
+  llvm::BumpPtrAllocator mAllocator;
+  /// Number of objects constructed in the allocator, it must be initialized
+  /// before the top level node is created.
+  unsigned mNumObjects = 0;
   AliasNodePool mNodes;
   AliasNode *mTopLevelNode;
   tsar::AmbiguousRef::AmbiguousPool mAmbiguousPool;
@@ -1237,7 +1274,7 @@ inline void AliasNode::mergeNodeIn(AliasNode &AN, const AliasTree &G) {
 }
 
 inline std::pair<bool, EstimateMemory *> AliasNode::slowMayAlias(
-    const EstimateMemory &EM, llvm::AAResults &AA) {
+    const EstimateMemory &EM, llvm::BatchAAResults &AA) {
   switch (getKind()) {
   default:
     llvm_unreachable("Unknown kind of an alias node!");
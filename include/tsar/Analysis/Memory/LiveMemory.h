@@ -33,13 +33,67 @@
 #include "tsar/Analysis/Memory/Passes.h"
 #include "tsar/Support/AnalysisWrapperPass.h"
 #include <bcl/utility.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/Optional.h>
 #include <llvm/Pass.h>
+#include <vector>
 
 namespace llvm {
 class DominatorTree;
 }
 
 namespace tsar {
+class AliasTree;
+class EstimateMemory;
+
+/// \brief Set of memory locations which is used as a data-flow value in
+/// the live memory analysis.
+///
+/// Locations which match estimate memory locations one-to-one are represented
+/// as bits in a dense bit vector indexed by numbers of these estimate
+/// locations (see LiveDFFwk::getDenseId()). So, gen, kill, meet and
+/// comparison of these locations are word-parallel operations. Other locations
+/// (for example, partially accessed arrays) are stored explicitly.
+class LiveLocationSet {
+public:
+  /// Set of explicitly stored locations.
+  typedef MemorySet<MemoryLocationRange> LocationSet;
+
+  LiveLocationSet() = default;
+
+  /// Create an empty set, `NumDense` is a number of locations which are
+  /// represented as bits.
+  explicit LiveLocationSet(unsigned NumDense) : mDense(NumDense) {}
+
+  /// Return bits which represent locations with dense numbers.
+  const llvm::BitVector & getDense() const noexcept { return mDense; }
+  llvm::BitVector & getDense() noexcept { return mDense; }
+
+  /// Return explicitly stored locations.
+  const LocationSet & getLocations() const noexcept { return mLocations; }
+  LocationSet & getLocations() noexcept { return mLocations; }
+
+  /// Merge locations from a specified set into this set.
+  void merge(const LiveLocationSet &With) {
+    mDense |= With.mDense;
+    mLocations.insert(With.mLocations.begin(), With.mLocations.end());
+  }
+
+  /// Compare two sets.
+  ///
+  /// \pre Both sets have the same number of locations which are represented
+  /// as bits.
+  bool operator==(const LiveLocationSet &RHS) const {
+    return mDense == RHS.mDense && mLocations == RHS.mLocations;
+  }
+
+  bool operator!=(const LiveLocationSet &RHS) const { return !(*this == RHS); }
+
+private:
+  llvm::BitVector mDense;
+  LocationSet mLocations;
+};
+
 /// Data-flow framework which is used to find live locations
 /// for each data-flow regions: basic blocks, loops, functions, etc.
 class LiveDFFwk : private bcl::Uncopyable {
@@ -58,18 +112,76 @@ public:
     bcl::tagged<llvm::Function *, llvm::Function>,
     bcl::tagged<std::unique_ptr<LiveSet>, LiveSet>>> InterprocLiveMemoryInfo;
 
+  /// Values which are used while data-flow problem is solved. Results are
+  /// moved to LiveMemoryInfo when a region is collapsed.
+  typedef DFValue<LiveDFFwk, LiveLocationSet> DenseLiveSet;
+  typedef llvm::DenseMap<DFNode *, std::unique_ptr<DenseLiveSet>>
+    DenseLiveMemoryInfo;
+
+  /// Gen and kill sets for a data-flow node.
+  struct TransferInfo {
+    /// Def-use set for a node.
+    const DefUseSet *DU = nullptr;
+    /// Outward exposed uses with dense numbers.
+    llvm::BitVector Gen;
+    /// Locations with dense numbers which are defined in a node.
+    llvm::BitVector Kill;
+    /// Outward exposed uses without dense numbers.
+    LiveLocationSet::LocationSet GenLocations;
+  };
+
+  /// Create data-flow framework. If an alias tree is specified then locations
+  /// which match estimate memory locations one-to-one are represented as bits.
+  ///
+  /// \pre Boundary conditions (results for a region the analysis is started
+  /// from) must be already specified in LiveInfo.
   LiveDFFwk(LiveMemoryInfo &LiveInfo, DefinedMemoryInfo &DefInfo,
-      const llvm::DominatorTree *DT) :
-    mLiveInfo(&LiveInfo), mDefInfo(&DefInfo), mDT(DT) {}
+      const llvm::DominatorTree *DT, const AliasTree *AT = nullptr);
   LiveMemoryInfo & getLiveInfo() noexcept { return *mLiveInfo; }
   const LiveMemoryInfo & getLiveInfo() const noexcept { return *mLiveInfo; }
   DefinedMemoryInfo & getDefInfo() noexcept { return *mDefInfo; }
   const DefinedMemoryInfo & getDefInfo() const noexcept { return *mDefInfo; }
   const llvm::DominatorTree * getDomTree() const noexcept { return mDT; }
+
+  /// Return number of a location in a dense representation of live sets or
+  /// None if a location should be stored explicitly.
+  llvm::Optional<unsigned> getDenseId(const MemoryLocationRange &Loc) const;
+
+  /// Return number of locations which are represented as bits.
+  unsigned getNumberOfDenseIds() const noexcept {
+    return mDenseLocations.size();
+  }
+
+  /// Convert a set of locations to a data-flow value.
+  LiveLocationSet toDense(const LiveLocationSet::LocationSet &Locs) const;
+
+  /// Convert a data-flow value to a set of locations.
+  LiveLocationSet::LocationSet fromDense(const LiveLocationSet &Locs) const;
+
+  /// Return data-flow value for a specified node. If it has not been
+  /// computed yet, it is initialized with results from LiveMemoryInfo.
+  DenseLiveSet & getDenseValue(DFNode *N);
+
+  /// Return gen and kill sets for a specified node.
+  const TransferInfo & getTransferInfo(DFNode *N);
+
+  /// Move data-flow values of nodes in a specified region to LiveMemoryInfo.
+  void materialize(DFRegion *R);
 private:
+  /// Assign a number to a location if it matches an estimate memory location
+  /// one-to-one.
+  void registerDenseLocation(const MemoryLocationRange &Loc);
+
   LiveMemoryInfo *mLiveInfo;
   DefinedMemoryInfo *mDefInfo;
   const llvm::DominatorTree *mDT;
+  const AliasTree *mAT;
+  llvm::DenseMap<const EstimateMemory *, unsigned> mDenseIds;
+  std::vector<MemoryLocationRange> mDenseLocations;
+  llvm::DenseMap<const llvm::Value *, llvm::SmallVector<unsigned, 1>>
+    mDensePtrs;
+  DenseLiveMemoryInfo mDenseInfo;
+  llvm::DenseMap<DFNode *, TransferInfo> mTransferInfo;
 };
 
 /// This covers IN and OUT value for a live locations analysis.
@@ -85,48 +197,40 @@ typedef LiveDFFwk::InterprocLiveMemoryInfo InterprocLiveMemoryInfo;
 /// Traits for a data-flow framework which is used to find live locations.
 template<> struct DataFlowTraits<LiveDFFwk *> {
   typedef Backward<DFRegion * > GraphType;
-  typedef MemorySet<MemoryLocationRange> ValueType;
-  static ValueType topElement(LiveDFFwk *, GraphType) { return ValueType(); }
+  typedef LiveLocationSet ValueType;
+  static ValueType topElement(LiveDFFwk *DFF, GraphType) {
+    assert(DFF && "Data-flow framework must not be null!");
+    return ValueType(DFF->getNumberOfDenseIds());
+  }
   static ValueType boundaryCondition(LiveDFFwk *DFF, GraphType G) {
     assert(DFF && "Data-flow framework must not be null!");
-    auto I = DFF->getLiveInfo().find(G.Graph);
-    assert(I != DFF->getLiveInfo().end() && I->get<LiveSet>() &&
-      "Data-flow value must be specified!");
-    auto &LS = I->get<LiveSet>();
+    auto &LS = DFF->getDenseValue(G.Graph);
     ValueType V(topElement(DFF, G));
     // If a location is alive before a loop it is alive before each iteration.
     // This occurs due to conservatism of analysis.
     // If a location is alive before iteration with number I then it is alive
     // after iteration with number I-1. So it should be used as a boundary
     // value.
-    meetOperator(LS->getIn(), V, DFF, G);
+    meetOperator(LS.getIn(), V, DFF, G);
     // If a location is alive after a loop it also should be used as a boundary
     // value.
-    meetOperator(LS->getOut(), V, DFF, G);
+    meetOperator(LS.getOut(), V, DFF, G);
     return V;
   }
   static void setValue(ValueType V, DFNode *N, LiveDFFwk *DFF) {
     assert(N && "Node must not be null!");
     assert(DFF && "Data-flow framework must not be null!");
-    auto I = DFF->getLiveInfo().find(N);
-    assert(I != DFF->getLiveInfo().end() && I->get<LiveSet>() &&
-      "Data-flow value must be specified!");
-    auto & LS = I->get<LiveSet>();
-    LS->setIn(std::move(V));
+    DFF->getDenseValue(N).setIn(std::move(V));
   }
   static const ValueType & getValue(DFNode *N, LiveDFFwk *DFF) {
     assert(N && "Node must not be null!");
     assert(DFF && "Data-flow framework must not be null!");
-    auto I = DFF->getLiveInfo().find(N);
-    assert(I != DFF->getLiveInfo().end() && I->get<LiveSet>() &&
-      "Data-flow value must be specified!");
-    auto &LS = I->get<LiveSet>();
-    return LS->getIn();
+    return DFF->getDenseValue(N).getIn();
   }
   static void initialize(DFNode *, LiveDFFwk *, GraphType);
   static void meetOperator(
     const ValueType &LHS, ValueType &RHS, LiveDFFwk *, GraphType) {
-    RHS.insert(LHS.begin(), LHS.end());
+    RHS.merge(LHS);
   }
   static bool transferFunction(ValueType, DFNode *, LiveDFFwk *, GraphType);
 };
@@ -142,7 +246,10 @@ template<> struct RegionDFTraits<LiveDFFwk *> :
     LN->addSuccessor(EN);
     EN->addPredecessor(LN);
   }
-  static void collapse(LiveDFFwk *, GraphType G) {
+  static void collapse(LiveDFFwk *DFF, GraphType G) {
+    // All inner regions have been already processed, so results for nodes of
+    // this region will not be changed any more.
+    DFF->materialize(G.Graph);
     DFNode *LN = G.Graph->getLatchNode();
     if (!LN)
       return;
@@ -25,6 +25,7 @@
 #ifndef TSAR_MEMORY_SET_H
 #define TSAR_MEMORY_SET_H
 
+#include "tsar/Analysis/Memory/MemorySetIndex.h"
 #include "tsar/Analysis/Memory/MemorySetInfo.h"
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/iterator_range.h>
@@ -38,6 +39,11 @@ namespace tsar {
 ///
 /// Methods of this class do not use alias information. Consequently,
 /// two locations may overlap if they have identical address of beginning.
+///
+/// If there are a lot of locations with the same address of beginning,
+/// an interval index (see MemorySetIndex) is used to search for locations
+/// which may overlap a specified one. Hence, bounds of locations in a set
+/// must not be changed through iterators.
 /// \note This class manages memory allocation to store elements of
 /// a location set.
 template<class LocationTy, class MemoryInfo = MemorySetInfo<LocationTy>>
@@ -49,6 +55,16 @@ class MemorySet {
 
   /// Map from pointers to locations.
   using MapTy = llvm::DenseMap<const llvm::Value *, LocationList>;
+
+  /// Interval index of locations with the same address of beginning.
+  using IndexTy = MemorySetIndex<LocationTy, MemoryInfo>;
+
+  /// Map from pointers to indexes of lists of locations.
+  using IndexMapTy = llvm::DenseMap<const llvm::Value *, IndexTy>;
+
+  /// Minimum number of locations with the same address of beginning
+  /// which should be indexed.
+  static constexpr std::size_t IndexThreshold = 16;
 public:
   /// \brief Calculate the difference between two sets of locations.
   ///
@@ -125,14 +141,21 @@ public:
   MemorySet() = default;
   ~MemorySet() { clear(); }
 
-  MemorySet(MemorySet &&that) : mLocations(std::move(that.mLocations)) {}
-  MemorySet(const MemorySet &that) { insert(that.begin(), that.end()); }
+  MemorySet(MemorySet &&that) :
+    mLocations(std::move(that.mLocations)),
+    mIndexes(std::move(that.mIndexes)) {}
+
+  /// Locations of the other set are already normalized, so copy them
+  /// together with indexes instead of insertion one by one.
+  MemorySet(const MemorySet &that) :
+    mLocations(that.mLocations), mIndexes(that.mIndexes) {}
 
   /// Move assignment operator.
   MemorySet & operator=(MemorySet &&that) {
     if (this != &that) {
       clear();
       mLocations = std::move(that.mLocations);
+      mIndexes = std::move(that.mIndexes);
     }
     return *this;
   }
@@ -140,8 +163,8 @@ public:
   /// Copy assignment operator.
   MemorySet & operator=(const MemorySet &that) {
     if (this != &that) {
-      clear();
-      insert(that.begin(), that.end());
+      mLocations = that.mLocations;
+      mIndexes = that.mIndexes;
     }
     return *this;
   }
@@ -167,9 +190,7 @@ public:
     if (I == mLocations.end())
       return false;
     llvm::SmallVector<Ty, 4> UnionLocs, Tails { Loc };
-    for (auto &Curr : I->second) {
-      if (Tails.empty())
-        break;
+    forEachOverlapped(I, Loc, [&Tails, &UnionLocs](const LocationTy &Curr) {
       llvm::SmallVector<Ty, 4> NewTails;
       for (auto &Tail : Tails) {
         auto IntOpt = MemoryInfo::intersect(Curr, Tail, nullptr, &NewTails);
@@ -179,7 +200,8 @@ public:
           NewTails.push_back(Tail);
       }
       Tails = std::move(NewTails);
-    }
+      return !Tails.empty();
+    });
     if (Tails.empty())
       Locs.append(UnionLocs.begin(), UnionLocs.end());
     return Tails.empty();
@@ -199,14 +221,16 @@ public:
     if (I == mLocations.end())
       return false;
     bool IsCovered = false;
-    for (auto &Curr : I->second) {
+    forEachOverlapped(I, Loc,
+        [&Loc, &Locs, &IsCovered](const LocationTy &Curr) {
       auto IntOpt = MemoryInfo::intersect(Curr, Loc);
       if (IntOpt.hasValue()) {
         IsCovered = true;
         if (MemoryInfo::getPtr(IntOpt.getValue()))
           Locs.push_back(IntOpt.getValue());
       }
-    }
+      return true;
+    });
     return IsCovered;
   }
 
@@ -222,12 +246,9 @@ public:
     auto I = mLocations.find(MemoryInfo::getPtr(Loc));
     if (I == mLocations.end())
       return iterator(mLocations.end(), 0);
-    for (std::size_t Idx = 0, EIdx = I->second.size(); Idx < EIdx; ++Idx) {
-      auto &Curr = I->second[Idx];
-      if (MemoryInfo::hasIntersection(Curr, Loc))
-        return iterator(I, Idx);
-    }
-    return iterator(mLocations.end(), 0);
+    auto Idx = findOverlappedIdx(I, Loc);
+    return Idx == I->second.size() ? iterator(mLocations.end(), 0) :
+      iterator(I, Idx);
   }
 
   /// Return location which may overlap with a specified location.
@@ -235,12 +256,9 @@ public:
     auto I = mLocations.find(MemoryInfo::getPtr(Loc));
     if (I == mLocations.end())
       return const_iterator(mLocations.end(), 0);
-    for (std::size_t Idx = 0, EIdx = I->second.size(); Idx < EIdx; ++Idx) {
-      auto &Curr = I->second[Idx];
-      if (MemoryInfo::hasIntersection(Curr, Loc))
-        return const_iterator(I, Idx);
-    }
-    return const_iterator(mLocations.end(), 0);
+    auto Idx = findOverlappedIdx(I, Loc);
+    return Idx == I->second.size() ? const_iterator(mLocations.end(), 0) :
+      const_iterator(I, Idx);
   }
 
   /// Subtracts locations of this set from the specified location and puts
@@ -253,8 +271,8 @@ public:
       return false;
     bool Intersected = false;
     LocationList LocsToSub { Loc };
-    for (std::size_t Idx = 0, EIdx = I->second.size(); Idx < EIdx; ++Idx) {
-      auto &Curr = I->second[Idx];
+    forEachOverlapped(I, Loc,
+        [&LocsToSub, &Intersected](const LocationTy &Curr) {
       LocationList NewLocsToSub;
       for (auto &LocToSub : LocsToSub) {
         auto IntOpt = MemoryInfo::intersect(Curr, LocToSub, nullptr,
@@ -265,7 +283,8 @@ public:
           NewLocsToSub.push_back(LocToSub);
       }
       LocsToSub = std::move(NewLocsToSub);
-    }
+      return true;
+    });
     Locs = std::move(LocsToSub);
     return Intersected;
   }
@@ -280,7 +299,10 @@ public:
   bool empty() const { return mLocations.empty(); }
 
   /// Removes all locations from this set.
-  void clear() { mLocations.clear(); }
+  void clear() {
+    mLocations.clear();
+    mIndexes.clear();
+  }
 
   /// Insert a new location into this set, returns false if it already
   /// exists.
@@ -315,6 +337,10 @@ public:
         else
           isChanged = false;
         isChanged = MemoryInfo::join(Loc, Curr);
+        if (isChanged)
+          if (auto IndexItr{mIndexes.find(I->first)};
+              IndexItr != mIndexes.end())
+            IndexItr->second.update(Curr, Idx);
         return std::make_pair(iterator(I, Idx), isChanged);
       }
       if (MemoryInfo::getNumDims(Loc) == 0 &&
@@ -326,7 +352,12 @@ public:
     }
     if (MemoryInfo::getNumDims(Loc) > 0)
       InsertItr = I->second.end();
+    auto Pos = InsertItr - I->second.begin();
     I->second.insert(InsertItr, Loc);
+    if (auto IndexItr{mIndexes.find(I->first)}; IndexItr != mIndexes.end())
+      IndexItr->second.insert(I->second[Pos], Pos);
+    else if (I->second.size() >= IndexThreshold)
+      mIndexes.try_emplace(I->first, I->second);
     return std::make_pair(iterator(I, Idx), true);
   }
 
@@ -347,6 +378,7 @@ public:
       return false;
     MapTy PrevLocations;
     mLocations.swap(PrevLocations);
+    mIndexes.clear();
     bool IsChanged = false;
     for (auto &Pair : PrevLocations) {
       for (auto &Loc : Pair.second) {
@@ -389,13 +421,13 @@ public:
       bool HasExactIntersection = false;
       if (auto Itr{mLocations.find(MemoryInfo::getPtr(OtherLoc))};
           Itr != mLocations.end()) {
-        for (auto &Loc : Itr->second) {
+        forEachOverlapped(Itr, OtherLoc,
+            [&OtherLoc, &HasExactIntersection](const LocationTy &Loc) {
           auto IntOpt = MemoryInfo::intersect(Loc, OtherLoc);
-          if (IntOpt.hasValue() && MemoryInfo::getPtr(IntOpt.getValue())) {
+          if (IntOpt.hasValue() && MemoryInfo::getPtr(IntOpt.getValue()))
             HasExactIntersection = true;
-            break;
-          }
-        }
+          return !HasExactIntersection;
+        });
       }
       if (!HasExactIntersection) {
         NewLocs.push_back(Pair.first);
@@ -453,6 +485,48 @@ public:
     return true;
   }
 private:
+  /// \brief Visit locations from a list `I` which may overlap a specified
+  /// location.
+  ///
+  /// Locations are visited in the order they are stored in the list.
+  /// The visitor `F(const LocationTy &)` returns `false` to stop the search.
+  /// It must not change the list.
+  template<class map_iterator, class Ty, class FuncT>
+  void forEachOverlapped(const map_iterator &I, const Ty &Loc,
+                         FuncT &&F) const {
+    auto IndexItr = mIndexes.find(I->first);
+    if (IndexItr == mIndexes.end()) {
+      for (auto &Curr : I->second)
+        if (!F(Curr))
+          return;
+      return;
+    }
+    llvm::SmallVector<unsigned, 8> Positions;
+    IndexItr->second.findOverlapped(Loc, Positions);
+    for (auto Pos : Positions)
+      if (!F(I->second[Pos]))
+        return;
+  }
+
+  /// Return position of the first location from a list `I` which may overlap
+  /// a specified location or size of the list if there is no such location.
+  template<class map_iterator, class Ty>
+  std::size_t findOverlappedIdx(const map_iterator &I, const Ty &Loc) const {
+    auto IndexItr = mIndexes.find(I->first);
+    if (IndexItr == mIndexes.end()) {
+      for (std::size_t Idx = 0, EIdx = I->second.size(); Idx < EIdx; ++Idx)
+        if (MemoryInfo::hasIntersection(I->second[Idx], Loc))
+          return Idx;
+      return I->second.size();
+    }
+    llvm::SmallVector<unsigned, 8> Positions;
+    IndexItr->second.findOverlapped(Loc, Positions);
+    for (auto Pos : Positions)
+      if (MemoryInfo::hasIntersection(I->second[Pos], Loc))
+        return Pos;
+    return I->second.size();
+  }
+
   template<class SizeT>
   static const SizeT & max(const SizeT &L, const SizeT &R) {
     if (MemoryInfo::sizecmp(L, R) < 0)
@@ -467,6 +541,7 @@ private:
   }
 
   MapTy mLocations;
+  IndexMapTy mIndexes;
 };
 
 /// \brief Calculates the difference between two sets of locations.
@@ -0,0 +1,214 @@
+//===- MemorySetIndex.h - Interval Index Of Memory Locations ----*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines an ordered interval index of memory locations which have
+// the same base pointer. The index is used in MemorySet to search for
+// locations which may overlap a specified one without a linear scan of all
+// locations.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_MEMORY_SET_INDEX_H
+#define TSAR_MEMORY_SET_INDEX_H
+
+#include "tsar/Analysis/Memory/MemorySetInfo.h"
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+namespace tsar {
+/// \brief Ordered interval index of locations with the same base pointer.
+///
+/// Each location is identified by its position in a list of locations.
+/// Intervals (see MemoryInterval) of scalar locations are sorted by lower
+/// bounds, the maximum of upper bounds is stored for each prefix of the sorted
+/// list. So, locations which overlap [Lower, Upper) are found with a binary
+/// search followed by a scan which stops as soon as the maximum upper bound of
+/// the remaining prefix is not greater than Lower. Collapsed locations are
+/// grouped by the number of dimensions and by the size of the first dimension,
+/// each group is indexed in the same way by the range of the first dimension.
+///
+/// The index is conservative: all locations which may overlap a specified one
+/// are found, however, some found locations may not overlap it.
+template<class LocationTy, class MemoryInfo = MemorySetInfo<LocationTy>>
+class MemorySetIndex {
+  struct Entry {
+    uint64_t Lower;
+    uint64_t Upper;
+    unsigned Pos;
+  };
+
+  /// List of intervals sorted by lower bounds.
+  class IntervalList {
+  public:
+    bool empty() const noexcept { return mEntries.empty(); }
+
+    void insert(uint64_t Lower, uint64_t Upper, unsigned Pos) {
+      auto I = std::upper_bound(mEntries.begin(), mEntries.end(), Lower,
+        [](uint64_t L, const Entry &E) { return L < E.Lower; });
+      auto Idx = I - mEntries.begin();
+      mEntries.insert(I, Entry{ Lower, Upper, Pos });
+      mMaxUpper.insert(mMaxUpper.begin() + Idx, Upper);
+      updateMaxUpper(Idx);
+    }
+
+    /// Remove an entry for a location at a specified position, return `false`
+    /// if there is no such entry.
+    bool erase(unsigned Pos) {
+      auto I = std::find_if(mEntries.begin(), mEntries.end(),
+        [Pos](const Entry &E) { return E.Pos == Pos; });
+      if (I == mEntries.end())
+        return false;
+      auto Idx = I - mEntries.begin();
+      mEntries.erase(I);
+      mMaxUpper.erase(mMaxUpper.begin() + Idx);
+      updateMaxUpper(Idx);
+      return true;
+    }
+
+    /// Update positions after a new location has been inserted at Pos.
+    void shift(unsigned Pos) {
+      for (auto &E : mEntries)
+        if (E.Pos >= Pos)
+          ++E.Pos;
+    }
+
+    /// Append positions of all locations to a specified list.
+    template<class ListT> void findAll(ListT &Positions) const {
+      for (auto &E : mEntries)
+        Positions.push_back(E.Pos);
+    }
+
+    /// Append positions of locations which overlap [Lower, Upper).
+    template<class ListT>
+    void findOverlapped(uint64_t Lower, uint64_t Upper,
+                        ListT &Positions) const {
+      auto I = std::lower_bound(mEntries.begin(), mEntries.end(), Upper,
+        [](const Entry &E, uint64_t U) { return E.Lower < U; });
+      for (auto Idx = I - mEntries.begin();
+           Idx > 0 && mMaxUpper[Idx - 1] > Lower; --Idx)
+        if (mEntries[Idx - 1].Upper > Lower)
+          Positions.push_back(mEntries[Idx - 1].Pos);
+    }
+
+  private:
+    void updateMaxUpper(std::size_t From) {
+      for (auto Idx = From, EIdx = mEntries.size(); Idx < EIdx; ++Idx)
+        mMaxUpper[Idx] = Idx > 0 ?
+          std::max(mMaxUpper[Idx - 1], mEntries[Idx].Upper) :
+          mEntries[Idx].Upper;
+    }
+
+    std::vector<Entry> mEntries;
+    std::vector<uint64_t> mMaxUpper;
+  };
+
+  /// Groups of collapsed locations (number of dimensions, size of the first
+  /// dimension).
+  using GroupKey = std::pair<uint64_t, uint64_t>;
+  using GroupMap = std::map<GroupKey, IntervalList>;
+
+public:
+  /// Build index for a specified list of locations.
+  explicit MemorySetIndex(llvm::ArrayRef<LocationTy> Locations) {
+    for (std::size_t Pos = 0, EPos = Locations.size(); Pos < EPos; ++Pos)
+      add(Locations[Pos], Pos);
+  }
+
+  /// Update index after a location has been inserted at a specified position.
+  void insert(const LocationTy &Loc, unsigned Pos) {
+    mScalars.shift(Pos);
+    for (auto &Group : mGroups)
+      Group.second.shift(Pos);
+    for (auto &P : mUnknown)
+      if (P >= Pos)
+        ++P;
+    add(Loc, Pos);
+  }
+
+  /// Update index after a location at a specified position has been changed.
+  void update(const LocationTy &Loc, unsigned Pos) {
+    erase(Pos);
+    add(Loc, Pos);
+  }
+
+  /// \brief Find locations which may overlap a specified one.
+  ///
+  /// Positions of found locations are sorted in ascending order, so locations
+  /// are visited in the same order as in a linear scan.
+  template<class Ty>
+  void findOverlapped(const Ty &Loc,
+                      llvm::SmallVectorImpl<unsigned> &Positions) const {
+    auto I = MemoryInfo::getInterval(Loc);
+    Positions.append(mUnknown.begin(), mUnknown.end());
+    if (I.Kind == MemoryInterval::Scalar)
+      mScalars.findOverlapped(I.Lower, I.Upper, Positions);
+    else
+      mScalars.findAll(Positions);
+    for (auto &Group : mGroups)
+      if (I.Kind == MemoryInterval::Collapsed &&
+          Group.first == GroupKey(I.Dims, I.DimSize))
+        Group.second.findOverlapped(I.Lower, I.Upper, Positions);
+      else
+        // Collapsed locations from different groups may overlap, a scalar
+        // location may be delinearized, so it may overlap any collapsed one.
+        Group.second.findAll(Positions);
+    std::sort(Positions.begin(), Positions.end());
+  }
+
+private:
+  void add(const LocationTy &Loc, unsigned Pos) {
+    auto I = MemoryInfo::getInterval(Loc);
+    switch (I.Kind) {
+    case MemoryInterval::Scalar:
+      mScalars.insert(I.Lower, I.Upper, Pos);
+      break;
+    case MemoryInterval::Collapsed:
+      mGroups[GroupKey(I.Dims, I.DimSize)].insert(I.Lower, I.Upper, Pos);
+      break;
+    default:
+      mUnknown.insert(
+        std::lower_bound(mUnknown.begin(), mUnknown.end(), Pos), Pos);
+      break;
+    }
+  }
+
+  void erase(unsigned Pos) {
+    if (mScalars.erase(Pos))
+      return;
+    for (auto I = mGroups.begin(), EI = mGroups.end(); I != EI; ++I)
+      if (I->second.erase(Pos)) {
+        if (I->second.empty())
+          mGroups.erase(I);
+        return;
+      }
+    auto I = std::lower_bound(mUnknown.begin(), mUnknown.end(), Pos);
+    if (I != mUnknown.end() && *I == Pos)
+      mUnknown.erase(I);
+  }
+
+  IntervalList mScalars;
+  GroupMap mGroups;
+  llvm::SmallVector<unsigned, 4> mUnknown;
+};
+}
+#endif//TSAR_MEMORY_SET_INDEX_H
@@ -26,8 +26,52 @@
 #define TSAR_MEMORY_SET_INFO_H
 
 #include "tsar/Analysis/Memory/MemoryLocationRange.h"
+#include <limits>
 
 namespace tsar {
+/// Conservative approximation of a memory location which is used to index
+/// locations in a MemorySet.
+///
+/// Two locations with intervals of the same kind and the same group
+/// (Dims, DimSize) have no intersection if intervals [Lower, Upper) do not
+/// overlap. No assumptions are made about locations with unknown intervals
+/// and about locations with intervals of different kinds or groups.
+struct MemoryInterval {
+  enum IntervalKind : uint8_t {
+    /// Location may overlap any location with the same base pointer.
+    Unknown = 0,
+    /// Interval is a range of bytes [Lower, Upper).
+    Scalar,
+    /// Interval is a range [Lower, Upper) of indexes in the first dimension.
+    Collapsed
+  };
+
+  IntervalKind Kind = Unknown;
+  uint64_t Dims = 0;
+  uint64_t DimSize = 0;
+  uint64_t Lower = 0;
+  uint64_t Upper = 0;
+
+  static MemoryInterval getScalar(uint64_t Lower, uint64_t Upper) {
+    MemoryInterval I;
+    I.Kind = Scalar;
+    I.Lower = Lower;
+    I.Upper = Upper;
+    return I;
+  }
+
+  static MemoryInterval getCollapsed(uint64_t Dims, uint64_t DimSize,
+                                     uint64_t Lower, uint64_t Upper) {
+    MemoryInterval I;
+    I.Kind = Collapsed;
+    I.Dims = Dims;
+    I.DimSize = DimSize;
+    I.Lower = Lower;
+    I.Upper = Upper;
+    return I;
+  }
+};
+
 /// Provide traits for objects stored in a MemorySet.
 ///
 /// Each object in a set is a memory location which starts and ends at specified
@@ -71,6 +115,9 @@ namespace tsar {
 ///     Return the result of intersection of locations A and B.
 /// - static inline void setNonCollapsable(llvm::MemoryLocation &)
 ///     Set `NonCollapsable` kind for a specified location.
+/// - static inline MemoryInterval getInterval(const Ty &)
+///     Return a conservative approximation of a location which is used to
+///     search for overlapped locations without a linear scan of a set.
 /// - Copy-constructor must be also available.
 /// In methods presented above the following denotements are used:
 /// - LocationTy is a type of memory locations which are stored in memory set.
@@ -173,6 +220,9 @@ template<> struct MemorySetInfo<llvm::MemoryLocation> {
   static inline void setNonCollapsable(llvm::MemoryLocation &Loc) {
     return;
   }
+  static inline MemoryInterval getInterval(const llvm::MemoryLocation &) {
+    return MemoryInterval();
+  }
 };
 
 /// Provide specialization of MemorySetInfo for tsar::MemoryLocationRange
@@ -301,6 +351,24 @@ template<> struct MemorySetInfo<MemoryLocationRange> {
     Loc.Kind = MemoryLocationRange::LocKind::NonCollapsable |
                Loc.Kind & MemoryLocationRange::LocKind::Hint;
   }
+  static inline MemoryInterval getInterval(const MemoryLocationRange &Loc) {
+    if (!(Loc.Kind & MemoryLocationRange::LocKind::Collapsed)) {
+      if (!Loc.LowerBound.hasValue() || !Loc.UpperBound.hasValue())
+        return MemoryInterval();
+      return MemoryInterval::getScalar(Loc.LowerBound.getValue(),
+                                       Loc.UpperBound.getValue());
+    }
+    // Intersection of collapsed locations is checked dimension by dimension,
+    // so the first dimension is enough to prove that locations do not overlap.
+    if (Loc.DimList.empty())
+      return MemoryInterval();
+    auto &Dim = Loc.DimList.front();
+    auto End = Dim.Start + Dim.Step * (Dim.TripCount - 1);
+    if (End == std::numeric_limits<uint64_t>::max())
+      return MemoryInterval();
+    return MemoryInterval::getCollapsed(Loc.DimList.size(), Dim.DimSize,
+                                        Dim.Start, End + 1);
+  }
 };
 }
 #endif//TSAR_MEMORY_SET_INFO_H
@@ -234,5 +234,14 @@ ModulePass * createGlobalsAccessCollector();
 // Initialize a pass to access list of explicit accesses to global
 // values in a function.
 void initializeGlobalsAccessWrapperPass(PassRegistry &Registry);
+
+/// Initialize a pass to store a set of cold loops.
+void initializeColdLoopsStoragePass(PassRegistry &Registry);
+
+/// Create a pass to store a set of cold loops.
+ImmutablePass *createColdLoopsStorage();
+
+/// Initialize a pass to access a set of cold loops.
+void initializeColdLoopsWrapperPass(PassRegistry &Registry);
 }
 #endif//TSAR_MEMORY_ANALYSIS_PASSES_H
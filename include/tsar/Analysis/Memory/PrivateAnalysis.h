@@ -33,6 +33,7 @@
 #include "tsar/Analysis/DataFlowGraph.h"
 #include "tsar/ADT/DenseMapTraits.h"
 #include "tsar/ADT/GraphNumbering.h"
+#include "tsar/Analysis/Memory/ColdLoops.h"
 #include "tsar/Analysis/Memory/DefinedMemory.h"
 #include "tsar/Analysis/Memory/DFMemoryLocation.h"
 #include "tsar/Analysis/Memory/IRMemoryTrait.h"
@@ -66,7 +67,6 @@ using PrivateInfo =
 
 namespace detail {
 class DependenceImp;
-struct DependenceCache;
 }
 }
 
@@ -178,6 +178,7 @@ public:
     mDL = nullptr;
     mTLI = nullptr;
     mSE = nullptr;
+    mColdLoops = nullptr;
   }
 
   /// Specifies a list of analyzes  that are necessary for this pass.
@@ -190,8 +191,12 @@ public:
 private:
   /// Uses dependence analysis pass to collect loop-carried dependencies in
   /// a specified loop.
-  void collectDependencies(Loop *L, DependenceMap &Deps,
-    tsar::detail::DependenceCache &Cache);
+  ///
+  /// Dependence tests are not performed for cold loops, conservative
+  /// dependencies are assumed instead. Explicit accesses are grouped by alias
+  /// nodes, so only accesses to locations which may alias are tested.
+  void collectDependencies(Loop *L, const tsar::AliasTreeRelation &AliasSTR,
+    DependenceMap &Deps);
 
   /// Update collection `Deps` of loop-carried dependencies in a specified loop.
   void insertDependence(const Dependence &Dep,
@@ -213,8 +218,7 @@ private:
   /// must be available from mLiveInfo and mDefInfo.
   void resolveCandidats(
     const tsar::GraphNumbering<const tsar::AliasNode *> &Numbers,
-    const tsar::AliasTreeRelation &AliasSTR, tsar::DFRegion *R,
-    tsar::detail::DependenceCache &Cache);
+    const tsar::AliasTreeRelation &AliasSTR, tsar::DFRegion *R);
 
   /// Set HeaderAccess trait for memory locations explicitly accessed in a
   /// loop header.
@@ -357,6 +361,7 @@ private:
   const DataLayout *mDL = nullptr;
   TargetLibraryInfo *mTLI = nullptr;
   ScalarEvolution *mSE = nullptr;
+  const tsar::ColdLoopSet *mColdLoops = nullptr;
 };
 }
 #endif//TSAR_PRIVATE_ANALYSIS_H
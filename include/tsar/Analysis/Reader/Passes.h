@@ -59,5 +59,36 @@ void initializeRegionWeightsEstimatorPass(PassRegistry &Registry);
 
 /// Create a pass to estimate region weights in a source code.
 ModulePass *createRegionWeightsEstimator();
+
+/// Initialize a pass to collect loops which weights are less than
+/// GlobalOptions::LoopParallelThreshold.
+void initializeColdLoopsCollectorPass(PassRegistry &Registry);
+
+/// Create a pass to collect loops which weights are less than
+/// GlobalOptions::LoopParallelThreshold.
+///
+/// Loops are stored in ColdLoopsWrapper, so expensive analysis of such loops
+/// can be skipped.
+ModulePass *createColdLoopsCollector();
+
+/// Initialize a pass to write summaries of functions defined in a module.
+void initializeFunctionSummaryWriterPass(PassRegistry &Registry);
+
+/// Create a pass to write summaries of functions defined in a module.
+///
+/// Summaries are written to a directory specified in
+/// GlobalOptions::SummaryEmit option.
+ModulePass *createFunctionSummaryWriter();
+
+/// Initialize a pass to attach summaries of functions defined in other modules
+/// to declarations of these functions.
+void initializeFunctionSummaryReaderPass(PassRegistry &Registry);
+
+/// Create a pass to attach summaries of functions defined in other modules
+/// to declarations of these functions.
+///
+/// Summaries are read from a directory specified in GlobalOptions::SummaryUse
+/// option.
+ModulePass *createFunctionSummaryReader();
 }
 #endif//TSAR_ANALYSIS_READER_PASSES_H
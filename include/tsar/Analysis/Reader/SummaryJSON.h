@@ -0,0 +1,74 @@
+//===--- SummaryJSON.h ---- Function Summaries In JSON ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines representation of function summaries in JSON format.
+// A summary contains results of interprocedural analysis of a function which
+// are necessary to analyze calls of this function in other translation units.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_SUMMARY_JSON_H
+#define TSAR_SUMMARY_JSON_H
+
+#include <bcl/Json.h>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace tsar {
+namespace trait {
+/// Definition of a JSON-object which represents a summary of a function.
+///
+/// Results of GlobalDefinedMemory analysis are represented in the form of
+/// 'argmemonly', 'readonly' and 'readnone' attributes, NoCapture is a list of
+/// numbers of 'nocapture' arguments. Type is a printed type of a function, it
+/// is used to check that a summary describes a function which is called.
+JSON_OBJECT_BEGIN(FunctionSummary)
+JSON_OBJECT_PAIR_9(FunctionSummary
+  , Name, std::string
+  , Type, std::string
+  , NoIO, bool
+  , AlwaysReturn, bool
+  , NoUnwind, bool
+  , ArgMemOnly, bool
+  , ReadOnly, bool
+  , ReadNone, bool
+  , NoCapture, std::set<unsigned>)
+  FunctionSummary() :
+    JSON_INIT(FunctionSummary, "", "", false, false, false, false, false,
+              false, std::set<unsigned>{}) {}
+JSON_OBJECT_END(FunctionSummary)
+
+/// Definition of a top-level JSON-object which contains summaries of
+/// functions defined in a module.
+JSON_OBJECT_BEGIN(ModuleSummary)
+  JSON_OBJECT_ROOT_PAIR_2(ModuleSummary
+    , Module, std::string
+    , Functions, std::vector<trait::FunctionSummary>
+  )
+  ModuleSummary() : JSON_INIT_ROOT {}
+JSON_OBJECT_END(ModuleSummary)
+}
+}
+
+JSON_DEFAULT_TRAITS(tsar::trait::, FunctionSummary)
+JSON_DEFAULT_TRAITS(tsar::trait::, ModuleSummary)
+
+#endif//TSAR_SUMMARY_JSON_H
@@ -0,0 +1,86 @@
+//===- AnalysisCache.h ----- Persistent Analysis Cache ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a content-addressed on-disk storage of analysis results.
+// Results are keyed by a hash of an analyzed module, global options and
+// a list of requested passes. So, if neither sources nor options have been
+// changed, the whole analysis pipeline can be skipped and stored results
+// can be used instead. Only text printed by analysis passes is stored, so
+// the cache is not used if output passes are requested.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_ANALYSIS_CACHE_H
+#define TSAR_ANALYSIS_CACHE_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Error.h>
+#include <string>
+
+namespace llvm {
+class Module;
+class PassInfo;
+}
+
+namespace tsar {
+struct GlobalOptions;
+
+/// Content-addressed storage of analysis results.
+///
+/// Each entry is a separate file in a cache directory. The name of a file
+/// is a hash which is computed with computeKey().
+class AnalysisCache {
+public:
+  /// Create cache which stores results in a specified directory. The
+  /// directory is created on the first store() if it does not exist.
+  explicit AnalysisCache(llvm::StringRef Dir) : mDir(Dir) {}
+
+  /// Return directory which contains cached results.
+  llvm::StringRef getDirectory() const noexcept { return mDir; }
+
+  /// Compute a key of results which are produced by a specified list of
+  /// passes for a specified module.
+  ///
+  /// The key depends on the whole module (including debug information),
+  /// on global options, on content of files which are used to clarify
+  /// analysis and on the version of the analyzer.
+  static std::string computeKey(const llvm::Module &M,
+                                const GlobalOptions &GO,
+                                llvm::ArrayRef<const llvm::PassInfo *> Passes,
+                                unsigned Steps);
+
+  /// Return results associated with a specified key if they are available.
+  llvm::Optional<std::string> load(llvm::StringRef Key) const;
+
+  /// Associate results with a specified key. Results are written to a
+  /// temporary file at first, so concurrent readers never see partially
+  /// written entries.
+  llvm::Error store(llvm::StringRef Key, llvm::StringRef Data) const;
+
+private:
+  /// Return path to a file which stores results for a specified key.
+  std::string getPath(llvm::StringRef Key) const;
+
+  std::string mDir;
+};
+}
+#endif//TSAR_ANALYSIS_CACHE_H
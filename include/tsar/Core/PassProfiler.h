@@ -0,0 +1,125 @@
+//===- PassProfiler.h ------ Pass Execution Profiler ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a profiler which collects wall time, heap usage and
+// the number of alias queries for each execution of each pass on each
+// function. Collected events can be written in Chrome trace format, so they
+// can be viewed in chrome://tracing or in Perfetto UI.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_PASS_PROFILER_H
+#define TSAR_PASS_PROFILER_H
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/Support/Error.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tsar {
+/// Collector of pass execution events.
+///
+/// There is a single profiler in a process. Events may be registered from
+/// different threads, each thread has its own stack of running passes.
+class PassProfiler {
+  using Clock = std::chrono::steady_clock;
+
+public:
+  /// Execution of a pass on a unit of IR of a specified category (a module,
+  /// a function, a loop, a region or a strongly connected component of
+  /// a call graph).
+  ///
+  /// Function name is empty for modules, for other units it is a name of
+  /// a function the unit belongs to (or names of all functions in an SCC).
+  struct Event {
+    std::string Category;
+    std::string Pass;
+    std::string Function;
+    std::string Module;
+    uint64_t ThreadID;
+    Clock::time_point Start;
+    Clock::duration Duration;
+    /// Difference between heap usage at the end and at the start of a pass.
+    int64_t HeapDelta;
+    /// The highest heap usage which has been observed by the profiler up to
+    /// the end of a pass.
+    size_t PeakHeap;
+    /// Number of queries to alias analysis which have been issued by TSAR
+    /// analyses (see countAliasQuery()).
+    uint64_t AliasQueries;
+  };
+
+  /// Return the profiler.
+  static PassProfiler & get();
+
+  /// Register a query to alias analysis in the current thread.
+  ///
+  /// Analyses call this before each query to AAResults, so all queries are
+  /// counted regardless of an alias analysis which resolves a query.
+  static void countAliasQuery() noexcept;
+
+  /// Start execution of a pass on a unit of IR in the current thread.
+  void enter(llvm::StringRef Category, llvm::StringRef Pass,
+             llvm::StringRef Function, llvm::StringRef Module);
+
+  /// Finish execution of a pass on a function in the current thread.
+  void exit(llvm::StringRef Pass, llvm::StringRef Function);
+
+  /// Write all registered events to a specified file in Chrome trace format.
+  llvm::Error write(llvm::StringRef Path) const;
+
+  /// Write all registered events to a specified stream in Chrome trace format.
+  void write(llvm::raw_ostream &OS) const;
+
+  /// Return the highest heap usage which has been observed by the profiler.
+  size_t getPeakHeap() const;
+
+  /// Remove all registered events and reset the highest heap usage.
+  ///
+  /// This is useful if a process analyzes multiple inputs one by one and
+  /// profiles should be collected separately for each input.
+  void clear();
+
+private:
+  PassProfiler() : mStart(Clock::now()) {}
+
+  void writeUnlocked(llvm::raw_ostream &OS) const;
+
+  const Clock::time_point mStart;
+  mutable std::mutex mMutex;
+  std::vector<Event> mEvents;
+  size_t mPeakHeap = 0;
+};
+
+/// Pass manager which surrounds each module, call graph SCC, function, region
+/// and loop pass with passes which register execution of a pass in
+/// the profiler.
+///
+/// Passes of other kinds (for example, immutable passes) are added to
+/// the manager as is.
+class ProfilingPassManager : public llvm::legacy::PassManager {
+public:
+  void add(llvm::Pass *P) override;
+};
+}
+#endif//TSAR_PASS_PROFILER_H
@@ -38,6 +38,7 @@ class DataLayout;
 class Pass;
 class PassInfo;
 class Module;
+class raw_ostream;
 class raw_pwrite_stream;
 
 namespace legacy {
@@ -233,12 +234,27 @@ public:
     mOutputPasses(OutputPasses), mPrintPasses(PrintPasses),
     mPrintSteps(PrintSteps) {}
 
+  /// Remembers whether remarks are enabled, results are not taken from
+  /// the analysis cache in this case. Diagnostics are remembered to check
+  /// whether analysis emits some warnings which are lost if results are
+  /// taken from the cache.
+  bool beginSourceFile(clang::DiagnosticsEngine &Diags,
+                       llvm::StringRef InputFile, llvm::StringRef OutputFile,
+                       llvm::StringRef WorkingDir) override;
+
   /// Runs default sequence of passes.
   void run(llvm::Module *M, tsar::TransformationInfo *TfmInfo) override;
 
   /// Initializes external storage to access information about import process.
   ASTImportInfo * initializeImportInfo() override { return &mImportInfo; }
 
+  /// Set a stream to print results of analysis passes (the standard error
+  /// stream is used by default).
+  ///
+  /// This is useful if multiple inputs are processed concurrently and
+  /// results should be collected separately for each input.
+  void setPrintStream(llvm::raw_ostream &OS) noexcept { mPrintOS = &OS; }
+
 private:
   /// Updates pass manager. Adds a specified pass and a pass to print its result
   // if `PrintResult` is set to 'true`.
@@ -246,11 +262,14 @@ private:
     llvm::legacy::PassManager &Passes);
 
   bool mUseServer = false;
+  bool mHasRemarks = false;
+  clang::DiagnosticsEngine *mDiags = nullptr;
   PassList mOutputPasses;
   PassList mPrintPasses;
   ProcessingStep mPrintSteps;
   const GlobalOptions *mGlobalOptions;
   ASTImportInfo mImportInfo;
+  llvm::raw_ostream *mPrintOS = nullptr;
 };
 
 /// This prints LLVM IR to the standard output stream.
@@ -36,6 +36,7 @@
 
 namespace llvm {
 class PassInfo;
+class raw_ostream;
 namespace cl {
 class Option;
 }
@@ -63,12 +64,35 @@ public:
   /// execution will be accessed through this object. If it is not set than
   /// default sequence of analysis and transformations will be performed.
   /// \return Zero on success.
+  ///
+  /// If the tool is running in a batch mode, jobs are read from the standard
+  /// input and the specified query manager is ignored.
   int run(QueryManager *QM = nullptr);
 
   /// Return analysis options specified in a command line.
   const GlobalOptions &getGlobalOptions() const noexcept { return mGlobalOpts; }
 
 private:
+  /// Creates a tool to execute a job in a batch mode, the job is configured
+  /// in runBatch().
+  Tool() = default;
+
+  /// \brief Executes jobs which are read from the standard input.
+  ///
+  /// Each line of input is a JSON object which specifies a job, for example,
+  /// {"id": 1, "args": ["-print-only=da-di", "a.c"], "output": "a.txt"}.
+  /// Arguments of each job are parsed in the same way as a command line.
+  /// Results of analysis which should be printed are written to the output
+  /// file if it is specified. Status and latency of each job is reported to
+  /// the standard output as a JSON object in a separate line.
+  ///
+  /// Pass registry, target registry and options are initialized once and
+  /// reused across jobs. A compilation database, statistics and a pass profile
+  /// are collected for each job separately. If options of a job are
+  /// incorrect, the job fails and the next job is executed.
+  /// \return Zero if all jobs have been successfully finished.
+  int runBatch();
+
   /// \brief Stores command line options.
   ///
   /// The Options::get() method returns an object accessed from different
@@ -82,9 +106,11 @@ private:
   /// - Each flag will be stored in a member associated with it.
   /// - Options which should be accessed from different places,
   /// will be stored in GlobalOptions structure.
+  /// \return False if options are incorrect, description of errors is written
+  /// to a specified stream.
   ///
   /// TODO (kaniandr@gmail.com): disallow multiple creation of Tool objects
-  void storeCLOptions();
+  bool storeCLOptions(llvm::raw_ostream &Errs);
 
   /// \brief Store command line options that determine information
   /// to be printed.
@@ -93,8 +119,9 @@ private:
   /// - If some of such options are set it will be added to `IncompatibleOpts`
   /// list. Note, that only one option will be added to this list.
   /// - If some of such options are set `mPrint` flag will be set to `true`.
-  ///
-  void storePrintOptions(OptionList &IncompatibleOpts);
+  /// \return False if options are incorrect, description of errors is written
+  /// to a specified stream.
+  bool storePrintOptions(OptionList &IncompatibleOpts, llvm::raw_ostream &Errs);
 
   std::string mToolName;
   GlobalOptions mGlobalOpts;
@@ -116,6 +143,9 @@ private:
   bool mPrint = false;
   bool mServer = false;
   bool mLoadSources = true;
+  bool mBatch = false;
+  /// Stream to print analysis results (by default, errs() is used).
+  llvm::raw_ostream *mOutput = nullptr;
   std::string mOutputFilename;
   std::string mLanguage;
   std::string mInstrEntry;
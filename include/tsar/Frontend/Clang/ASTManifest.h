@@ -0,0 +1,75 @@
+//===- ASTManifest.h ---- Reuse of Emitted AST Files ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a factory of actions which emit Clang AST files only if
+// previously emitted files are out of date. A manifest is stored next to each
+// emitted file. It contains hashes of compile options and of all input files
+// (a source file and included files) the AST file depends on.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_AST_MANIFEST_H
+#define TSAR_AST_MANIFEST_H
+
+#include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/StringRef.h>
+#include <memory>
+#include <string>
+
+namespace tsar {
+/// Return path to a manifest of a specified AST file.
+std::string getASTManifestPath(llvm::StringRef ASTFile);
+
+/// Return true if a specified AST file has been emitted with options
+/// which have a specified hash and none of its inputs has been changed
+/// since that moment.
+bool isASTUpToDate(llvm::StringRef ASTFile, llvm::StringRef CommandHash);
+
+/// Write manifest for a specified AST file which has been just emitted.
+///
+/// List of input files is read from the AST file.
+llvm::Error writeASTManifest(llvm::StringRef ASTFile,
+                             llvm::StringRef CommandHash,
+                             clang::FileManager &FileMgr,
+                             const clang::PCHContainerReader &PCHContainerRdr);
+
+/// This factory wraps a factory of actions which emit AST files and it
+/// runs a wrapped action only if an output AST file is out of date.
+class ReuseASTActionFactory : public clang::tooling::FrontendActionFactory {
+public:
+  explicit ReuseASTActionFactory(
+      std::unique_ptr<clang::tooling::FrontendActionFactory> Factory)
+      : mFactory(std::move(Factory)) {}
+
+  std::unique_ptr<clang::FrontendAction> create() override {
+    return mFactory->create();
+  }
+
+  bool runInvocation(
+      std::shared_ptr<clang::CompilerInvocation> Invocation,
+      clang::FileManager *Files,
+      std::shared_ptr<clang::PCHContainerOperations> PCHContainerOps,
+      clang::DiagnosticConsumer *DiagConsumer) override;
+
+private:
+  std::unique_ptr<clang::tooling::FrontendActionFactory> mFactory;
+};
+}
+#endif//TSAR_AST_MANIFEST_H
@@ -47,12 +47,19 @@ namespace tsar {
 /// context, producing a merged context. This action is an action
 /// adapter, which forwards most of its calls to another action that
 /// will consume the merged context.
+///
+/// AST files are loaded concurrently in a specified number of threads,
+/// however declarations are imported into the merged context one file after
+/// another in the order of files in a list.
 class ASTMergeAction : public PublicWrapperFrontendAction {
 public:
   /// Creates adapter for a specified action, this adapter merge all
   /// files from a specified set.
+  ///
+  /// If NumThreads is 0 all available hardware threads are used to load
+  /// AST files.
   ASTMergeAction(std::unique_ptr<clang::FrontendAction> WrappedAction,
-    clang::ArrayRef<std::string> ASTFiles);
+    clang::ArrayRef<std::string> ASTFiles, unsigned NumThreads = 1);
 
   /// This action can not evaluate LLVM IR.
   bool hasIRSupport() const override { return false; }
@@ -89,6 +96,7 @@ protected:
     clang::DiagnosticsEngine &Diags) const;
 
   std::vector<std::string> mASTFiles;
+  unsigned mNumThreads;
 };
 
 struct ASTImportInfo;
@@ -101,8 +109,10 @@ public:
   /// files from a specified set and store some information about the import
   /// process in a specified external storage.
   ASTMergeActionWithInfo(std::unique_ptr<clang::FrontendAction> WrappedAction,
-      clang::ArrayRef<std::string> ASTFiles, ASTImportInfo *Out) :
-    ASTMergeAction(std::move(WrappedAction), ASTFiles), mImportInfo(Out) {
+      clang::ArrayRef<std::string> ASTFiles, ASTImportInfo *Out,
+      unsigned NumThreads = 1) :
+    ASTMergeAction(std::move(WrappedAction), ASTFiles, NumThreads),
+    mImportInfo(Out) {
     assert(mImportInfo && "External storage must not be null!");
   }
 
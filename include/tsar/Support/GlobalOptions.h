@@ -86,12 +86,43 @@ struct GlobalOptions {
   /// If profile is available, this value specify the lowest weight of loops
   /// will be parallelized.
   unsigned LoopParallelThreshold = 0;
+  /// Skip expensive dependence tests in loops which weight is less than
+  /// LoopParallelThreshold. A profile must be available to estimate weights.
+  bool HotLoopsOnly = false;
+  /// Use a worklist solver instead of repeated sweeps over all nodes to solve
+  /// data-flow problems for regions with cycles (results are the same).
+  bool WorklistDataFlow = false;
+  /// Try to delinearize array references in dependence analysis.
+  bool Delinearize = true;
+  /// Maximum number of steps of the exact integer dependence test for a pair
+  /// of instructions (0 disables the test).
+  unsigned ExactDependenceBudget = 512;
   /// List of regions which should be optimized.
   std::vector<std::string> OptRegions;
+  /// Reuse results of interprocedural analysis for functions which have not
+  /// been changed since the previous step of the analysis pipeline. Results
+  /// are not kept between separate runs of the tool.
+  bool IncrementalAnalysis = false;
+  /// Directory to store text printed by analysis passes and to replay it in
+  /// the following runs if an analyzed module has not been changed. Results
+  /// are keyed by a whole module, and output passes bypass the cache.
+  std::string AnalysisCache = "";
+  /// Directory to write summaries of functions defined in analyzed modules
+  /// (dependence analysis is not performed if it is not empty).
+  std::string SummaryEmit = "";
+  /// Directory with summaries of functions defined in other modules which are
+  /// used to analyze calls of these functions.
+  std::string SummaryUse = "";
   /// This suffix should be add to transformed sources before extension.
   std::string OutputSuffix = "";
   /// Disable formatting of a source code after transformation.
   bool NoFormat = false;
+  /// Number of threads which can be used to process independent inputs
+  /// concurrently (0 means that all available cores are used).
+  unsigned NumThreads = 1;
+  /// File to store profile of analysis passes in Chrome trace format
+  /// (profiling is disabled if it is empty).
+  std::string PassProfile = "";
 };
 }
 
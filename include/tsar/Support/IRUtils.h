@@ -28,7 +28,12 @@
 #include <llvm/Analysis/LoopInfo.h>
 #include <llvm/IR/Constants.h>
 #include <llvm/IR/Type.h>
+#include <llvm/IR/ValueHandle.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/MD5.h>
+#include <memory>
+#include <vector>
 
 namespace tsar {
 /// Returns argument with a specified number or nullptr.
@@ -77,6 +82,77 @@ llvm::Type *getPointerElementType(const llvm::Value &V);
 /// available inside a specific loop.
 bool pointsToLocalMemory(const llvm::Value &V, const llvm::Loop &L);
 
+/// Fingerprint of a function body.
+using FunctionFingerprint = llvm::MD5::MD5Result;
+
+/// Compute fingerprint of a specified function.
+///
+/// Fingerprint takes into account the structure of a function: instructions
+/// and their operands (values defined in the function are numbered, constants
+/// are compared by value and globals by name), attributes, indices of
+/// aggregates, masks of shuffles and attached metadata. Addresses of values
+/// are not taken into account, so use FunctionFingerprintMap to check that
+/// values of a function have not been recreated.
+FunctionFingerprint computeFingerprint(const llvm::Function &F);
+
+/// \brief Fingerprints of functions which are valid while values of these
+/// functions are alive.
+///
+/// Results which are reused for an unchanged function may refer to its values.
+/// So, value handles are attached to a function, its arguments, basic blocks
+/// and instructions, and a fingerprint is invalidated as soon as one of these
+/// values is deleted or replaced with another value. If a fingerprint is
+/// still valid and it is equal to the current one, the function has not been
+/// changed and all pointers to its values refer to the same values.
+class FunctionFingerprintMap {
+public:
+  /// Return true if a specified function has a valid fingerprint which is
+  /// equal to a specified one.
+  bool isUnchanged(const llvm::Function &F,
+                   const FunctionFingerprint &Fingerprint) const;
+
+  /// Remember a fingerprint of a function and start tracking of its values.
+  ///
+  /// If a function is unchanged in a specified map of previous fingerprints,
+  /// its values are already tracked and the handles are moved from there.
+  void insert(llvm::Function &F, const FunctionFingerprint &Fingerprint,
+              FunctionFingerprintMap *Prev = nullptr);
+
+  /// Forget all fingerprints and stop tracking of values.
+  void clear() { mFunctions.clear(); }
+
+private:
+  /// Marks a fingerprint as invalid if a tracked value is deleted or
+  /// replaced with another value.
+  class ValueTracker final : public llvm::CallbackVH {
+  public:
+    ValueTracker(llvm::Value *V, bool &IsValid)
+        : llvm::CallbackVH(V), mIsValid(&IsValid) {}
+
+    void deleted() override {
+      *mIsValid = false;
+      llvm::CallbackVH::deleted();
+    }
+
+    void allUsesReplacedWith(llvm::Value *) override { *mIsValid = false; }
+
+  private:
+    bool *mIsValid;
+  };
+
+  struct FunctionInfo {
+    FunctionFingerprint Fingerprint;
+    bool IsValid = true;
+    std::vector<ValueTracker> Values;
+  };
+
+  /// A fingerprint of a deleted function is invalid, so an entry which refers
+  /// to a released function never matches a function which has been
+  /// allocated at the same address.
+  llvm::DenseMap<const llvm::Function *, std::unique_ptr<FunctionInfo>>
+      mFunctions;
+};
+
 namespace detail {
 /// Applies a specified function object to each loop in a loop tree.
 template<class Function>
@@ -0,0 +1,113 @@
+//===- IntegerSystem.h ---- System of Integer Constraints -------*- C++ -*-===//
+//
+//                     Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a system of linear constraints over integer variables
+// and a check whether the system has an integer solution. The check follows
+// the Omega test (W. Pugh, The Omega Test: a fast and practical integer
+// programming algorithm for dependence analysis, 1991).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_INTEGER_SYSTEM_H
+#define TSAR_INTEGER_SYSTEM_H
+
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallVector.h>
+#include <cstdint>
+
+namespace llvm {
+class raw_ostream;
+}
+
+namespace tsar {
+/// \brief System of linear constraints over integer variables.
+///
+/// Each constraint is an equality a_1*x_1 + ... + a_n*x_n + c = 0 or an
+/// inequality a_1*x_1 + ... + a_n*x_n + c >= 0, where all coefficients are
+/// integer constants.
+class IntegerSystem {
+public:
+  using CoefficientT = std::int64_t;
+
+  /// Result of a feasibility check.
+  enum FeasibilityKind : uint8_t {
+    /// There is an integer solution of the system.
+    Feasible,
+    /// There is no integer solution of the system.
+    Infeasible,
+    /// The check has not been completed due to exhausted budget or
+    /// overflow of an intermediate coefficient.
+    Unknown
+  };
+
+  /// Linear constraint, the last element of `Coeffs` is a constant term.
+  struct Constraint {
+    llvm::SmallVector<CoefficientT, 8> Coeffs;
+    bool IsEquality;
+  };
+
+  /// Create a system without constraints of a specified number of variables.
+  explicit IntegerSystem(unsigned NumVars) : mNumVars(NumVars) {}
+
+  /// Return number of variables.
+  unsigned getNumVars() const noexcept { return mNumVars; }
+
+  /// Return number of constraints.
+  unsigned getNumConstraints() const noexcept { return mConstraints.size(); }
+
+  /// Add constraint Coeffs * x + Const = 0.
+  void addEquality(llvm::ArrayRef<CoefficientT> Coeffs, CoefficientT Const) {
+    addConstraint(Coeffs, Const, true);
+  }
+
+  /// Add constraint Coeffs * x + Const >= 0.
+  void addInequality(llvm::ArrayRef<CoefficientT> Coeffs, CoefficientT Const) {
+    addConstraint(Coeffs, Const, false);
+  }
+
+  /// Add constraint Lower <= x_Var <= Upper.
+  void addBounds(unsigned Var, CoefficientT Lower, CoefficientT Upper);
+
+  /// Add constraint Lower <= x_Var.
+  void addLowerBound(unsigned Var, CoefficientT Lower);
+
+  /// \brief Check whether the system has an integer solution.
+  ///
+  /// Each produced constraint and each change of variables consumes a unit
+  /// of a specified budget. If the budget is exhausted, `Unknown` is
+  /// returned. Note, that the remaining budget is updated, so the same
+  /// budget can be shared between multiple checks.
+  FeasibilityKind isFeasible(unsigned &Budget) const;
+
+  /// Print the system.
+  void print(llvm::raw_ostream &OS) const;
+
+  /// Print the system to debug stream.
+  void dump() const;
+
+private:
+  void addConstraint(llvm::ArrayRef<CoefficientT> Coeffs, CoefficientT Const,
+                     bool IsEquality);
+
+  unsigned mNumVars;
+  llvm::SmallVector<Constraint, 8> mConstraints;
+};
+}
+#endif//TSAR_INTEGER_SYSTEM_H
@@ -262,9 +262,6 @@ bool MemoryMatcherPass::runOnModule(llvm::Module &M) {
       }
     }
   }
-  tsar::ListBimap<
-    bcl::tagged<clang::VarDecl*, tsar::AST>,
-    bcl::tagged<llvm::Value *, tsar::IR>> MM;
   for (auto &&[V, Decls] : Globals)
     MatchInfo.Matcher.emplace(std::move(Decls), V);
   return false;
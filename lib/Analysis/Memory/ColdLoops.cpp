@@ -0,0 +1,68 @@
+//===--- ColdLoops.cpp ------ Cold Loops Storage ----------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a storage of loops which weights are too small to be
+// worth precise analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Memory/ColdLoops.h"
+#include "tsar/Analysis/Memory/Passes.h"
+#include <bcl/utility.h>
+#include <llvm/Pass.h>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+class ColdLoopsStorage : public ImmutablePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  ColdLoopsStorage() : ImmutablePass(ID) {
+    initializeColdLoopsStoragePass(*PassRegistry::getPassRegistry());
+  }
+
+  void initializePass() override {
+    getAnalysis<ColdLoopsWrapper>().set(mLoops);
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<ColdLoopsWrapper>();
+    AU.setPreservesAll();
+  }
+
+private:
+  ColdLoopSet mLoops;
+};
+}
+
+char ColdLoopsStorage::ID = 0;
+INITIALIZE_PASS_BEGIN(ColdLoopsStorage, "cold-loops-is",
+  "Cold Loops Storage", true, true)
+INITIALIZE_PASS_DEPENDENCY(ColdLoopsWrapper)
+INITIALIZE_PASS_END(ColdLoopsStorage, "cold-loops-is",
+  "Cold Loops Storage", true, true)
+
+template<> char ColdLoopsWrapper::ID = 0;
+INITIALIZE_PASS(ColdLoopsWrapper, "cold-loops-iw",
+  "Cold Loops Storage (Immutable Wrapper)", true, true)
+
+ImmutablePass *llvm::createColdLoopsStorage() { return new ColdLoopsStorage; }
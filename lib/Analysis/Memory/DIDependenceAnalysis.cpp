@@ -520,11 +520,7 @@ AliasNode * findBoundAliasNode(AliasTree &AT,
   }
   if (BoundNodes.empty())
     return nullptr;
-  using NodeItr = bcl::IteratorDataAdaptor<
-    SmallPtrSetImpl<AliasNode *>::iterator,
-    AliasTree *, GraphTraits<Inverse<AliasTree *>>::NodeRef>;
-  AliasNode *AN = *findLCA(AliasSTR,
-    NodeItr{ BoundNodes.begin(), &AT }, NodeItr{ BoundNodes.end(), &AT });
+  AliasNode *AN = *AliasSTR.findLCA(BoundNodes.begin(), BoundNodes.end());
   auto InBoundNodesItr = std::find_if(AN->child_begin(), AN->child_end(),
       [&AliasSTR, &BoundNodes](AliasNode &N) {
     return &N == *BoundNodes.begin() ||
@@ -33,7 +33,6 @@
 #include "tsar/Support/MetadataUtils.h"
 #include "tsar/Support/Utils.h"
 #include "tsar/Unparse/Utils.h"
-#include <bcl/IteratorDataAdaptor.h>
 #include <llvm/ADT/DepthFirstIterator.h>
 #include <llvm/ADT/Statistic.h>
 #include <llvm/ADT/SCCIterator.h>
@@ -1739,11 +1738,7 @@ void CorruptedMemoryResolver::collapseChildStack(const DIAliasNode &Parent,
     Nodes.push_back(CI.ParentOfUnknown);
     mChildStack.pop_back();
   }
-  using NodeItr = bcl::IteratorDataAdaptor<
-    SmallVectorImpl<AliasNode *>::iterator,
-    AliasTree *, GraphTraits<Inverse<AliasTree *>>::NodeRef>;
-  Info.ParentOfUnknown = *findLCA(AliasSTR,
-    NodeItr{ Nodes.begin(), mAT }, NodeItr{ Nodes.end(), mAT });
+  Info.ParentOfUnknown = *AliasSTR.findLCA(Nodes.begin(), Nodes.end());
   LLVM_DEBUG(dbgs() << "[DI ALIAS TREE]: push node information to stack\n");
   LLVM_DEBUG(Info.sizeLog());
   mChildStack.push_back(std::move(Info));
@@ -1790,24 +1785,16 @@ void CorruptedMemoryResolver::aliasTreeBasedHint(
   LLVM_DEBUG(dbgs() << "[DI ALIAS TREE]: determine alias tree based hint\n");
   auto PrevParentOfUnknown = Info.ParentOfUnknown;
   if (Info.ParentOfUnknown != mAT->getTopLevelNode()) {
-    using NodeItr = bcl::IteratorDataAdaptor<
-      SmallPtrSetImpl<AliasNode *>::iterator,
-      AliasTree *, GraphTraits<Inverse<AliasTree *>>::NodeRef>;
     AliasNode *LCA = Info.NodesWL.count(mAT->getTopLevelNode()) ?
       mAT->getTopLevelNode() :
-      *findLCA(AliasSTR,
-        NodeItr{ Info.NodesWL.begin(), mAT },
-        NodeItr{ Info.NodesWL.end(), mAT });
+      *AliasSTR.findLCA(Info.NodesWL.begin(), Info.NodesWL.end());
     if (Info.ParentOfUnknown) {
       switch (AliasSTR.compare(Info.ParentOfUnknown, LCA)) {
       default:
       {
-        using NodeItr = bcl::IteratorDataAdaptor<
-          std::array<AliasNode *, 2>::iterator,
-          AliasTree *, GraphTraits<Inverse<AliasTree *>>::NodeRef>;
         std::array<AliasNode *, 2> NodePair{ LCA, Info.ParentOfUnknown };
-        Info.ParentOfUnknown = *findLCA(AliasSTR,
-          NodeItr{ NodePair.begin(), mAT }, NodeItr{ NodePair.end(), mAT });
+        Info.ParentOfUnknown =
+          *AliasSTR.findLCA(NodePair.begin(), NodePair.end());
         break;
       }
       case TreeRelation::TR_DESCENDANT: Info.ParentOfUnknown = LCA; break;
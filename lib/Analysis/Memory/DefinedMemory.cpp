@@ -28,12 +28,14 @@
 #include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/MemoryAccessUtils.h"
 #include "tsar/Analysis/Memory/Utils.h"
+#include "tsar/Core/PassProfiler.h"
 #include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/Utils.h"
 #include "tsar/Support/IRUtils.h"
 #include "tsar/Support/SCEVUtils.h"
 #include "tsar/Unparse/Utils.h"
 #include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/AliasAnalysis.h>
 #include <llvm/Analysis/AliasSetTracker.h>
 #include <llvm/Analysis/LoopInfo.h>
@@ -55,6 +57,9 @@ using namespace tsar;
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "def-mem"
 
+STATISTIC(NumReachTransfers,
+  "Number of evaluated transfer functions in reaching definition analysis");
+
 char DefinedMemoryPass::ID = 0;
 INITIALIZE_PASS_BEGIN(DefinedMemoryPass, "def-mem",
   "Defined Memory Region Analysis", false, true)
@@ -80,14 +85,16 @@ bool llvm::DefinedMemoryPass::runOnFunction(Function & F) {
   auto &DL = F.getParent()->getDataLayout();
   auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
   auto &GDM = getAnalysis<GlobalDefinedMemoryWrapper>();
+  auto Solver = GO.WorklistDataFlow ? DFSolverKind::Worklist
+                                    : DFSolverKind::Iterative;
   if (GDM) {
     ReachDFFwk ReachDefFwk(AliasTree, TLI, RegionInfo, DT, DI, SE, DL, GO,
                            mDefInfo, *GDM);
-    solveDataFlowUpward(&ReachDefFwk, DFF);
+    NumReachTransfers += solveDataFlowUpward(&ReachDefFwk, DFF, Solver);
   } else {
     ReachDFFwk ReachDefFwk(AliasTree, TLI, RegionInfo, DT, DI, SE, DL, GO,
                            mDefInfo);
-    solveDataFlowUpward(&ReachDefFwk, DFF);
+    NumReachTransfers += solveDataFlowUpward(&ReachDefFwk, DFF, Solver);
   }
   return false;
 }
@@ -221,6 +228,7 @@ public:
         // repeated.
         if (mDU.hasDef(ALoc))
           continue;
+        PassProfiler::countAliasQuery();
         switch (mAA.getModRefInfo(&mInst, ALoc)) {
         case ModRefInfo::ModRef: mDU.addUse(ALoc); mDU.addMayDef(ALoc); break;
         case ModRefInfo::Mod: mDU.addMayDef(ALoc); break;
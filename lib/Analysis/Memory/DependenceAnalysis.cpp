@@ -57,8 +57,11 @@
 #include "tsar/Analysis/Memory/DependenceAnalysis.h"
 #include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/Utils.h"
+#include "tsar/Core/PassProfiler.h"
 #include "tsar/Support/SCEVUtils.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/IntegerSystem.h"
+#include "tsar/Support/NumericUtils.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
@@ -73,10 +76,14 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/InitializePasses.h"
-#include "llvm/Support/CommandLine.h"
+#include "llvm/Pass.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
+#include <mutex>
 
 using namespace llvm;
 using namespace tsar;
@@ -118,10 +125,91 @@ STATISTIC(GCDindependence, "GCD independence");
 STATISTIC(BanerjeeApplications, "Banerjee applications");
 STATISTIC(BanerjeeIndependence, "Banerjee independence");
 STATISTIC(BanerjeeSuccesses, "Banerjee successes");
+STATISTIC(ExactApplications, "Exact test applications");
+STATISTIC(ExactIndependence, "Exact test independence");
+STATISTIC(ExactRefinements, "Exact test direction refinements");
+STATISTIC(ExactGiveUps, "Exact test exhausted budgets");
+STATISTIC(DependsQueries, "Memoized dependence queries");
+STATISTIC(DependsCacheHits, "Memoized dependence query hits");
+STATISTIC(ClassifyQueries, "Subscript pair classifications");
+STATISTIC(ClassifyCacheHits, "Subscript pair classification cache hits");
+STATISTIC(ZIVCacheHits, "ZIV test cache hits");
+
+/// Return options of dependence analysis, default options are used if
+/// options have not been specified.
+static const GlobalOptions &getOptions(const GlobalOptions *GO) {
+  static const GlobalOptions DefaultOptions;
+  return GO ? *GO : DefaultOptions;
+}
 
-static cl::opt<bool>
-    Delinearize("delinearize-da", cl::init(true), cl::Hidden, cl::ZeroOrMore,
-                cl::desc("Try to delinearize array references."));
+//===----------------------------------------------------------------------===//
+// timers
+
+namespace {
+/// \brief Pool of timers of dependence tests.
+///
+/// Dependence tests are invoked lazily from different passes, so their time
+/// is reported separately when time of passes is measured. Tests may run in
+/// multiple threads at once (for example, independent loop nests or batch
+/// jobs are processed concurrently), however, a timer can not be started
+/// twice. So, each running test acquires its own timer from the pool.
+/// Timers are reused and they are destroyed on llvm_shutdown() alongside
+/// with other named timers, so the group is printed once.
+class DATimerPool {
+public:
+  enum TimerKind : unsigned { Depends = 0, Exact, NumTimerKinds };
+
+  Timer *acquire(TimerKind K) {
+    std::lock_guard<std::mutex> Lock(mLock);
+    auto &Free{mFree[K]};
+    if (!Free.empty())
+      return Free.pop_back_val();
+    static const char *Names[NumTimerKinds][2]{
+      {"depends", "Dependence Test"}, {"exact", "Exact Dependence Test"}};
+    mTimers.push_back(std::make_unique<Timer>(Names[K][0], Names[K][1],
+                                              mGroup));
+    return mTimers.back().get();
+  }
+
+  void release(TimerKind K, Timer *T) {
+    std::lock_guard<std::mutex> Lock(mLock);
+    mFree[K].push_back(T);
+  }
+
+private:
+  TimerGroup mGroup{"tsar-da", "Dependence Analysis (TSAR)"};
+  std::mutex mLock;
+  std::vector<std::unique_ptr<Timer>> mTimers;
+  SmallVector<Timer *, 4> mFree[NumTimerKinds];
+};
+
+static ManagedStatic<DATimerPool> DATimers;
+
+/// Measure time of a region if time of passes is measured.
+class DATimeRegion {
+public:
+  explicit DATimeRegion(DATimerPool::TimerKind K) : mKind(K) {
+    if (!TimePassesIsEnabled)
+      return;
+    mTimer = DATimers->acquire(K);
+    mTimer->startTimer();
+  }
+
+  ~DATimeRegion() {
+    if (!mTimer)
+      return;
+    mTimer->stopTimer();
+    DATimers->release(mKind, mTimer);
+  }
+
+  DATimeRegion(const DATimeRegion &) = delete;
+  DATimeRegion & operator=(const DATimeRegion &) = delete;
+
+private:
+  DATimerPool::TimerKind mKind;
+  Timer *mTimer = nullptr;
+};
+}
 
 //===----------------------------------------------------------------------===//
 // basics
@@ -667,6 +755,7 @@ static AliasResult underlyingObjectsAlias(AliasAnalysis *AA,
   // tbaa, incompatible underlying object locations, etc.
   MemoryLocation LocAS(LocA.Ptr, MemoryLocation::UnknownSize, LocA.AATags);
   MemoryLocation LocBS(LocB.Ptr, MemoryLocation::UnknownSize, LocB.AATags);
+  PassProfiler::countAliasQuery();
   if (AA->alias(LocAS, LocBS) == AliasResult::NoAlias)
     return AliasResult::NoAlias;
 
@@ -1024,6 +1113,24 @@ DependenceInfo::classifyPair(const SCEV *Src, const Loop *SrcLoopNest,
                              const SCEV *Dst, const Loop *DstLoopNest,
                              SmallBitVector &Loops,
                              short unsigned *ConfusedLevels) {
+  // Classification depends on loop nests only, so the same pairs of
+  // subscripts are not classified twice for different pairs of accesses.
+  ++ClassifyQueries;
+  auto Key{std::make_tuple(Src, SrcLoopNest, Dst, DstLoopNest,
+                           unsigned(ConfusedLevels != nullptr))};
+  auto CacheItr{ClassificationCache.find(Key)};
+  if (CacheItr != ClassificationCache.end()) {
+    ++ClassifyCacheHits;
+    auto &Cached{CacheItr->second};
+    if (Cached.Kind != Subscript::NonLinear) {
+      Loops = Cached.Loops;
+      if (ConfusedLevels)
+        *ConfusedLevels = Cached.ConfusedLevels;
+    }
+    return Cached.Kind;
+  }
+  auto &Cached{ClassificationCache[Key]};
+  Cached.Kind = Subscript::NonLinear;
   SmallBitVector SrcLoops(MaxLevels + 1);
   SmallBitVector DstLoops(MaxLevels + 1);
   short unsigned SrcConfusedLevels = 0, DstConfusedLevels = 0;
@@ -1046,16 +1153,20 @@ DependenceInfo::classifyPair(const SCEV *Src, const Loop *SrcLoopNest,
     *ConfusedLevels = Level;
   Loops = SrcLoops;
   Loops |= DstLoops;
+  Cached.Loops = Loops;
+  Cached.ConfusedLevels = Level;
   unsigned N = Loops.count();
   if (N == 0)
-    return Subscript::ZIV;
-  if (N == 1)
-    return Subscript::SIV;
-  if (N == 2 && (SrcLoops.count() == 0 ||
-                 DstLoops.count() == 0 ||
-                 (SrcLoops.count() == 1 && DstLoops.count() == 1)))
-    return Subscript::RDIV;
-  return Subscript::MIV;
+    Cached.Kind = Subscript::ZIV;
+  else if (N == 1)
+    Cached.Kind = Subscript::SIV;
+  else if (N == 2 && (SrcLoops.count() == 0 ||
+                      DstLoops.count() == 0 ||
+                      (SrcLoops.count() == 1 && DstLoops.count() == 1)))
+    Cached.Kind = Subscript::RDIV;
+  else
+    Cached.Kind = Subscript::MIV;
+  return Cached.Kind;
 }
 
 
@@ -1209,11 +1320,25 @@ bool DependenceInfo::testZIV(const SCEV *Src, const SCEV *Dst,
   LLVM_DEBUG(dbgs() << "    src = " << *Src << "\n");
   LLVM_DEBUG(dbgs() << "    dst = " << *Dst << "\n");
   ++ZIVapplications;
-  if (isKnownPredicate(CmpInst::ICMP_EQ, Src, Dst)) {
+  auto CacheItr{ZIVCache.find(std::make_pair(Src, Dst))};
+  ZIVOutcome Outcome;
+  if (CacheItr != ZIVCache.end()) {
+    ++ZIVCacheHits;
+    Outcome = CacheItr->second;
+  } else {
+    if (isKnownPredicate(CmpInst::ICMP_EQ, Src, Dst))
+      Outcome = ZIVOutcome::Dependent;
+    else if (isKnownPredicate(CmpInst::ICMP_NE, Src, Dst))
+      Outcome = ZIVOutcome::Independent;
+    else
+      Outcome = ZIVOutcome::Unknown;
+    ZIVCache.try_emplace(std::make_pair(Src, Dst), Outcome);
+  }
+  if (Outcome == ZIVOutcome::Dependent) {
     LLVM_DEBUG(dbgs() << "    provably dependent\n");
     return false; // provably dependent
   }
-  if (isKnownPredicate(CmpInst::ICMP_NE, Src, Dst)) {
+  if (Outcome == ZIVOutcome::Independent) {
     LLVM_DEBUG(dbgs() << "    provably independent\n");
     ++ZIVindependence;
     return true; // provably independent
@@ -3132,6 +3257,141 @@ const SCEV *DependenceInfo::getUpperBound(BoundInfo *Bound) const {
 }
 
 
+//===----------------------------------------------------------------------===//
+// testExact -
+// Tests all linear subscript pairs simultaneously with an exact integer
+// programming test (the Omega test). It is the last and the most expensive
+// test, so it is applied only if cheaper tests have not disproved
+// a loop-carried dependence.
+//
+// Each loop surrounding the source or the destination gives a variable,
+// which is a normalized iteration number in range [0, backedge-taken count].
+// Common loops give two variables, one for the source and one for the
+// destination. Each subscript pair gives an equality. Subscripts which are
+// not affine, which have symbolic coefficients or which may wrap (equalities
+// are built over integers) are ignored, so the system is relaxed and the test
+// remains conservative.
+//
+// If the system has an integer solution, each direction at each common
+// level is checked separately and impossible directions are removed.
+//
+// Return true if dependence disproved.
+bool DependenceInfo::testExact(ArrayRef<Subscript> Pairs,
+                               const Instruction *Src,
+                               const Instruction *Dst,
+                               FullDependence &Result) const {
+  DATimeRegion T(DATimerPool::Exact);
+  ++ExactApplications;
+  // Levels of the source are numbered from 1 to SrcLevels, the remaining
+  // levels of the destination are numbered from SrcLevels + 1 to MaxLevels.
+  // So, variables for common levels of the destination are placed after
+  // MaxLevels.
+  unsigned NumVars = MaxLevels + CommonLevels;
+  auto getVar = [this](unsigned Level, bool IsSrc) {
+    return IsSrc || Level > CommonLevels ? Level - 1
+                                         : MaxLevels + Level - 1;
+  };
+  IntegerSystem System(NumVars);
+  auto *Int64Ty = Type::getInt64Ty(F->getContext());
+  auto addBounds = [this, &System, &getVar, Int64Ty](const Loop *L,
+                                                     bool IsSrc) {
+    for (; L; L = L->getParentLoop()) {
+      auto Var = getVar(IsSrc ? mapSrcLoop(L) : mapDstLoop(L), IsSrc);
+      std::int64_t UB;
+      auto *Bound = collectConstantUpperBound(L, Int64Ty);
+      if (Bound && tsar::castSCEV(Bound, false, UB))
+        System.addBounds(Var, 0, UB);
+      else
+        System.addLowerBound(Var, 0);
+    }
+  };
+  auto *SrcLoopNest = LI->getLoopFor(Src->getParent());
+  auto *DstLoopNest = LI->getLoopFor(Dst->getParent());
+  addBounds(SrcLoopNest, true);
+  addBounds(DstLoopNest, false);
+  SmallVector<std::int64_t, 8> Coeffs;
+  auto collectCoefficients = [this, &Coeffs, &getVar](
+      const SCEV *&Expr, const Loop *LoopNest, bool IsSrc) {
+    while (auto *AddRec = dyn_cast<SCEVAddRecExpr>(Expr)) {
+      auto *L = AddRec->getLoop();
+      std::int64_t Step;
+      if (!AddRec->isAffine() || !AddRec->hasNoSignedWrap() || !LoopNest ||
+          !L->contains(LoopNest) ||
+          !tsar::castSCEV(AddRec->getStepRecurrence(*SE), true, Step))
+        return false;
+      auto Var = getVar(IsSrc ? mapSrcLoop(L) : mapDstLoop(L), IsSrc);
+      if ((!IsSrc && SubOverflow(std::int64_t(0), Step, Step)) ||
+          AddOverflow(Coeffs[Var], Step, Coeffs[Var]))
+        return false;
+      Expr = AddRec->getStart();
+    }
+    return true;
+  };
+  unsigned NumEqualities = 0;
+  for (auto &P : Pairs) {
+    if (P.Classification == Subscript::NonLinear)
+      continue;
+    Coeffs.assign(NumVars, 0);
+    auto *SrcRest = P.Src, *DstRest = P.Dst;
+    std::int64_t Const;
+    if (!collectCoefficients(SrcRest, SrcLoopNest, true) ||
+        !collectCoefficients(DstRest, DstLoopNest, false) ||
+        SrcRest->getType() != DstRest->getType() ||
+        !tsar::castSCEV(SE->getMinusSCEV(SrcRest, DstRest), true, Const))
+      continue;
+    System.addEquality(Coeffs, Const);
+    ++NumEqualities;
+  }
+  if (NumEqualities == 0)
+    return false;
+  LLVM_DEBUG(dbgs() << "    exact test system:\n"; System.print(dbgs()));
+  unsigned Budget = getOptions(GO).ExactDependenceBudget;
+  auto Res = System.isFeasible(Budget);
+  if (Res == IntegerSystem::Infeasible) {
+    ++ExactIndependence;
+    return true;
+  }
+  if (Res == IntegerSystem::Unknown) {
+    ++ExactGiveUps;
+    return false;
+  }
+  for (unsigned Level = 1; Level <= CommonLevels; ++Level) {
+    if (!(Result.DV[Level - 1].Direction &
+          (Dependence::DVEntry::LT | Dependence::DVEntry::GT)))
+      continue;
+    auto SrcVar = getVar(Level, true), DstVar = getVar(Level, false);
+    for (unsigned Dir : {Dependence::DVEntry::LT, Dependence::DVEntry::EQ,
+                         Dependence::DVEntry::GT}) {
+      if (!(Result.DV[Level - 1].Direction & Dir))
+        continue;
+      // Src iteration is less than Dst iteration for the '<' direction.
+      IntegerSystem Refined(System);
+      Coeffs.assign(NumVars, 0);
+      Coeffs[SrcVar] = Dir == Dependence::DVEntry::GT ? 1 : -1;
+      Coeffs[DstVar] = -Coeffs[SrcVar];
+      if (Dir == Dependence::DVEntry::EQ)
+        Refined.addEquality(Coeffs, 0);
+      else
+        Refined.addInequality(Coeffs, -1);
+      auto DirRes = Refined.isFeasible(Budget);
+      if (DirRes == IntegerSystem::Unknown) {
+        ++ExactGiveUps;
+        return false;
+      }
+      if (DirRes == IntegerSystem::Infeasible) {
+        LLVM_DEBUG(dbgs() << "    exact test removes direction " << Dir
+                          << " at level " << Level << "\n");
+        ++ExactRefinements;
+        Result.DV[Level - 1].Direction &= ~Dir;
+      }
+    }
+    if (Result.DV[Level - 1].Direction == Dependence::DVEntry::NONE)
+      return true;
+  }
+  return false;
+}
+
+
 //===----------------------------------------------------------------------===//
 // Constraint manipulation for Delta test.
 
@@ -3579,6 +3839,7 @@ std::unique_ptr<Dependence>
 DependenceInfo::depends(Instruction *Src, Instruction *Dst,
                         bool PossiblyLoopIndependent,
                         unsigned short *ConfusedLevels) {
+  DATimeRegion T(DATimerPool::Depends);
   if (ConfusedLevels)
     *ConfusedLevels = 0;
 
@@ -3634,7 +3895,7 @@ DependenceInfo::depends(Instruction *Src, Instruction *Dst,
   Pair[0].Src = SrcSCEV;
   Pair[0].Dst = DstSCEV;
 
-  if (Delinearize) {
+  if (getOptions(GO).Delinearize) {
     if (tryDelinearize(Src, Dst, Pair)) {
       LLVM_DEBUG(dbgs() << "    delinearized\n");
       Pairs = Pair.size();
@@ -3786,7 +4047,18 @@ DependenceInfo::depends(Instruction *Src, Instruction *Dst,
   NewConstraint.setAny(SE);
 
   // test separable subscripts
-  for (unsigned SI : Separable.set_bits()) {
+  // Separable subscripts are independent of each other, so they are tested
+  // in order of increasing estimated cost of tests to disprove dependence by
+  // the cheapest test if possible. ZIV test compares two invariants, SIV and
+  // RDIV tests solve a single equation, and MIV tests (GCD and Banerjee)
+  // explore direction vectors, so their cost grows with the number of loops.
+  SmallVector<unsigned, 4> SeparableOrder(Separable.set_bits_begin(),
+                                          Separable.set_bits_end());
+  llvm::stable_sort(SeparableOrder, [&Pair](unsigned LHS, unsigned RHS) {
+    return std::make_pair(Pair[LHS].Classification, Pair[LHS].Loops.count()) <
+           std::make_pair(Pair[RHS].Classification, Pair[RHS].Loops.count());
+  });
+  for (unsigned SI : SeparableOrder) {
     LLVM_DEBUG(dbgs() << "testing subscript " << SI);
     switch (Pair[SI].Classification) {
     case Subscript::ZIV:
@@ -3942,6 +4214,17 @@ DependenceInfo::depends(Instruction *Src, Instruction *Dst,
     }
   }
 
+  // If cheap tests have not disproved a loop-carried dependence, try the exact
+  // test as the last resort.
+  if (getOptions(GO).ExactDependenceBudget > 0) {
+    bool IsCarried = false;
+    for (unsigned II = 1; II <= CommonLevels && !IsCarried; ++II)
+      IsCarried = Result.getDirection(II) &
+                  (Dependence::DVEntry::LT | Dependence::DVEntry::GT);
+    if (IsCarried && testExact(Pair, Src, Dst, Result))
+      return nullptr;
+  }
+
   // Make sure the Scalar flags are set correctly.
   SmallBitVector CompleteLoops(MaxLevels + 1);
   for (unsigned SI = 0; SI < Pairs; ++SI)
@@ -3979,6 +4262,41 @@ DependenceInfo::depends(Instruction *Src, Instruction *Dst,
 }
 
 
+const Dependence *
+DependenceInfo::dependsCached(Instruction *Src, Instruction *Dst,
+                              bool PossiblyLoopIndependent,
+                              unsigned short *ConfusedLevels) {
+  ++DependsQueries;
+  auto Key{std::make_tuple(Src, Dst, unsigned(PossiblyLoopIndependent))};
+  auto CacheItr{DependenceCache.find(Key)};
+  if (CacheItr != DependenceCache.end()) {
+    ++DependsCacheHits;
+  } else {
+    CachedDependence Cached;
+    Cached.Dep =
+        depends(Src, Dst, PossiblyLoopIndependent, &Cached.ConfusedLevels);
+    CacheItr = DependenceCache.try_emplace(Key, std::move(Cached)).first;
+  }
+  if (ConfusedLevels)
+    *ConfusedLevels = CacheItr->second.ConfusedLevels;
+  return CacheItr->second.Dep.get();
+}
+
+
+Optional<const Dependence *>
+DependenceInfo::getCachedDependence(Instruction *Src, Instruction *Dst,
+                                    bool PossiblyLoopIndependent,
+                                    unsigned short *ConfusedLevels) const {
+  auto CacheItr{DependenceCache.find(
+      std::make_tuple(Src, Dst, unsigned(PossiblyLoopIndependent)))};
+  if (CacheItr == DependenceCache.end())
+    return None;
+  if (ConfusedLevels)
+    *ConfusedLevels = CacheItr->second.ConfusedLevels;
+  return CacheItr->second.Dep.get();
+}
+
+
 
 //===----------------------------------------------------------------------===//
 // getSplitIteration -
@@ -4055,7 +4373,7 @@ const SCEV *DependenceInfo::getSplitIteration(const Dependence &Dep,
   Pair[0].Src = SrcSCEV;
   Pair[0].Dst = DstSCEV;
 
-  if (Delinearize) {
+  if (getOptions(GO).Delinearize) {
     if (tryDelinearize(Src, Dst, Pair)) {
       LLVM_DEBUG(dbgs() << "    delinearized\n");
       Pairs = Pair.size();
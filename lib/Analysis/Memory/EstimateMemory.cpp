@@ -26,6 +26,7 @@
 #include "tsar/Analysis/Memory/GlobalsAccess.h"
 #include "tsar/Analysis/Memory/MemoryAccessUtils.h"
 #include "tsar/Analysis/Memory/MemorySetInfo.h"
+#include "tsar/Core/PassProfiler.h"
 #include "tsar/Support/IRUtils.h"
 #include "tsar/Unparse/Utils.h"
 #include <llvm/ADT/Statistic.h>
@@ -52,6 +53,13 @@ STATISTIC(NumUnknownNode, "Number of unknown nodes created");
 STATISTIC(NumMergedNode, "Number of alias nodes merged in");
 STATISTIC(NumEstimateMemory, "Number of estimate memory created");
 STATISTIC(NumUnknownMemory, "Number of unknown memory created");
+STATISTIC(NumAliasTreeSlabs, "Number of slabs allocated for alias trees");
+STATISTIC(MaxAliasTreeMemory,
+  "Maximum number of bytes allocated for an alias tree");
+STATISTIC(NumAliasTreeObjects,
+  "Number of nodes and estimate memory allocated in alias trees");
+STATISTIC(MaxAliasTreeObjectMemory,
+  "Maximum number of bytes requested by objects of an alias tree");
 
 static inline void clarifyUnknownSize(const DataLayout &DL,
     MemoryLocation &Loc, const DominatorTree *DT = nullptr) {
@@ -264,9 +272,12 @@ bool isSameBase(const DataLayout &DL,
   return false;
 }
 
-AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
+namespace {
+template<class AATy>
+AliasDescriptor aliasRelationImp(AATy &AA, const DataLayout &DL,
     const MemoryLocation &LHS, const MemoryLocation &RHS) {
   AliasDescriptor Dptr;
+  PassProfiler::countAliasQuery();
   auto AR = AA.alias(
     isAAInfoCorrupted(LHS.AATags) ? LHS.getWithoutAATags() : LHS,
     isAAInfoCorrupted(RHS.AATags) ? RHS.getWithoutAATags() : RHS);
@@ -286,9 +297,10 @@ AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
       auto BaseRHS = GetPointerBaseWithConstantOffset(RHS.Ptr, OffsetRHS, DL);
       if (OffsetLHS == 0 && OffsetRHS == 0)
         break;
+      PassProfiler::countAliasQuery();
       auto BaseAlias = AA.alias(
-        BaseLHS, LocationSize::afterPointer(),
-        BaseRHS, LocationSize::afterPointer());
+        MemoryLocation(BaseLHS, LocationSize::afterPointer()),
+        MemoryLocation(BaseRHS, LocationSize::afterPointer()));
       // It is possible to precisely compare two partially overlapped
       // locations in case of the same base pointer only.
       if (BaseAlias != AliasResult::MustAlias)
@@ -331,16 +343,17 @@ AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
   return Dptr;
 }
 
-AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
+template<class AATy>
+AliasDescriptor aliasRelationImp(AATy &AA, const DataLayout &DL,
     const EstimateMemory &LHS, const EstimateMemory &RHS) {
-  auto MergedAD = aliasRelation(AA, DL,
+  auto MergedAD = aliasRelationImp(AA, DL,
     MemoryLocation(LHS.front(), LHS.getSize(), LHS.getAAInfo()),
     MemoryLocation(RHS.front(), RHS.getSize(), RHS.getAAInfo()));
   if (MergedAD.is<trait::MayAlias>())
     return MergedAD;
   for (auto PtrLHS: LHS)
     for (auto PtrRHS : RHS) {
-      auto AD = aliasRelation(AA, DL,
+      auto AD = aliasRelationImp(AA, DL,
         MemoryLocation(PtrLHS, LHS.getSize(), LHS.getAAInfo()),
         MemoryLocation(PtrRHS, RHS.getSize(), RHS.getAAInfo()));
       MergedAD = mergeAliasRelation(MergedAD, AD);
@@ -349,6 +362,27 @@ AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
     }
   return MergedAD;
 }
+}
+
+AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
+    const MemoryLocation &LHS, const MemoryLocation &RHS) {
+  return aliasRelationImp(AA, DL, LHS, RHS);
+}
+
+AliasDescriptor aliasRelation(BatchAAResults &AA, const DataLayout &DL,
+    const MemoryLocation &LHS, const MemoryLocation &RHS) {
+  return aliasRelationImp(AA, DL, LHS, RHS);
+}
+
+AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
+    const EstimateMemory &LHS, const EstimateMemory &RHS) {
+  return aliasRelationImp(AA, DL, LHS, RHS);
+}
+
+AliasDescriptor aliasRelation(BatchAAResults &AA, const DataLayout &DL,
+    const EstimateMemory &LHS, const EstimateMemory &RHS) {
+  return aliasRelationImp(AA, DL, LHS, RHS);
+}
 
 const EstimateMemory * ancestor(
     const EstimateMemory *LHS, const EstimateMemory *RHS) noexcept {
@@ -663,12 +697,31 @@ void tsar::AliasTree::addUnknown(llvm::Instruction *I) {
   Node->push_back(I), ++NumUnknownMemory;
 }
 
+AliasTree::~AliasTree() {
+  // Estimate memory locations are trivially destructible, so only alias nodes
+  // should be destroyed before memory is released.
+  static_assert(std::is_trivially_destructible<EstimateMemory>::value,
+    "Destructors of estimate memory locations are not called!");
+  mNodes.clearAndDispose([](AliasNode *N) { N->~AliasNode(); });
+  // Each object has been previously allocated with a separate call to 'new',
+  // so the number of objects and the number of requested bytes are reported
+  // to compare with the number of slabs and the memory used by the allocator.
+  NumAliasTreeSlabs += mAllocator.GetNumSlabs();
+  MaxAliasTreeMemory.updateMax(mAllocator.getTotalMemory());
+  NumAliasTreeObjects += mNumObjects;
+  MaxAliasTreeObjectMemory.updateMax(mAllocator.getBytesAllocated());
+  LLVM_DEBUG(dbgs() << "[ALIAS TREE]: release " << mAllocator.getTotalMemory()
+                    << " bytes in " << mAllocator.GetNumSlabs() << " slabs\n");
+}
+
 void AliasTree::removeNode(AliasNode *N) {
   if (auto *Fwd = N->mForward) {
     Fwd->release(*this);
     N->mForward = nullptr;
   }
-  mNodes.erase(N);
+  mNodes.remove(*N);
+  // Memory will be released together with the whole tree.
+  N->~AliasNode();
 }
 
 std::pair<bool, Instruction *>
@@ -676,10 +729,12 @@ AliasEstimateNode::slowMayAliasUnknownImp(
     const Instruction *I, AAResults &AA) const {
   assert(I && "Instruction must not be null!");
   for (auto &EM : *this) {
-    for (auto *Ptr : EM)
+    for (auto *Ptr : EM) {
+      PassProfiler::countAliasQuery();
       if (AA.getModRefInfo(I, MemoryLocation(Ptr, EM.getSize(), EM.getAAInfo()))
           != ModRefInfo::NoModRef)
         return std::make_pair(true, nullptr);
+    }
   }
   return std::make_pair(false, nullptr);
 }
@@ -693,18 +748,25 @@ AliasUnknownNode::slowMayAliasUnknownImp(
   for (auto *UI : *this) {
     auto *C1 = dyn_cast<CallBase>(UI);
     auto *C2 = dyn_cast<CallBase>(I);
-    if (!C1 || !C2 || AA.getModRefInfo(C1, C2) != ModRefInfo::NoModRef ||
-      AA.getModRefInfo(C2, C1) != ModRefInfo::NoModRef)
+    if (!C1 || !C2)
+      return std::make_pair(true, UI);
+    PassProfiler::countAliasQuery();
+    if (AA.getModRefInfo(C1, C2) != ModRefInfo::NoModRef)
+      return std::make_pair(true, UI);
+    PassProfiler::countAliasQuery();
+    if (AA.getModRefInfo(C2, C1) != ModRefInfo::NoModRef)
       return std::make_pair(true, UI);
   }
   return std::make_pair(false, nullptr);
 }
 
 std::pair<bool, EstimateMemory *>
-AliasEstimateNode::slowMayAliasImp(const EstimateMemory &EM, AAResults &AA) {
+AliasEstimateNode::slowMayAliasImp(const EstimateMemory &EM,
+                                   BatchAAResults &AA) {
   for (auto &ThisEM : *this)
     for (auto *LHSPtr : ThisEM)
       for (auto *RHSPtr : EM) {
+        PassProfiler::countAliasQuery();
         auto AR = AA.alias(
           MemoryLocation(LHSPtr, ThisEM.getSize(), ThisEM.getAAInfo()),
           MemoryLocation(RHSPtr, EM.getSize(), EM.getAAInfo()));
@@ -716,12 +778,16 @@ AliasEstimateNode::slowMayAliasImp(const EstimateMemory &EM, AAResults &AA) {
 }
 
 std::pair<bool, EstimateMemory *>
-AliasUnknownNode::slowMayAliasImp(const EstimateMemory &EM, AAResults &AA) {
+AliasUnknownNode::slowMayAliasImp(const EstimateMemory &EM,
+                                  BatchAAResults &AA) {
   for (auto *UI : *this) {
-    for (auto *Ptr : EM)
-      if (AA.getModRefInfo(UI, MemoryLocation(Ptr, EM.getSize(), EM.getAAInfo()))
-          != ModRefInfo::NoModRef)
+    for (auto *Ptr : EM) {
+      PassProfiler::countAliasQuery();
+      if (AA.getModRefInfo(
+            UI, MemoryLocation(Ptr, EM.getSize(), EM.getAAInfo())) !=
+          ModRefInfo::NoModRef)
         return std::make_pair(true, nullptr);
+    }
   }
   return std::make_pair(false, nullptr);
 }
@@ -744,7 +810,7 @@ AliasEstimateNode * AliasTree::addEmptyNode(
       return cast<AliasEstimateNode>(Current);
     Aliases.clear();
     for (auto &Ch : make_range(Current->child_begin(), Current->child_end())) {
-      auto Result = Ch.slowMayAlias(NewEM, *mAA);
+      auto Result = Ch.slowMayAlias(NewEM, *mBatchAA);
       if (Result.first) {
         if (Result.second)
           Aliases.push_back(Result.second);
@@ -755,7 +821,7 @@ AliasEstimateNode * AliasTree::addEmptyNode(
         // that its children nodes do not alias with this memory. The issue is
         // that unknown node may not cover its children nodes.
         for (auto &N : make_range(Ch.child_begin(), Ch.child_end())) {
-          auto Result = N.slowMayAlias(NewEM, *mAA);
+          auto Result = N.slowMayAlias(NewEM, *mBatchAA);
           if (Result.first) {
             Aliases.push_back(&Ch);
             break;
@@ -775,7 +841,7 @@ AliasEstimateNode * AliasTree::addEmptyNode(
       auto Node = EM->getAliasNode(*this);
       assert(Node && "Alias node for memory location must not be null!");
       auto AD = aliasRelation(
-        *mAA, *mDL, NewEM, AliasEstimateNode::iterator(EM), Node->end());
+        *mBatchAA, *mDL, NewEM, AliasEstimateNode::iterator(EM), Node->end());
       if (AD.is<trait::CoverAlias>()) {
         auto *NewNode = make_node<AliasEstimateNode, llvm::Statistic, 2>(
           *Current, {&NumAliasNode, &NumEstimateNode});
@@ -793,7 +859,8 @@ AliasEstimateNode * AliasTree::addEmptyNode(
         auto EM = I->get<EstimateMemory *>();
         auto Node = EM->getAliasNode(*this);
         assert(Node && "Alias node for memory location must not be null!");
-        auto AD = aliasRelation(*mAA, *mDL, NewEM, Node->begin(), Node->end());
+        auto AD =
+          aliasRelation(*mBatchAA, *mDL, NewEM, Node->begin(), Node->end());
         if (AD.is<trait::CoverAlias>() ||
             (AD.is<trait::CoincideAlias>() && !AD.is<trait::ContainedAlias>()))
           continue;
@@ -842,7 +909,8 @@ AliasResult AliasTree::isSamePointer(
   auto LocAATags = sanitizeAAInfo(Loc.AATags);
   bool IsAmbiguous = false;
   for (auto *Ptr : EM) {
-    switch (mAA->alias(
+    PassProfiler::countAliasQuery();
+    switch (mBatchAA->alias(
         MemoryLocation(Ptr, 1, EM.getAAInfo()),
         MemoryLocation(Loc.Ptr, 1, LocAATags))) {
       case AliasResult::MustAlias: return AliasResult::MustAlias;
@@ -1017,7 +1085,7 @@ AliasTree::insert(const MemoryLocation &Base) {
         }
       }
       if (!UpdateChain) {
-        auto EM = new EstimateMemory(*Prev, Base.Size, Base.AATags);
+        auto EM = make<EstimateMemory>(*Prev, Base.Size, Base.AATags);
         ++NumEstimateMemory;
         CT::spliceNext(EM, Prev);
         return std::make_tuple(EM, true, AddAmbiguous);
@@ -1029,7 +1097,7 @@ AliasTree::insert(const MemoryLocation &Base) {
       }
       assert(MemorySetInfo<MemoryLocation>::sizecmp(
                Base.Size, UpdateChain->getSize()) < 0 && "Invariant broken!");
-      auto EM = new EstimateMemory(*UpdateChain, Base.Size, Base.AATags);
+      auto EM = make<EstimateMemory>(*UpdateChain, Base.Size, Base.AATags);
       ++NumEstimateMemory;
       CT::splicePrev(EM, UpdateChain);
       if (ChainBegin == UpdateChain)
@@ -1040,7 +1108,7 @@ AliasTree::insert(const MemoryLocation &Base) {
     BL = &mBases.insert(std::make_pair(StrippedPtr, BaseList())).first->second;
   }
   LLVM_DEBUG(dbgs() << "[ALIAS TREE]: build new chain\n");
-  auto Chain = new EstimateMemory(Base, AmbiguousRef::make(mAmbiguousPool));
+  auto Chain = make<EstimateMemory>(Base, AmbiguousRef::make(mAmbiguousPool));
   ++NumEstimateMemory;
   BL->push_back(Chain);
   return std::make_tuple(Chain, true, false);
@@ -28,9 +28,12 @@
 #include "tsar/Analysis/Memory/GlobalsAccess.h"
 #include "tsar/Analysis/Memory/Passes.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/IRUtils.h"
 #include "tsar/Support/PassProvider.h"
 #include <bcl/utility.h>
 #include <llvm/ADT/SCCIterator.h>
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/CallGraph.h>
 #include <llvm/Analysis/CallGraphSCCPass.h>
 #include <llvm/Analysis/ScalarEvolution.h>
@@ -44,6 +47,10 @@
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "def-mem"
 
+STATISTIC(NumReusedDefUse, "Number of reused interprocedural def-use sets");
+STATISTIC(NumGlobalReachTransfers, "Number of evaluated transfer functions in "
+  "interprocedural reaching definition analysis");
+
 using namespace llvm;
 using namespace tsar;
 
@@ -87,8 +94,13 @@ public:
     return mInterprocDUInfo;
   }
 
+  /// Return fingerprints of functions which have been analyzed at the
+  /// previous run of the analysis.
+  FunctionFingerprintMap &getFingerprints() noexcept { return mFingerprints; }
+
 private:
   tsar::InterprocDefUseInfo mInterprocDUInfo;
+  FunctionFingerprintMap mFingerprints;
 };
 
 using GlobalDefinedMemoryProvider = FunctionPassProvider<
@@ -155,8 +167,24 @@ bool GlobalDefinedMemory::runOnModule(Module &SCC) {
   auto &Wrapper = getAnalysis<GlobalDefinedMemoryWrapper>();
   if (!Wrapper)
     return false;
-  Wrapper->clear();
   auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  // In incremental mode results of the previous run are reused for functions
+  // which have not been changed and which callees have not been reanalyzed.
+  auto *Storage{GO.IncrementalAnalysis
+                    ? getAnalysisIfAvailable<GlobalDefinedMemoryStorage>()
+                    : nullptr};
+  // Previous results are available only if the wrapper refers to them.
+  if (Storage && &Storage->getInterprocDefUseInfo() != &*Wrapper)
+    Storage = nullptr;
+  InterprocDefUseInfo PrevInfo;
+  FunctionFingerprintMap PrevFingerprints;
+  if (Storage) {
+    std::swap(PrevInfo, *Wrapper);
+    std::swap(PrevFingerprints, Storage->getFingerprints());
+  } else {
+    Wrapper->clear();
+  }
+  SmallPtrSet<Function *, 32> Reused;
   GlobalDefinedMemoryProvider::initialize<GlobalOptionsImmutableWrapper>(
       [&GO](GlobalOptionsImmutableWrapper &Wrapper) {
         Wrapper.setOptions(&GO);
@@ -180,6 +208,26 @@ bool GlobalDefinedMemory::runOnModule(Module &SCC) {
     // and these functions should be pre-analyzed.
     if (!F || F->empty() || !hasFnAttr(*F, AttrKind::DirectUserCallee))
       continue;
+    if (Storage) {
+      auto Fingerprint{computeFingerprint(*F)};
+      auto PrevDUItr{PrevInfo.find(F)};
+      bool IsUnchanged{PrevFingerprints.isUnchanged(*F, Fingerprint) &&
+                       PrevDUItr != PrevInfo.end()};
+      Storage->getFingerprints().insert(*F, Fingerprint, &PrevFingerprints);
+      // Summaries of callees are used to analyze a function, so a function
+      // should be reanalyzed if some of its callees have been reanalyzed.
+      if (IsUnchanged && all_of(*CGN, [&Reused](auto &CallRecord) {
+            auto *Callee{CallRecord.second->getFunction()};
+            return !Callee || Callee->empty() || Reused.count(Callee);
+          })) {
+        LLVM_DEBUG(dbgs() << "[GLOBAL DEFINED MEMORY]: reuse results for "
+                          << F->getName() << "\n";);
+        Wrapper->try_emplace(F, std::move(PrevDUItr->get<DefUseSet>()));
+        Reused.insert(F);
+        ++NumReusedDefUse;
+        continue;
+      }
+    }
     LLVM_DEBUG(dbgs() << "[GLOBAL DEFINED MEMORY]: analyze " << F->getName()
                       << "\n";);
     auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(*F);
@@ -193,7 +241,9 @@ bool GlobalDefinedMemory::runOnModule(Module &SCC) {
     DefinedMemoryInfo DefInfo;
     ReachDFFwk ReachDefFwk(AT, TLI, RegInfo, DT, DI, SE, DL, GO, DefInfo,
                            *Wrapper);
-    solveDataFlowUpward(&ReachDefFwk, DFF);
+    NumGlobalReachTransfers += solveDataFlowUpward(
+        &ReachDefFwk, DFF,
+        GO.WorklistDataFlow ? DFSolverKind::Worklist : DFSolverKind::Iterative);
     auto DefUseSetItr = ReachDefFwk.getDefInfo().find(DFF);
     assert(DefUseSetItr != ReachDefFwk.getDefInfo().end() &&
            "Def-use set must exist for a function!");
@@ -23,13 +23,16 @@
 //===---------------------------------------------------------------------===//
 
 #include "tsar/Analysis/Attributes.h"
+#include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/GlobalsAccess.h"
 #include "tsar/Analysis/Memory/LiveMemory.h"
 #include "tsar/Analysis/Memory/MemoryAccessUtils.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/IRUtils.h"
 #include "tsar/Support/PassProvider.h"
 #include <llvm/ADT/SCCIterator.h>
 #include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/CallGraph.h>
 #include <llvm/Analysis/CallGraphSCCPass.h>
 #include <llvm/Analysis/ValueTracking.h>
@@ -45,6 +48,10 @@
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "live-mem"
 
+STATISTIC(NumReusedLive, "Number of reused interprocedural live sets");
+STATISTIC(NumGlobalLiveTransfers, "Number of evaluated transfer functions in "
+  "interprocedural live memory analysis");
+
 using namespace llvm;
 using namespace tsar;
 
@@ -68,6 +75,25 @@ public:
   void getAnalysisUsage(AnalysisUsage &AU) const override;
 };
 
+using CallList = std::vector<
+    bcl::tagged_pair<bcl::tagged<Instruction *, Instruction>,
+                     bcl::tagged<std::unique_ptr<LiveSet>, LiveSet>>>;
+
+/// This container contains results of the live memory analysis for calls to
+/// a function (which is a key).
+using LiveMemoryForCalls = DenseMap<const Function *, CallList>;
+
+/// Information which is necessary to reuse results of the previous run of
+/// the analysis for functions which have not been changed.
+struct IncrementalLiveInfo {
+  /// Fingerprints of analyzed functions.
+  FunctionFingerprintMap Fingerprints;
+  /// Functions which could be called outside the analyzed module.
+  SmallPtrSet<Function *, 32> HasExternalCalls;
+  /// Results of the analysis for calls.
+  LiveMemoryForCalls Calls;
+};
+
 class GlobalLiveMemoryStorage :
   public ImmutablePass, private bcl::Uncopyable {
 public:
@@ -93,26 +119,25 @@ public:
     return mInterprocLiveMemory;
   }
 
+  /// Return information about the previous run of the analysis.
+  IncrementalLiveInfo &getIncrementalInfo() noexcept {
+    return mIncrementalInfo;
+  }
+
 private:
   InterprocLiveMemoryInfo mInterprocLiveMemory;
+  IncrementalLiveInfo mIncrementalInfo;
 };
 
-using CallList = std::vector<
-    bcl::tagged_pair<bcl::tagged<Instruction *, Instruction>,
-                     bcl::tagged<std::unique_ptr<LiveSet>, LiveSet>>>;
-
-/// This container contains results of the live memory analysis for calls to
-/// a function (which is a key).
-using LiveMemoryForCalls = DenseMap<const Function *, CallList>;
-
 using GlobalLiveMemoryProvider = FunctionPassProvider<
   GlobalOptionsImmutableWrapper,
   DFRegionInfoPass,
   DefinedMemoryPass,
-  DominatorTreeWrapperPass>;
+  DominatorTreeWrapperPass,
+  EstimateMemoryPass>;
 
 void initMayLivesWithIPO(Function &F, LiveMemoryForCalls &LiveSetForCalls,
-    DefUseSet &DefUse, DataFlowTraits<LiveDFFwk *>::ValueType &MayLives) {
+    DefUseSet &DefUse, DefUseSet::LocationSet &MayLives) {
   auto FInfoItr = LiveSetForCalls.find(&F);
   // Check that a current function is entry point or that it is never called.
   // In this case list of live locations after exist from this function is empty.
@@ -191,6 +216,7 @@ INITIALIZE_PROVIDER_BEGIN(GlobalLiveMemoryProvider, "global-live-mem-provider",
 INITIALIZE_PASS_DEPENDENCY(DFRegionInfoPass)
 INITIALIZE_PASS_DEPENDENCY(DefinedMemoryPass)
 INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(EstimateMemoryPass)
 INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
 INITIALIZE_PASS_DEPENDENCY(GlobalsAccessWrapper)
 INITIALIZE_PROVIDER_END(GlobalLiveMemoryProvider, "global-live-mem-provider",
@@ -242,11 +268,29 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
   auto &Wrapper = getAnalysis<GlobalLiveMemoryWrapper>();
   if (!Wrapper)
     return false;
-  Wrapper->clear();
   auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  // In incremental mode results of the previous run are reused for functions
+  // if neither these functions, nor their callees, nor their callers have
+  // been changed.
+  auto *Storage{GO.IncrementalAnalysis
+                    ? getAnalysisIfAvailable<GlobalLiveMemoryStorage>()
+                    : nullptr};
+  // Previous results are available only if the wrapper refers to them.
+  if (Storage && &Storage->getLiveMemoryInfo() != &*Wrapper)
+    Storage = nullptr;
+  InterprocLiveMemoryInfo PrevInfo;
+  IncrementalLiveInfo Prev;
+  if (Storage) {
+    std::swap(PrevInfo, *Wrapper);
+    std::swap(Prev, Storage->getIncrementalInfo());
+  } else {
+    Wrapper->clear();
+  }
   auto &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
   std::vector<CallGraphNode *> Worklist;
   SmallPtrSet<CallGraphNode *, 32> HasExternalCalls;
+  // Functions which have been changed or which callees have been changed.
+  SmallPtrSet<Function *, 32> Changed;
   for (scc_iterator<CallGraph *> I = scc_begin(&CG); !I.isAtEnd(); ++I) {
     // TODO (kaniandr@gmail.com): implement analysis in case of recursion.
     if (I->size() > 1)
@@ -256,6 +300,17 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
     if (!F && !GO.NoExternalCalls)
       for (auto Callee : *CGN)
         HasExternalCalls.insert(Callee.second);
+    if (Storage && F && !F->empty()) {
+      auto Fingerprint{computeFingerprint(*F)};
+      if (!Prev.Fingerprints.isUnchanged(*F, Fingerprint) ||
+          any_of(*CGN, [&Changed](auto &CallRecord) {
+            auto *Callee{CallRecord.second->getFunction()};
+            return Callee && Changed.count(Callee);
+          }))
+        Changed.insert(F);
+      Storage->getIncrementalInfo().Fingerprints.insert(*F, Fingerprint,
+                                                        &Prev.Fingerprints);
+    }
     // Avoid analysis of a library function because we must ensure that
     // all callers will be analyzed earlier. However, in general a library
     // function without body may call another library function.
@@ -283,10 +338,58 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
         [&GAP](GlobalsAccessWrapper &Wrapper) { Wrapper.set(*GAP); });
   auto &DL = M.getDataLayout();
   LiveMemoryForCalls LiveSetForCalls;
+  // Functions which should be reanalyzed because some of their callers have
+  // been reanalyzed.
+  SmallPtrSet<Function *, 32> HasChangedCallers;
+  // Move results for calls from a specified function to the list of results
+  // of the current run. Return false if some of results are not available.
+  auto reuseCallsFrom = [&Prev, &LiveSetForCalls](CallGraphNode &CGN) {
+    SmallVector<std::pair<const Function *, CallList::iterator>, 8> Calls;
+    for (auto &CallRecord : CGN) {
+      Function *Callee = CallRecord.second->getFunction();
+      if (!CallRecord.first || !Callee)
+        continue;
+      auto PrevCallsItr{Prev.Calls.find(Callee)};
+      if (PrevCallsItr == Prev.Calls.end())
+        return false;
+      auto CallItr{find_if(PrevCallsItr->second,
+                           [Call = cast<Instruction>(*CallRecord.first)](
+                               auto &CallInfo) {
+                             return CallInfo.template get<Instruction>() ==
+                                        Call &&
+                                    CallInfo.template get<LiveSet>();
+                           })};
+      if (CallItr == PrevCallsItr->second.end())
+        return false;
+      Calls.emplace_back(Callee, CallItr);
+    }
+    for (auto &&[Callee, CallItr] : Calls)
+      LiveSetForCalls[Callee].push_back(std::move(*CallItr));
+    return true;
+  };
   for (auto *CGN : llvm::reverse(Worklist)) {
     auto F = CGN->getFunction();
     if (!F || F->empty())
       continue;
+    if (Storage) {
+      bool HasExternal{HasExternalCalls.count(CGN) != 0};
+      if (HasExternal)
+        Storage->getIncrementalInfo().HasExternalCalls.insert(F);
+      auto PrevInfoItr{PrevInfo.find(F)};
+      if (PrevInfoItr != PrevInfo.end() && !Changed.count(F) &&
+          !HasChangedCallers.count(F) &&
+          HasExternal == (Prev.HasExternalCalls.count(F) != 0) &&
+          reuseCallsFrom(*CGN)) {
+        LLVM_DEBUG(dbgs() << "[GLOBAL LIVE MEMORY]: reuse results for "
+                          << F->getName() << "\n";);
+        Wrapper->try_emplace(F, std::move(PrevInfoItr->get<LiveSet>()));
+        ++NumReusedLive;
+        continue;
+      }
+      for (auto &CallRecord : *CGN)
+        if (auto *Callee{CallRecord.second->getFunction()})
+          HasChangedCallers.insert(Callee);
+    }
     LLVM_DEBUG(dbgs() << "[GLOBAL LIVE MEMORY]: analyze " << F->getName()
                       << "\n";);
     auto &Provider = getAnalysis<GlobalLiveMemoryProvider>(*F);
@@ -295,7 +398,7 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
     auto &DefInfo = Provider.get<DefinedMemoryPass>().getDefInfo();
     DominatorTree *DT = nullptr;
     LLVM_DEBUG(DT = &Provider.get<DominatorTreeWrapperPass>().getDomTree());
-    DataFlowTraits<LiveDFFwk *>::ValueType MayLives;
+    DefUseSet::LocationSet MayLives;
     auto DefItr = DefInfo.find(TopRegion);
     assert(DefItr != DefInfo.end() && DefItr->get<DefUseSet>() &&
       "Def-use set must not be null!");
@@ -317,8 +420,11 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
       IntraLiveInfo.try_emplace(TopRegion, std::make_unique<LiveSet>()).first;
     auto &LS = LiveItr->get<LiveSet>();
     LS->setOut(MayLives);
-    LiveDFFwk LiveFwk(IntraLiveInfo, DefInfo, DT);
-    solveDataFlowDownward(&LiveFwk, TopRegion);
+    auto &AT = Provider.get<EstimateMemoryPass>().getAliasTree();
+    LiveDFFwk LiveFwk(IntraLiveInfo, DefInfo, DT, &AT);
+    NumGlobalLiveTransfers += solveDataFlowDownward(
+        &LiveFwk, TopRegion,
+        GO.WorklistDataFlow ? DFSolverKind::Worklist : DFSolverKind::Iterative);
     auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(*F);
     for (auto &CallRecord : *CGN) {
       Function *Callee = CallRecord.second->getFunction();
@@ -349,5 +455,7 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
     Wrapper->try_emplace(F, std::move(IntraLiveInfo[TopRegion]));
   }
   LLVM_DEBUG(visitedFunctionsLog(LiveSetForCalls));
+  if (Storage)
+    Storage->getIncrementalInfo().Calls = std::move(LiveSetForCalls);
   return false;
 }
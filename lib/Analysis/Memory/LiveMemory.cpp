@@ -24,8 +24,11 @@
 
 #include "tsar/Analysis/Memory/LiveMemory.h"
 #include "tsar/Analysis/Memory/DefinedMemory.h"
+#include "tsar/Analysis/Memory/EstimateMemory.h"
+#include "tsar/Support/GlobalOptions.h"
 #include "tsar/Unparse/Utils.h"
 #include <llvm/ADT/STLExtras.h>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/ValueTracking.h>
 #ifdef LLVM_DEBUG
 # include <llvm/IR/Dominators.h>
@@ -38,12 +41,17 @@ using namespace tsar;
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "live-mem"
 
+STATISTIC(NumLiveTransfers,
+  "Number of evaluated transfer functions in live memory analysis");
+
 char LiveMemoryPass::ID = 0;
 INITIALIZE_PASS_BEGIN(LiveMemoryPass, "live-mem",
   "Live Memory Analysis", false, true)
   INITIALIZE_PASS_DEPENDENCY(DFRegionInfoPass)
   INITIALIZE_PASS_DEPENDENCY(DefinedMemoryPass)
+  INITIALIZE_PASS_DEPENDENCY(EstimateMemoryPass)
   INITIALIZE_PASS_DEPENDENCY(GlobalLiveMemoryWrapper)
+  INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
 INITIALIZE_PASS_END(LiveMemoryPass, "live-mem",
   "Live Memory Analysis", false, true)
 
@@ -80,7 +88,7 @@ INITIALIZE_PASS_END(LiveMemoryPass, "live-mem",
     // If inter-procedural analysis is not performed conservative assumption for
     // live variable analysis should be made. All locations except 'alloca' are
     // considered as alive before exit from this function.
-    DataFlowTraits<LiveDFFwk *>::ValueType MayLives;
+    DefUseSet::LocationSet MayLives;
     for (auto &Loc : DefUse->getDefs()) {
       assert(Loc.Ptr && "Pointer to location must not be null!");
       if (!isa<AllocaInst>(getUnderlyingObject(Loc.Ptr, 0)))
@@ -93,15 +101,21 @@ INITIALIZE_PASS_END(LiveMemoryPass, "live-mem",
     }
     LS->setOut(std::move(MayLives));
   }
-  LiveDFFwk LiveFwk(mLiveInfo, DefInfo, DT);
-  solveDataFlowDownward(&LiveFwk, DFF);
+  auto &GO = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  auto &AT = getAnalysis<EstimateMemoryPass>().getAliasTree();
+  LiveDFFwk LiveFwk(mLiveInfo, DefInfo, DT, &AT);
+  NumLiveTransfers += solveDataFlowDownward(
+      &LiveFwk, DFF,
+      GO.WorklistDataFlow ? DFSolverKind::Worklist : DFSolverKind::Iterative);
   return false;
 }
 
 void LiveMemoryPass::getAnalysisUsage(AnalysisUsage & AU) const {
   AU.addRequired<DFRegionInfoPass>();
   AU.addRequired<DefinedMemoryPass>();
+  AU.addRequired<EstimateMemoryPass>();
   AU.addRequired<GlobalLiveMemoryWrapper>();
+  AU.addRequired<GlobalOptionsImmutableWrapper>();
   AU.setPreservesAll();
 }
 
@@ -109,12 +123,146 @@ FunctionPass * llvm::createLiveMemoryPass() {
   return new LiveMemoryPass();
 }
 
+LiveDFFwk::LiveDFFwk(LiveMemoryInfo &LiveInfo, DefinedMemoryInfo &DefInfo,
+    const DominatorTree *DT, const AliasTree *AT) :
+  mLiveInfo(&LiveInfo), mDefInfo(&DefInfo), mDT(DT), mAT(AT) {
+  if (!mAT)
+    return;
+  // A location may be alive only if it is used in some node or if it is alive
+  // at the boundary of a region the analysis is started from.
+  for (auto &DefItr : *mDefInfo)
+    if (auto &DU = DefItr.get<DefUseSet>())
+      for (auto &Loc : DU->getUses())
+        registerDenseLocation(Loc);
+  for (auto &LiveItr : *mLiveInfo)
+    if (auto &LS = LiveItr.get<LiveSet>()) {
+      for (auto &Loc : LS->getIn())
+        registerDenseLocation(Loc);
+      for (auto &Loc : LS->getOut())
+        registerDenseLocation(Loc);
+    }
+}
+
+void LiveDFFwk::registerDenseLocation(const MemoryLocationRange &Loc) {
+  if (Loc.Kind != MemoryLocationRange::LocKind::Default ||
+      !Loc.DimList.empty() || !Loc.LowerBound.hasValue() ||
+      Loc.LowerBound.getValue() != 0)
+    return;
+  auto *EM = mAT->find(Loc);
+  if (!EM || EM->isAmbiguous() || EM->front() != Loc.Ptr || !EM->isSized() ||
+      EM->getSize() != Loc.UpperBound)
+    return;
+  // The first location is used as a representative of an estimate memory
+  // location, so locations with different metadata are stored explicitly.
+  auto Pair = mDenseIds.try_emplace(EM, mDenseLocations.size());
+  if (!Pair.second)
+    return;
+  mDenseLocations.push_back(Loc);
+  mDensePtrs[Loc.Ptr].push_back(Pair.first->second);
+}
+
+Optional<unsigned> LiveDFFwk::getDenseId(const MemoryLocationRange &Loc) const {
+  if (mDenseLocations.empty())
+    return None;
+  auto PtrItr = mDensePtrs.find(Loc.Ptr);
+  if (PtrItr == mDensePtrs.end())
+    return None;
+  for (auto Id : PtrItr->second)
+    if (mDenseLocations[Id] == Loc)
+      return Id;
+  return None;
+}
+
+LiveLocationSet LiveDFFwk::toDense(
+    const LiveLocationSet::LocationSet &Locs) const {
+  LiveLocationSet Result(getNumberOfDenseIds());
+  for (auto &Loc : Locs)
+    if (auto Id = getDenseId(Loc))
+      Result.getDense().set(*Id);
+    else
+      Result.getLocations().insert(Loc);
+  return Result;
+}
+
+LiveLocationSet::LocationSet LiveDFFwk::fromDense(
+    const LiveLocationSet &Locs) const {
+  LiveLocationSet::LocationSet Result(Locs.getLocations());
+  for (auto Id : Locs.getDense().set_bits())
+    Result.insert(mDenseLocations[Id]);
+  return Result;
+}
+
+LiveDFFwk::DenseLiveSet & LiveDFFwk::getDenseValue(DFNode *N) {
+  assert(N && "Node must not be null!");
+  auto Pair = mDenseInfo.try_emplace(N);
+  if (!Pair.second)
+    return *Pair.first->second;
+  Pair.first->second = std::make_unique<DenseLiveSet>();
+  auto &DLS = *Pair.first->second;
+  auto I = mLiveInfo->find(N);
+  if (I != mLiveInfo->end() && I->get<LiveSet>()) {
+    DLS.setIn(toDense(I->get<LiveSet>()->getIn()));
+    DLS.setOut(toDense(I->get<LiveSet>()->getOut()));
+  } else {
+    DLS.setIn(LiveLocationSet(getNumberOfDenseIds()));
+    DLS.setOut(LiveLocationSet(getNumberOfDenseIds()));
+  }
+  return DLS;
+}
+
+const LiveDFFwk::TransferInfo & LiveDFFwk::getTransferInfo(DFNode *N) {
+  assert(N && "Node must not be null!");
+  auto Pair = mTransferInfo.try_emplace(N);
+  auto &Info = Pair.first->second;
+  if (!Pair.second)
+    return Info;
+  auto DefItr = mDefInfo->find(N);
+  assert(DefItr != mDefInfo->end() && DefItr->get<DefUseSet>() &&
+    "Def-use set must not be null!");
+  auto &DU = DefItr->get<DefUseSet>();
+  Info.DU = DU.get();
+  Info.Gen.resize(getNumberOfDenseIds());
+  Info.Kill.resize(getNumberOfDenseIds());
+  for (auto &Loc : DU->getUses())
+    if (auto Id = getDenseId(Loc))
+      Info.Gen.set(*Id);
+    else
+      Info.GenLocations.insert(Loc);
+  // Only locations with the same pointer may be killed by a definition.
+  for (auto &Loc : DU->getDefs()) {
+    auto PtrItr = mDensePtrs.find(Loc.Ptr);
+    if (PtrItr == mDensePtrs.end())
+      continue;
+    for (auto Id : PtrItr->second)
+      if (!Info.Kill.test(Id) && DU->hasDef(mDenseLocations[Id]))
+        Info.Kill.set(Id);
+  }
+  return Info;
+}
+
+void LiveDFFwk::materialize(DFRegion *R) {
+  assert(R && "Region must not be null!");
+  for (auto *N : R->getNodes()) {
+    auto I = mDenseInfo.find(N);
+    if (I == mDenseInfo.end())
+      continue;
+    auto &LS = (*mLiveInfo)[N];
+    if (!LS)
+      LS = std::make_unique<LiveSet>();
+    LS->setIn(fromDense(I->second->getIn()));
+    LS->setOut(fromDense(I->second->getOut()));
+    mDenseInfo.erase(I);
+    mTransferInfo.erase(N);
+  }
+}
+
 void DataFlowTraits<LiveDFFwk *>::initialize(
   DFNode *N, LiveDFFwk *DFF, GraphType) {
   assert(N && "Node must not be null!");
   assert(DFF && "Data-flow framework must not be null!");
   DFF->getLiveInfo().insert(
     std::make_pair(N, std::make_unique<LiveSet>()));
+  DFF->getDenseValue(N);
 }
 
 bool DataFlowTraits<LiveDFFwk*>::transferFunction(
@@ -122,26 +270,26 @@ bool DataFlowTraits<LiveDFFwk*>::transferFunction(
   // Note, that transfer function is never evaluated for the exit node.
   assert(N && "Node must not be null!");
   assert(DFF && "Data-flow framework must not be null!");
-  auto I = DFF->getLiveInfo().find(N);
-  assert(I != DFF->getLiveInfo().end() && I->get<LiveSet>() &&
-    "Data-flow value must be specified!");
-  auto &LS = I->get<LiveSet>();
-  LS->setOut(std::move(V)); // Do not use V below to avoid undefined behavior.
+  auto &LS = DFF->getDenseValue(N);
+  LS.setOut(std::move(V)); // Do not use V below to avoid undefined behavior.
   if (isa<DFEntry>(N)) {
-    if (LS->getIn() != LS->getOut()) {
-      LS->setIn(LS->getOut());
+    if (LS.getIn() != LS.getOut()) {
+      LS.setIn(LS.getOut());
       return true;
     }
     return false;
   }
-  auto DefItr = DFF->getDefInfo().find(N);
-  assert(DefItr != DFF->getDefInfo().end() && DefItr->get<DefUseSet>() &&
-    "Def-use set must not be null!");
-  auto &DU = DefItr->get<DefUseSet>();
-  ValueType newIn(DU->getUses());
-  for (auto &Loc : LS->getOut()) {
-    if (!DU->hasDef(Loc))
-      newIn.insert(Loc);
+  auto &TI = DFF->getTransferInfo(N);
+  // IN = USE + (OUT - DEF), locations with dense numbers are processed
+  // word by word.
+  ValueType newIn(DFF->getNumberOfDenseIds());
+  newIn.getDense() = LS.getOut().getDense();
+  newIn.getDense().reset(TI.Kill);
+  newIn.getDense() |= TI.Gen;
+  newIn.getLocations() = TI.GenLocations;
+  for (auto &Loc : LS.getOut().getLocations()) {
+    if (!TI.DU->hasDef(Loc))
+      newIn.getLocations().insert(Loc);
   }
   LLVM_DEBUG(
     dbgs() << "[LIVE] Live locations analysis, transfer function results for:";
@@ -154,15 +302,15 @@ bool DataFlowTraits<LiveDFFwk*>::transferFunction(
     dbgs() << " unknown node.\n";
   }
   dbgs() << "IN:\n";
-  for (auto &Loc : newIn)
+  for (auto &Loc : DFF->fromDense(newIn))
     (printLocationSource(dbgs(), Loc.Ptr, DFF->getDomTree()), dbgs() << "\n");
   dbgs() << "OUT:\n";
-  for (auto &Loc : LS->getOut())
+  for (auto &Loc : DFF->fromDense(LS.getOut()))
     (printLocationSource(dbgs(), Loc.Ptr, DFF->getDomTree()), dbgs() << "\n");
   dbgs() << "[END LIVE]\n";
   );
-  if (LS->getIn() != newIn) {
-    LS->setIn(std::move(newIn));
+  if (LS.getIn() != newIn) {
+    LS.setIn(std::move(newIn));
     return true;
   }
   return false;
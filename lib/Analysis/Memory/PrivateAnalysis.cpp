@@ -37,6 +37,7 @@
 #include "tsar/Analysis/Memory/MemoryAccessUtils.h"
 #include "tsar/Analysis/Memory/MemoryTraitUtils.h"
 #include "tsar/Analysis/Memory/Utils.h"
+#include "tsar/Core/PassProfiler.h"
 #include "tsar/Core/Query.h"
 #include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/IRUtils.h"
@@ -70,6 +71,11 @@ using bcl::operator "" _b;
 #define DEBUG_TYPE "private"
 
 MEMORY_TRAIT_STATISTIC(NumTraits)
+STATISTIC(NumColdLoops, "Number of loops analyzed without dependence tests");
+STATISTIC(NumDependencePairs,
+  "Number of pairs of memory accesses which may alias");
+STATISTIC(NumPrunedPairs,
+  "Number of pairs of memory accesses which have not been tested");
 
 char PrivateRecognitionPass::ID = 0;
 INITIALIZE_PASS_IN_GROUP_BEGIN(PrivateRecognitionPass, "private",
@@ -84,23 +90,11 @@ INITIALIZE_PASS_DEPENDENCY(EstimateMemoryPass)
 INITIALIZE_PASS_DEPENDENCY(DependenceAnalysisWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(ScalarEvolutionWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(ColdLoopsWrapper)
 INITIALIZE_PASS_IN_GROUP_END(PrivateRecognitionPass, "private",
   "Private Variable Analysis", false, true,
   DefaultQueryManager::PrintPassGroup::getPassRegistry())
 
-namespace tsar {
-namespace detail {
-/// Internal representation of cache which stores dependence analysis results.
-struct DependenceCache {
-  using SrcDstPair = std::pair<Instruction *, Instruction *>;
-  using DependenceConfusedPair =
-    std::pair<std::unique_ptr<Dependence>, unsigned short>;
-  using CacheT = DenseMap<SrcDstPair, DependenceConfusedPair>;
-  CacheT Impl;
-};
-}
-}
-
 bool PrivateRecognitionPass::runOnFunction(Function &F) {
   releaseMemory();
   auto &GlobalOpts = getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
@@ -120,12 +114,13 @@ bool PrivateRecognitionPass::runOnFunction(Function &F) {
   mDL = &F.getParent()->getDataLayout();
   mTLI = &getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(F);
   mSE = &getAnalysis<ScalarEvolutionWrapperPass>().getSE();
+  if (auto &CLP{getAnalysis<ColdLoopsWrapper>()})
+    mColdLoops = &CLP.get();
   auto *DFF = cast<DFFunction>(RegionInfo.getTopLevelRegion());
   GraphNumbering<const AliasNode *> Numbers;
   numberGraph(mAliasTree, &Numbers);
   AliasTreeRelation AliasSTR(mAliasTree);
-  DependenceCache Cache;
-  resolveCandidats(Numbers, AliasSTR, DFF, Cache);
+  resolveCandidats(Numbers, AliasSTR, DFF);
   return false;
 }
 
@@ -504,7 +499,7 @@ void PrivateRecognitionPass::collectHeaderAccesses(
 
 void PrivateRecognitionPass::resolveCandidats(
     const GraphNumbering<const AliasNode *> &Numbers,
-    const AliasTreeRelation &AliasSTR, DFRegion *R, DependenceCache &Cache) {
+    const AliasTreeRelation &AliasSTR, DFRegion *R) {
   assert(R && "Region must not be null!");
   if (auto *L = dyn_cast<DFLoop>(R)) {
     LLVM_DEBUG(dbgs() << "[PRIVATE]: analyze loop ";
@@ -530,7 +525,7 @@ void PrivateRecognitionPass::resolveCandidats(
       NodeTraits.insert(
         std::make_pair(&N, std::make_tuple(TraitList(), UnknownList())));
     DependenceMap Deps;
-    collectDependencies(L->getLoop(), Deps, Cache);
+    collectDependencies(L->getLoop(), AliasSTR, Deps);
     resolveAccesses(L->getLoop(), R->getLatchNode(), R->getExitNode(),
       *DefItr->get<DefUseSet>(), *LiveItr->get<LiveSet>(), Deps, AliasSTR,
       ExplicitAccesses, ExplicitUnknowns, NodeTraits);
@@ -543,7 +538,7 @@ void PrivateRecognitionPass::resolveCandidats(
       Deps, PrivInfo.first->get<DependenceSet>());
   }
   for (auto I = R->region_begin(), E = R->region_end(); I != E; ++I)
-    resolveCandidats(Numbers, AliasSTR, *I, Cache);
+    resolveCandidats(Numbers, AliasSTR, *I);
 }
 
 void PrivateRecognitionPass::insertDependence(const Dependence &Dep,
@@ -614,128 +609,203 @@ void PrivateRecognitionPass::insertDependence(const Dependence &Dep,
                    Deps);
 }
 
-void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
-    DependenceCache &Cache) {
+void PrivateRecognitionPass::collectDependencies(Loop *L,
+    const AliasTreeRelation &AliasSTR, DependenceMap &Deps) {
   auto &AA = mAliasTree->getAliasAnalysis();
-  std::vector<Instruction *> LoopInsts;
+  bool IsCold{mColdLoops && L->getLoopID() &&
+              mColdLoops->count(L->getLoopID())};
+  if (IsCold) {
+    ++NumColdLoops;
+    LLVM_DEBUG(dbgs() << "[PRIVATE]: skip dependence tests in a cold loop\n");
+  }
+  // Memory accesses in a loop in order of instructions. Explicit accesses
+  // (loads and stores) have a location. Other accesses (for example, calls)
+  // have no location.
+  std::vector<std::pair<Instruction *, MemoryLocation>> Accesses;
+  SmallVector<unsigned, 8> Unknowns;
+  // Explicit accesses grouped by alias nodes which contain accessed
+  // locations. Each group is identified by a preorder index of a node in
+  // the alias tree.
+  DenseMap<unsigned, SmallVector<unsigned, 4>> Groups;
   for (auto *BB : L->getBlocks())
-    for (auto &I : *BB)
-      LoopInsts.push_back(&I);
-  for (auto SrcItr = LoopInsts.begin(), EndItr = LoopInsts.end();
-       SrcItr != EndItr; ++SrcItr) {
-    if (!(**SrcItr).mayReadOrWriteMemory())
-      continue;
-    auto Src = getLoadOrStoreLocation(*SrcItr);
-    if (!Src.Ptr) {
-      if (auto II = dyn_cast<IntrinsicInst>(*SrcItr))
+    for (auto &I : *BB) {
+      if (!I.mayReadOrWriteMemory())
+        continue;
+      if (auto II = dyn_cast<IntrinsicInst>(&I))
         if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
           continue;
-      for (auto DstItr = SrcItr; DstItr != EndItr; ++DstItr) {
-        if (!(**DstItr).mayReadOrWriteMemory())
-          continue;
-        if (auto II = dyn_cast<IntrinsicInst>(*DstItr))
-          if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
-            continue;
-        trait::Dependence::Flag Flag = trait::Dependence::May |
-          trait::Dependence::UnknownDistance |
-          (!isa<CallBase>(*SrcItr) && !isa<CallBase>(*DstItr)
-             ? trait::Dependence::UnknownCause
-             : trait::Dependence::CallCause);
-        DependenceImp::Descriptor Dptr;
-        Dptr.set<trait::Flow, trait::Anti, trait::Output>();
-        SmallVector<Value *, 2> Causes;
-        if (isa<CallBase>(*SrcItr))
-          Causes.push_back(*SrcItr);
-        if (isa<CallBase>(*DstItr))
-          Causes.push_back(*DstItr);
-        auto insertUnknownDep =
-          [this, &AA, &SrcItr, &DstItr, &Dptr, Flag, &Causes, &Deps](
-            Instruction &, MemoryLocation &&Loc, unsigned,
-            AccessInfo R, AccessInfo W) {
-          if (R == AccessInfo::No && W == AccessInfo::No)
-            return;
-          if (AA.getModRefInfo(*SrcItr, Loc) == ModRefInfo::NoModRef)
-            return;
-          if (AA.getModRefInfo(*DstItr, Loc) == ModRefInfo::NoModRef)
-            return;
-          updateDependence(mAliasTree->find(Loc), Dptr, Flag, DistanceInfo{},
-                           Deps, Causes);
-        };
-        auto stab = [](Instruction &, AccessInfo, AccessInfo) {};
-        LLVM_DEBUG(dbgs() << "[PRIVATE]: conservatively assume dependence: ";
-                   (**SrcItr).print(dbgs()); dbgs() << "\n";
-                   (**DstItr).print(dbgs()); dbgs() << "\n");
-        for_each_memory(**SrcItr, *mTLI, insertUnknownDep, stab);
-        for_each_memory(**DstItr, *mTLI, insertUnknownDep, stab);
+      auto Loc{getLoadOrStoreLocation(&I)};
+      if (Loc.Ptr) {
+        auto *EM{mAliasTree->find(Loc)};
+        assert(EM && "Estimate memory location must not be null!");
+        auto *AN{EM->getAliasNode(*mAliasTree)};
+        Groups[AliasSTR.getIndex(AN)].push_back(Accesses.size());
+      } else {
+        Unknowns.push_back(Accesses.size());
       }
+      Accesses.emplace_back(&I, Loc);
+    }
+  // Assume dependence between an unknown access and an arbitrary access
+  // which follows it.
+  auto assumeUnknownDependence = [this, &AA, &Deps](Instruction *SrcInst,
+                                                    Instruction *DstInst) {
+    trait::Dependence::Flag Flag = trait::Dependence::May |
+      trait::Dependence::UnknownDistance |
+      (!isa<CallBase>(SrcInst) && !isa<CallBase>(DstInst)
+         ? trait::Dependence::UnknownCause
+         : trait::Dependence::CallCause);
+    DependenceImp::Descriptor Dptr;
+    Dptr.set<trait::Flow, trait::Anti, trait::Output>();
+    SmallVector<Value *, 2> Causes;
+    if (isa<CallBase>(SrcInst))
+      Causes.push_back(SrcInst);
+    if (isa<CallBase>(DstInst))
+      Causes.push_back(DstInst);
+    auto insertUnknownDep =
+      [this, &AA, SrcInst, DstInst, &Dptr, Flag, &Causes, &Deps](
+        Instruction &, MemoryLocation &&Loc, unsigned,
+        AccessInfo R, AccessInfo W) {
+      if (R == AccessInfo::No && W == AccessInfo::No)
+        return;
+      PassProfiler::countAliasQuery();
+      if (AA.getModRefInfo(SrcInst, Loc) == ModRefInfo::NoModRef)
+        return;
+      PassProfiler::countAliasQuery();
+      if (AA.getModRefInfo(DstInst, Loc) == ModRefInfo::NoModRef)
+        return;
+      updateDependence(mAliasTree->find(Loc), Dptr, Flag, DistanceInfo{},
+                       Deps, Causes);
+    };
+    auto stab = [](Instruction &, AccessInfo, AccessInfo) {};
+    LLVM_DEBUG(dbgs() << "[PRIVATE]: conservatively assume dependence: ";
+               SrcInst->print(dbgs()); dbgs() << "\n";
+               DstInst->print(dbgs()); dbgs() << "\n");
+    for_each_memory(*SrcInst, *mTLI, insertUnknownDep, stab);
+    for_each_memory(*DstInst, *mTLI, insertUnknownDep, stab);
+  };
+  for (auto SrcIdx : Unknowns)
+    for (unsigned DstIdx = SrcIdx, EndIdx = Accesses.size(); DstIdx < EndIdx;
+         ++DstIdx)
+      assumeUnknownDependence(Accesses[SrcIdx].first, Accesses[DstIdx].first);
+  // Assume dependence between an explicit access and an unknown access which
+  // follows it.
+  auto assumeDependence = [this, &AA, &Deps](Instruction *SrcInst,
+                                             const MemoryLocation &Src,
+                                             Instruction *DstInst) {
+    PassProfiler::countAliasQuery();
+    if (AA.getModRefInfo(DstInst, Src) == ModRefInfo::NoModRef)
+      return;
+    trait::Dependence::Flag Flag = trait::Dependence::May |
+      trait::Dependence::UnknownDistance |
+      (!isa<CallBase>(DstInst) ? trait::Dependence::UnknownCause :
+        trait::Dependence::CallCause);
+    DependenceImp::Descriptor Dptr;
+    Dptr.set<trait::Flow, trait::Anti, trait::Output>();
+    LLVM_DEBUG(dbgs() << "[PRIVATE]: conservatively assume dependence: ";
+               SrcInst->print(dbgs()); dbgs() << "\n";
+               DstInst->print(dbgs()); dbgs() << "\n");
+    updateDependence(mAliasTree->find(Src), Dptr, Flag, DistanceInfo{},
+                     Deps, isa<CallBase>(DstInst) ? DstInst : nullptr);
+  };
+  if (!Unknowns.empty())
+    for (auto &Group : Groups)
+      for (auto SrcIdx : Group.second)
+        for (auto UnknownItr = std::upper_bound(Unknowns.begin(),
+                                                Unknowns.end(), SrcIdx),
+                  UnknownEndItr = Unknowns.end();
+             UnknownItr != UnknownEndItr; ++UnknownItr)
+          assumeDependence(Accesses[SrcIdx].first, Accesses[SrcIdx].second,
+                           Accesses[*UnknownItr].first);
+  // Perform dependence test for explicit accesses.
+  std::size_t NumPairs{0};
+  auto testDependence = [this, L, IsCold, &Deps, &NumPairs](
+      Instruction *SrcInst, const MemoryLocation &Src, Instruction *DstInst,
+      const MemoryLocation &Dst) {
+    ++NumPairs;
+    if (!SrcInst->mayWriteToMemory() && !DstInst->mayWriteToMemory()) {
+      LLVM_DEBUG(dbgs() << "[PRIVATE]: ignore input dependence\n");
+      return;
+    }
+    // Results of dependence tests are memoized by dependence analysis, so
+    // the same pair of accesses is not tested again for outer loops.
+    unsigned short ConfusedLevels;
+    const Dependence *Dep = nullptr;
+    if (!IsCold) {
+      Dep = mDepInfo->dependsCached(SrcInst, DstInst, true, &ConfusedLevels);
+    } else if (auto Cached{mDepInfo->getCachedDependence(SrcInst, DstInst,
+                                                          true,
+                                                          &ConfusedLevels)}) {
+      Dep = *Cached;
     } else {
-      for (auto DstItr = SrcItr; DstItr != EndItr; ++DstItr) {
-        auto Dst = getLoadOrStoreLocation(*DstItr);
-        if (!Dst.Ptr) {
-          if (!(**DstItr).mayReadOrWriteMemory())
-            continue;
-          if (auto II = dyn_cast<IntrinsicInst>(*DstItr))
-            if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
-              continue;
-          if (AA.getModRefInfo(*DstItr, Src) == ModRefInfo::NoModRef)
-            continue;
-          trait::Dependence::Flag Flag = trait::Dependence::May |
-            trait::Dependence::UnknownDistance |
-            (!isa<CallBase>(*DstItr) ? trait::Dependence::UnknownCause :
-              trait::Dependence::CallCause);
-          DependenceImp::Descriptor Dptr;
-          Dptr.set<trait::Flow, trait::Anti, trait::Output>();
-          LLVM_DEBUG(dbgs() << "[PRIVATE]: conservatively assume dependence: ";
-                     (**SrcItr).print(dbgs()); dbgs() << "\n";
-                     (**DstItr).print(dbgs()); dbgs() << "\n");
-          updateDependence(mAliasTree->find(Src), Dptr, Flag, DistanceInfo{},
-                           Deps, isa<CallBase>(*DstItr) ? *DstItr : nullptr);
-        } else {
-          if (!(*SrcItr)->mayWriteToMemory() &&
-              !(*DstItr)->mayWriteToMemory()) {
-            LLVM_DEBUG(dbgs() << "[PRIVATE]: ignore input dependence\n");
-            continue;
-          }
-          auto CacheItr = Cache.Impl.find(std::make_pair(*SrcItr, *DstItr));
-          unsigned short ConfusedLevels;
-          Dependence *Dep = nullptr;
-          if (CacheItr != Cache.Impl.end()) {
-            Dep = CacheItr->second.first.get();
-            ConfusedLevels = CacheItr->second.second;
-          } else {
-            auto D = mDepInfo->depends(*SrcItr, *DstItr, true, &ConfusedLevels);
-            Dep = D.get();
-            Cache.Impl.try_emplace(std::make_pair(*SrcItr, *DstItr),
-              std::move(D), ConfusedLevels);
-          }
-          if (Dep) {
-            LLVM_DEBUG(
-              dbgs() << "[PRIVATE]: dependence found: ";
-              Dep->dump(dbgs());
-              (**SrcItr).print(dbgs()); dbgs() << "\n";
-              (**DstItr).print(dbgs()); dbgs() << "\n";
-            );
-            // Do not use Dependence::isLoopIndependent() to check loop
-            // independent dependencies. This method returns `may` instead of
-            // `must`. This means that if it returns `true` than dependency
-            // may be loop-carried or may arise inside a single iteration.
-            insertDependence(*Dep, Src, Dst, trait::Dependence::No, *L, Deps);
-          } else if (L->getLoopDepth() <= ConfusedLevels) {
-            LLVM_DEBUG(dbgs() << "[PRIVATE]: assume confused dependence"
-              " (confused levels " << ConfusedLevels << ")\n");
-            DependenceImp::Descriptor Dptr;
-            Dptr.set<trait::Flow, trait::Anti, trait::Output>();
-            trait::Dependence::Flag Flag = trait::Dependence::ConfusedCause |
-              trait::Dependence::LoadStoreCause | trait::Dependence::May;
-            updateDependence(mAliasTree->find(Src), Dptr, Flag, DistanceInfo{},
-                             Deps);
-            updateDependence(mAliasTree->find(Dst), Dptr, Flag, DistanceInfo{},
-                             Deps);
-          }
-        }
-      }
+      // Tests are not performed for cold loops. Conservative results are not
+      // memoized because they must not be used for other loops.
+      ConfusedLevels = L->getLoopDepth();
+    }
+    if (Dep) {
+      LLVM_DEBUG(
+        dbgs() << "[PRIVATE]: dependence found: ";
+        Dep->dump(dbgs());
+        SrcInst->print(dbgs()); dbgs() << "\n";
+        DstInst->print(dbgs()); dbgs() << "\n";
+      );
+      // Do not use Dependence::isLoopIndependent() to check loop
+      // independent dependencies. This method returns `may` instead of
+      // `must`. This means that if it returns `true` than dependency
+      // may be loop-carried or may arise inside a single iteration.
+      insertDependence(*Dep, Src, Dst, trait::Dependence::No, *L, Deps);
+    } else if (L->getLoopDepth() <= ConfusedLevels) {
+      LLVM_DEBUG(dbgs() << "[PRIVATE]: assume confused dependence"
+        " (confused levels " << ConfusedLevels << ")\n");
+      DependenceImp::Descriptor Dptr;
+      Dptr.set<trait::Flow, trait::Anti, trait::Output>();
+      trait::Dependence::Flag Flag = trait::Dependence::ConfusedCause |
+        trait::Dependence::LoadStoreCause | trait::Dependence::May;
+      updateDependence(mAliasTree->find(Src), Dptr, Flag, DistanceInfo{},
+                       Deps);
+      updateDependence(mAliasTree->find(Dst), Dptr, Flag, DistanceInfo{},
+                       Deps);
     }
+  };
+  auto testDependenceInOrder = [&Accesses, &testDependence](unsigned LHS,
+                                                            unsigned RHS) {
+    if (RHS < LHS)
+      std::swap(LHS, RHS);
+    testDependence(Accesses[LHS].first, Accesses[LHS].second,
+                   Accesses[RHS].first, Accesses[RHS].second);
+  };
+  // Locations from unrelated alias nodes do not alias, so accesses to these
+  // locations are independent. Groups are sorted in preorder of alias nodes,
+  // so all descendants of a node immediately follow it and only pairs of
+  // accesses from related nodes are tested.
+  SmallVector<std::pair<unsigned, ArrayRef<unsigned>>, 16> SortedGroups;
+  std::size_t NumExplicitAccesses{0};
+  for (auto &Group : Groups) {
+    SortedGroups.emplace_back(Group.first, Group.second);
+    NumExplicitAccesses += Group.second.size();
+  }
+  llvm::sort(SortedGroups, [](auto &LHS, auto &RHS) {
+    return LHS.first < RHS.first;
+  });
+  for (auto GroupItr = SortedGroups.begin(), GroupEndItr = SortedGroups.end();
+       GroupItr != GroupEndItr; ++GroupItr) {
+    auto &Group{GroupItr->second};
+    for (unsigned I = 0, EI = Group.size(); I < EI; ++I)
+      for (unsigned J = I; J < EI; ++J)
+        testDependence(Accesses[Group[I]].first, Accesses[Group[I]].second,
+                       Accesses[Group[J]].first, Accesses[Group[J]].second);
+    auto *AN{AliasSTR.getNode(GroupItr->first)};
+    auto LastDescendant{GroupItr->first + AliasSTR.descendants(AN).size()};
+    for (auto DescendantItr = std::next(GroupItr);
+         DescendantItr != GroupEndItr &&
+         DescendantItr->first <= LastDescendant;
+         ++DescendantItr)
+      for (auto SrcIdx : Group)
+        for (auto DstIdx : DescendantItr->second)
+          testDependenceInOrder(SrcIdx, DstIdx);
   }
+  NumDependencePairs += NumPairs;
+  NumPrunedPairs +=
+    NumExplicitAccesses * (NumExplicitAccesses + 1) / 2 - NumPairs;
 }
 
 void PrivateRecognitionPass::resolveAccesses(Loop *L, const DFNode *LatchNode,
@@ -1418,6 +1488,7 @@ void PrivateRecognitionPass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<DependenceAnalysisWrapperPass>();
   AU.addRequired<TargetLibraryInfoWrapperPass>();
   AU.addRequired<ScalarEvolutionWrapperPass>();
+  AU.addRequired<ColdLoopsWrapper>();
   AU.setPreservesAll();
 }
 
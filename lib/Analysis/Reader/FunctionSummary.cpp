@@ -0,0 +1,292 @@
+//===- FunctionSummary.cpp - Reader/Writer For Summaries --------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements passes to write summaries of functions defined in
+// a module and to attach summaries of functions defined in other modules to
+// declarations of these functions. So, a whole program can be analyzed one
+// translation unit after another:
+// - at the first step summaries of all translation units are written to
+//   a directory (-fsummary-emit=<dir>),
+// - at the second step each translation unit is analyzed with summaries of
+//   callees imported from this directory (-fsummary-use=<dir>).
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Attributes.h"
+#include "tsar/Analysis/Reader/Passes.h"
+#include "tsar/Analysis/Reader/SummaryJSON.h"
+#include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/OutputFile.h"
+#include <bcl/utility.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <llvm/InitializePasses.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/Debug.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <algorithm>
+
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "function-summary"
+
+STATISTIC(NumEmittedSummaries, "Number of emitted function summaries");
+STATISTIC(NumImportedSummaries, "Number of imported function summaries");
+STATISTIC(NumMismatchedSummaries,
+          "Number of function summaries skipped due to a type mismatch");
+
+namespace {
+class FunctionSummaryWriter : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  FunctionSummaryWriter() : ModulePass(ID) {
+    initializeFunctionSummaryWriterPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+};
+
+class FunctionSummaryReader : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  FunctionSummaryReader() : ModulePass(ID) {
+    initializeFunctionSummaryReaderPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+private:
+  /// Load summaries from a specified file, return false on failure.
+  bool load(Module &M, StringRef DataFile,
+            StringMap<trait::FunctionSummary> &Summaries);
+};
+
+/// Return name of a file to store summary of a specified module.
+///
+/// The name contains a hash of a full path to a source file, so different
+/// sources with the same name do not collide.
+std::string getSummaryPath(StringRef Dir, const Module &M) {
+  MD5 Hash;
+  Hash.update(M.getSourceFileName());
+  MD5::MD5Result Res;
+  Hash.final(Res);
+  auto Digest{Res.digest()};
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, sys::path::stem(M.getSourceFileName()) + "-" +
+                              Digest + ".json");
+  return std::string(Path);
+}
+
+/// Return a printed type of a specified function.
+std::string getFunctionType(const Function &F) {
+  std::string Type;
+  raw_string_ostream OS(Type);
+  F.getFunctionType()->print(OS);
+  return OS.str();
+}
+}
+
+char FunctionSummaryWriter::ID = 0;
+INITIALIZE_PASS_BEGIN(FunctionSummaryWriter, "function-summary-writer",
+  "Function Summary Writer", true, true)
+INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
+INITIALIZE_PASS_END(FunctionSummaryWriter, "function-summary-writer",
+  "Function Summary Writer", true, true)
+
+ModulePass *llvm::createFunctionSummaryWriter() {
+  return new FunctionSummaryWriter;
+}
+
+void FunctionSummaryWriter::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<GlobalOptionsImmutableWrapper>();
+  AU.setPreservesAll();
+}
+
+bool FunctionSummaryWriter::runOnModule(Module &M) {
+  auto &GO{getAnalysis<GlobalOptionsImmutableWrapper>().getOptions()};
+  if (GO.SummaryEmit.empty())
+    return false;
+  trait::ModuleSummary Info;
+  Info[trait::ModuleSummary::Module] = M.getSourceFileName();
+  for (auto &F : M) {
+    // Functions with internal linkage can not be called from other modules.
+    if (F.isDeclaration() || F.hasLocalLinkage())
+      continue;
+    trait::FunctionSummary S;
+    S[trait::FunctionSummary::Name] = F.getName().str();
+    S[trait::FunctionSummary::Type] = getFunctionType(F);
+    S[trait::FunctionSummary::NoIO] = hasFnAttr(F, AttrKind::NoIO);
+    S[trait::FunctionSummary::AlwaysReturn] =
+        hasFnAttr(F, AttrKind::AlwaysReturn);
+    S[trait::FunctionSummary::NoUnwind] = F.doesNotThrow();
+    S[trait::FunctionSummary::ArgMemOnly] = F.onlyAccessesArgMemory();
+    S[trait::FunctionSummary::ReadOnly] = F.onlyReadsMemory();
+    S[trait::FunctionSummary::ReadNone] = F.doesNotAccessMemory();
+    for (auto &Arg : F.args())
+      if (Arg.hasNoCaptureAttr())
+        S[trait::FunctionSummary::NoCapture].insert(Arg.getArgNo());
+    LLVM_DEBUG(dbgs() << "[FUNCTION SUMMARY]: emit summary for "
+                      << F.getName() << "\n");
+    Info[trait::ModuleSummary::Functions].push_back(std::move(S));
+    ++NumEmittedSummaries;
+  }
+  if (auto EC{sys::fs::create_directories(GO.SummaryEmit)}) {
+    M.getContext().diagnose(DiagnosticInfoPGOProfile(
+        GO.SummaryEmit.data(),
+        Twine("unable to create directory: ") + EC.message()));
+    return false;
+  }
+  auto DataFile{getSummaryPath(GO.SummaryEmit, M)};
+  auto OF{OutputFile::create(DataFile, false)};
+  if (!OF) {
+    M.getContext().diagnose(DiagnosticInfoPGOProfile(
+        DataFile.data(), Twine("unable to open file: ") +
+                             errorToErrorCode(OF.takeError()).message()));
+    return false;
+  }
+  OF->getStream() << json::Parser<trait::ModuleSummary>::unparseAsObject(Info);
+  if (auto E{OF->clear()}) {
+    std::string Msg;
+    raw_string_ostream{Msg} << E;
+    M.getContext().diagnose(DiagnosticInfoPGOProfile(
+        DataFile.data(), Twine("unable to write file: ") + Msg));
+  }
+  return false;
+}
+
+char FunctionSummaryReader::ID = 0;
+INITIALIZE_PASS_BEGIN(FunctionSummaryReader, "function-summary-reader",
+  "Function Summary Reader", false, false)
+INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
+INITIALIZE_PASS_END(FunctionSummaryReader, "function-summary-reader",
+  "Function Summary Reader", false, false)
+
+ModulePass *llvm::createFunctionSummaryReader() {
+  return new FunctionSummaryReader;
+}
+
+void FunctionSummaryReader::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<GlobalOptionsImmutableWrapper>();
+  AU.setPreservesCFG();
+}
+
+bool FunctionSummaryReader::load(Module &M, StringRef DataFile,
+    StringMap<trait::FunctionSummary> &Summaries) {
+  LLVM_DEBUG(dbgs() << "[FUNCTION SUMMARY]: load summaries from '" << DataFile
+                    << "'\n");
+  auto FileOrErr{MemoryBuffer::getFile(DataFile)};
+  if (auto EC{FileOrErr.getError()}) {
+    M.getContext().diagnose(DiagnosticInfoPGOProfile(
+        DataFile.data(), Twine("unable to open file: ") + EC.message()));
+    return false;
+  }
+  json::Parser<> Parser((**FileOrErr).getBuffer().str());
+  trait::ModuleSummary Info;
+  if (!Parser.parse(Info)) {
+    for (auto D : Parser.errors())
+      M.getContext().diagnose(
+          DiagnosticInfoPGOProfile(DataFile.data(), D, DS_Note));
+    M.getContext().diagnose(DiagnosticInfoPGOProfile(
+        DataFile.data(), "unable to parse function summaries"));
+    return false;
+  }
+  // Summaries of the current module are not necessary.
+  if (Info[trait::ModuleSummary::Module] == M.getSourceFileName())
+    return true;
+  for (auto &S : Info[trait::ModuleSummary::Functions]) {
+    auto Name{S[trait::FunctionSummary::Name]};
+    Summaries.try_emplace(Name, std::move(S));
+  }
+  return true;
+}
+
+bool FunctionSummaryReader::runOnModule(Module &M) {
+  auto &GO{getAnalysis<GlobalOptionsImmutableWrapper>().getOptions()};
+  if (GO.SummaryUse.empty())
+    return false;
+  // Sort files to make the choice between summaries of functions with the same
+  // name independent of the order of files in a directory.
+  std::vector<std::string> Files;
+  std::error_code EC;
+  for (sys::fs::directory_iterator I(GO.SummaryUse, EC), EI; I != EI && !EC;
+       I.increment(EC))
+    if (sys::path::extension(I->path()) == ".json")
+      Files.push_back(I->path());
+  if (EC) {
+    M.getContext().diagnose(DiagnosticInfoPGOProfile(
+        GO.SummaryUse.data(),
+        Twine("unable to read directory: ") + EC.message()));
+    return false;
+  }
+  llvm::sort(Files);
+  StringMap<trait::FunctionSummary> Summaries;
+  for (auto &File : Files)
+    load(M, File, Summaries);
+  bool Changed{false};
+  for (auto &F : M) {
+    if (!F.isDeclaration() || F.isIntrinsic())
+      continue;
+    auto Itr{Summaries.find(F.getName())};
+    if (Itr == Summaries.end())
+      continue;
+    auto &S{Itr->second};
+    // Functions with the same name in different modules may be unrelated,
+    // for example, if they are declared without prototypes.
+    if (S[trait::FunctionSummary::Type] != getFunctionType(F)) {
+      LLVM_DEBUG(dbgs() << "[FUNCTION SUMMARY]: skip summary for "
+                        << F.getName() << ", type mismatch: "
+                        << S[trait::FunctionSummary::Type] << "\n");
+      ++NumMismatchedSummaries;
+      continue;
+    }
+    if (S[trait::FunctionSummary::NoIO])
+      addFnAttr(F, AttrKind::NoIO);
+    if (S[trait::FunctionSummary::AlwaysReturn])
+      addFnAttr(F, AttrKind::AlwaysReturn);
+    if (S[trait::FunctionSummary::NoUnwind])
+      F.setDoesNotThrow();
+    if (S[trait::FunctionSummary::ReadNone])
+      F.setDoesNotAccessMemory();
+    else if (S[trait::FunctionSummary::ReadOnly])
+      F.setOnlyReadsMemory();
+    if (S[trait::FunctionSummary::ArgMemOnly])
+      F.setOnlyAccessesArgMemory();
+    for (auto ArgNo : S[trait::FunctionSummary::NoCapture])
+      if (ArgNo < F.arg_size())
+        F.addParamAttr(ArgNo, Attribute::NoCapture);
+    LLVM_DEBUG(dbgs() << "[FUNCTION SUMMARY]: import summary for "
+                      << F.getName() << "\n");
+    ++NumImportedSummaries;
+    Changed = true;
+  }
+  return Changed;
+}
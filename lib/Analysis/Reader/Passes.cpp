@@ -31,4 +31,7 @@ void llvm::initializeAnalysisReader(PassRegistry &Registry) {
   initializeAnalysisReaderPass(Registry);
   initializeAnalysisWriterPass(Registry);
   initializeRegionWeightsEstimatorPass(Registry);
+  initializeColdLoopsCollectorPass(Registry);
+  initializeFunctionSummaryWriterPass(Registry);
+  initializeFunctionSummaryReaderPass(Registry);
 }
@@ -25,6 +25,7 @@
 #include "tsar/Analysis/Reader/RegionWeights.h"
 #include "tsar/Analysis/Attributes.h"
 #include "tsar/Analysis/KnownFunctionTraits.h"
+#include "tsar/Analysis/Memory/ColdLoops.h"
 #include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/IRUtils.h"
 #include <llvm/ADT/SCCIterator.h>
@@ -229,3 +230,71 @@ void RegionWeightsEstimator::getAnalysisUsage(AnalysisUsage &AU) const {
 ModulePass *llvm::createRegionWeightsEstimator() {
   return new RegionWeightsEstimator();
 }
+
+namespace {
+/// This pass collects loops which self weights are less than
+/// GlobalOptions::LoopParallelThreshold.
+///
+/// Loops with unknown weights are never treated as cold loops.
+class ColdLoopsCollector : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  ColdLoopsCollector() : ModulePass(ID) {
+    initializeColdLoopsCollectorPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override;
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+};
+}
+
+char ColdLoopsCollector::ID = 0;
+
+INITIALIZE_PASS_BEGIN(ColdLoopsCollector, "cold-loops",
+  "Cold Loops Collector", true, true)
+INITIALIZE_PASS_DEPENDENCY(GlobalOptionsImmutableWrapper)
+INITIALIZE_PASS_DEPENDENCY(RegionWeightsEstimator)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(ColdLoopsWrapper)
+INITIALIZE_PASS_END(ColdLoopsCollector, "cold-loops",
+  "Cold Loops Collector", true, true)
+
+bool ColdLoopsCollector::runOnModule(Module &M) {
+  auto &CLP{getAnalysis<ColdLoopsWrapper>()};
+  if (!CLP)
+    return false;
+  CLP->clear();
+  auto &GO{getAnalysis<GlobalOptionsImmutableWrapper>().getOptions()};
+  auto &Weights{getAnalysis<RegionWeightsEstimator>()};
+  for (auto &F : M) {
+    if (F.isDeclaration())
+      continue;
+    auto &LI{getAnalysis<LoopInfoWrapperPass>(F).getLoopInfo()};
+    for_each_loop(LI, [&CLP, &GO, &Weights](const Loop *L) {
+      auto LoopID{L->getLoopID()};
+      if (!LoopID)
+        return;
+      auto W{Weights.getSelfWeight(LoopID)};
+      if (!W.first.isValid() || W.first >= GO.LoopParallelThreshold)
+        return;
+      CLP->insert(LoopID);
+      LLVM_DEBUG(dbgs() << "[COLD LOOPS]: cold loop at ";
+                 L->getStartLoc().print(dbgs());
+                 dbgs() << ": self weight " << W.first << "\n");
+    });
+  }
+  return false;
+}
+
+void ColdLoopsCollector::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<GlobalOptionsImmutableWrapper>();
+  AU.addRequired<RegionWeightsEstimator>();
+  AU.addRequired<LoopInfoWrapperPass>();
+  AU.addRequired<ColdLoopsWrapper>();
+  AU.setPreservesAll();
+}
+
+ModulePass *llvm::createColdLoopsCollector() {
+  return new ColdLoopsCollector();
+}
@@ -0,0 +1,157 @@
+//===- AnalysisCache.cpp --- Persistent Analysis Cache ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a content-addressed on-disk storage of analysis results.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Core/AnalysisCache.h"
+#include "tsar/Core/tsar-config.h"
+#include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/OutputFile.h"
+#include <llvm/IR/Module.h>
+#include <llvm/Pass.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+/// Update hash with a value of a specified option.
+template<class T> void update(MD5 &Hash, const T &Opt) {
+  static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                "Unsupported type of option!");
+  uint64_t V = static_cast<uint64_t>(Opt);
+  Hash.update(makeArrayRef(reinterpret_cast<const uint8_t *>(&V), sizeof(V)));
+}
+
+void update(MD5 &Hash, StringRef Opt) {
+  update(Hash, Opt.size());
+  Hash.update(Opt);
+}
+
+void update(MD5 &Hash, const std::string &Opt) { update(Hash, StringRef(Opt)); }
+
+void update(MD5 &Hash, const std::vector<std::string> &Opt) {
+  update(Hash, Opt.size());
+  for (auto &O : Opt)
+    update(Hash, O);
+}
+
+/// Update hash with content of a specified file. Results depend on content
+/// of a file, so an entry is not reused if a file is changed in place.
+void updateWithFile(MD5 &Hash, StringRef File) {
+  update(Hash, File);
+  if (auto FileOrErr{MemoryBuffer::getFile(File)})
+    update(Hash, (**FileOrErr).getBuffer());
+}
+
+void updateWithFiles(MD5 &Hash, const std::vector<std::string> &Files) {
+  update(Hash, Files.size());
+  for (auto &File : Files)
+    updateWithFile(Hash, File);
+}
+
+/// Update hash with content of files in a specified directory.
+void updateWithDirectory(MD5 &Hash, StringRef Dir) {
+  std::vector<std::string> Files;
+  std::error_code EC;
+  for (sys::fs::directory_iterator I(Dir, EC), EI; I != EI && !EC;
+       I.increment(EC))
+    Files.push_back(I->path());
+  llvm::sort(Files);
+  for (auto &File : Files)
+    updateWithFile(Hash, File);
+}
+
+/// Update hash with a list of options which may influence analysis results.
+void update(MD5 &Hash, const GlobalOptions &GO) {
+  update(Hash, GO.PrintFilenameOnly);
+  update(Hash, GO.PrintToolVersion);
+  update(Hash, GO.IsSafeTypeCast);
+  update(Hash, GO.InBoundsSubscripts);
+  update(Hash, GO.AnalyzeLibFunc);
+  update(Hash, GO.IgnoreRedundantMemory);
+  update(Hash, GO.UnsafeTfmAnalysis);
+  update(Hash, GO.NoExternalCalls);
+  update(Hash, GO.NoInline);
+  update(Hash, GO.MemoryAccessInlineThreshold);
+  updateWithFiles(Hash, GO.AnalysisUse);
+  if (!GO.ProfileUse.empty())
+    updateWithFile(Hash, GO.ProfileUse);
+  updateWithFiles(Hash, GO.ObjectFilenames);
+  update(Hash, GO.UnknownFunctionWeight);
+  update(Hash, GO.UnknownBuiltinWeight);
+  update(Hash, GO.LoopParallelThreshold);
+  update(Hash, GO.HotLoopsOnly);
+  update(Hash, GO.Delinearize);
+  update(Hash, GO.ExactDependenceBudget);
+  update(Hash, GO.OptRegions);
+  update(Hash, GO.IncrementalAnalysis);
+  // Results depend on summaries of external functions rather than on
+  // the name of a directory they are stored in.
+  if (!GO.SummaryUse.empty())
+    updateWithDirectory(Hash, GO.SummaryUse);
+}
+}
+
+std::string AnalysisCache::computeKey(const Module &M, const GlobalOptions &GO,
+    ArrayRef<const PassInfo *> Passes, unsigned Steps) {
+  MD5 Hash;
+  update(Hash, StringRef(TSAR_VERSION_STRING));
+  update(Hash, GO);
+  update(Hash, Steps);
+  update(Hash, Passes.size());
+  for (auto *PI : Passes)
+    update(Hash, PI->getPassArgument());
+  std::string IR;
+  raw_string_ostream OS(IR);
+  M.print(OS, nullptr);
+  update(Hash, StringRef(OS.str()));
+  MD5::MD5Result Res;
+  Hash.final(Res);
+  return std::string(Res.digest());
+}
+
+std::string AnalysisCache::getPath(StringRef Key) const {
+  SmallString<128> Path(mDir);
+  sys::path::append(Path, Key + ".txt");
+  return std::string(Path);
+}
+
+Optional<std::string> AnalysisCache::load(StringRef Key) const {
+  auto FileOrErr{MemoryBuffer::getFile(getPath(Key))};
+  if (!FileOrErr)
+    return None;
+  return (**FileOrErr).getBuffer().str();
+}
+
+Error AnalysisCache::store(StringRef Key, StringRef Data) const {
+  auto OF{OutputFile::create(getPath(Key), false)};
+  if (!OF)
+    return OF.takeError();
+  OF->getStream() << Data;
+  return OF->clear();
+}
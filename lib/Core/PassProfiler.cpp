@@ -0,0 +1,368 @@
+//===- PassProfiler.cpp ---- Pass Execution Profiler ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a profiler which collects wall time, heap usage and
+// the number of alias queries for each execution of each pass on each
+// function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Core/PassProfiler.h"
+#include "tsar/Support/OutputFile.h"
+#include <bcl/utility.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Analysis/CallGraph.h>
+#include <llvm/Analysis/CallGraphSCCPass.h>
+#include <llvm/Analysis/LoopPass.h>
+#include <llvm/Analysis/RegionInfo.h>
+#include <llvm/Analysis/RegionPass.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/Threading.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace llvm {
+void initializeProfilerFunctionProbePass(PassRegistry &Registry);
+void initializeProfilerModuleProbePass(PassRegistry &Registry);
+void initializeProfilerLoopProbePass(PassRegistry &Registry);
+void initializeProfilerRegionProbePass(PassRegistry &Registry);
+void initializeProfilerCGSCCProbePass(PassRegistry &Registry);
+}
+
+namespace {
+/// Pass which is currently running in a thread.
+struct RunningPass {
+  std::string Category;
+  std::string Pass;
+  std::string Function;
+  std::string Module;
+  std::chrono::steady_clock::time_point Start;
+  size_t Heap;
+  uint64_t AliasQueries;
+};
+
+thread_local SmallVector<RunningPass, 4> RunningPasses;
+thread_local uint64_t NumAliasQueries = 0;
+
+/// This pass registers start or finish of a function pass in the profiler.
+class ProfilerFunctionProbe : public FunctionPass, private bcl::Uncopyable {
+public:
+  static char ID;
+  ProfilerFunctionProbe(StringRef PassName = "", bool IsStart = true)
+      : FunctionPass(ID), mPassName(PassName), mIsStart(IsStart) {
+    initializeProfilerFunctionProbePass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnFunction(Function &F) override {
+    if (mIsStart)
+      PassProfiler::get().enter("function", mPassName, F.getName(),
+                                F.getParent()->getSourceFileName());
+    else
+      PassProfiler::get().exit(mPassName, F.getName());
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+private:
+  std::string mPassName;
+  bool mIsStart;
+};
+
+/// This pass registers start or finish of a module pass in the profiler.
+class ProfilerModuleProbe : public ModulePass, private bcl::Uncopyable {
+public:
+  static char ID;
+  ProfilerModuleProbe(StringRef PassName = "", bool IsStart = true)
+      : ModulePass(ID), mPassName(PassName), mIsStart(IsStart) {
+    initializeProfilerModuleProbePass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &M) override {
+    if (mIsStart)
+      PassProfiler::get().enter("module", mPassName, "", M.getSourceFileName());
+    else
+      PassProfiler::get().exit(mPassName, "");
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+private:
+  std::string mPassName;
+  bool mIsStart;
+};
+
+/// This pass registers start or finish of a loop pass in the profiler.
+class ProfilerLoopProbe : public LoopPass, private bcl::Uncopyable {
+public:
+  static char ID;
+  ProfilerLoopProbe(StringRef PassName = "", bool IsStart = true)
+      : LoopPass(ID), mPassName(PassName), mIsStart(IsStart) {
+    initializeProfilerLoopProbePass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnLoop(Loop *L, LPPassManager &) override {
+    auto *F{L->getHeader()->getParent()};
+    if (mIsStart)
+      PassProfiler::get().enter("loop", mPassName, F->getName(),
+                                F->getParent()->getSourceFileName());
+    else
+      PassProfiler::get().exit(mPassName, F->getName());
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+private:
+  std::string mPassName;
+  bool mIsStart;
+};
+
+/// This pass registers start or finish of a region pass in the profiler.
+class ProfilerRegionProbe : public RegionPass, private bcl::Uncopyable {
+public:
+  static char ID;
+  ProfilerRegionProbe(StringRef PassName = "", bool IsStart = true)
+      : RegionPass(ID), mPassName(PassName), mIsStart(IsStart) {
+    initializeProfilerRegionProbePass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnRegion(Region *R, RGPassManager &) override {
+    auto *F{R->getEntry()->getParent()};
+    if (mIsStart)
+      PassProfiler::get().enter("region", mPassName, F->getName(),
+                                F->getParent()->getSourceFileName());
+    else
+      PassProfiler::get().exit(mPassName, F->getName());
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+private:
+  std::string mPassName;
+  bool mIsStart;
+};
+
+/// This pass registers start or finish of a call graph SCC pass in
+/// the profiler.
+class ProfilerCGSCCProbe : public CallGraphSCCPass, private bcl::Uncopyable {
+public:
+  static char ID;
+  ProfilerCGSCCProbe(StringRef PassName = "", bool IsStart = true)
+      : CallGraphSCCPass(ID), mPassName(PassName), mIsStart(IsStart) {
+    initializeProfilerCGSCCProbePass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnSCC(CallGraphSCC &SCC) override {
+    // Names of all functions in a component are used to identify it.
+    std::string Functions;
+    for (auto *CGN : SCC)
+      if (auto *F{CGN->getFunction()}) {
+        if (!Functions.empty())
+          Functions += ",";
+        Functions += F->getName();
+      }
+    if (mIsStart)
+      PassProfiler::get().enter(
+          "cgscc", mPassName, Functions,
+          SCC.getCallGraph().getModule().getSourceFileName());
+    else
+      PassProfiler::get().exit(mPassName, Functions);
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+private:
+  std::string mPassName;
+  bool mIsStart;
+};
+}
+
+char ProfilerFunctionProbe::ID = 0;
+INITIALIZE_PASS(ProfilerFunctionProbe, "profiler-function-probe",
+                "Pass Profiler (Function Probe)", true, false)
+
+char ProfilerModuleProbe::ID = 0;
+INITIALIZE_PASS(ProfilerModuleProbe, "profiler-module-probe",
+                "Pass Profiler (Module Probe)", true, false)
+
+char ProfilerLoopProbe::ID = 0;
+INITIALIZE_PASS(ProfilerLoopProbe, "profiler-loop-probe",
+                "Pass Profiler (Loop Probe)", true, false)
+
+char ProfilerRegionProbe::ID = 0;
+INITIALIZE_PASS(ProfilerRegionProbe, "profiler-region-probe",
+                "Pass Profiler (Region Probe)", true, false)
+
+char ProfilerCGSCCProbe::ID = 0;
+INITIALIZE_PASS(ProfilerCGSCCProbe, "profiler-cgscc-probe",
+                "Pass Profiler (CGSCC Probe)", true, false)
+
+PassProfiler & PassProfiler::get() {
+  static PassProfiler Profiler;
+  return Profiler;
+}
+
+void PassProfiler::countAliasQuery() noexcept { ++NumAliasQueries; }
+
+void PassProfiler::enter(StringRef Category, StringRef Pass,
+                         StringRef Function, StringRef Module) {
+  RunningPasses.push_back({Category.str(), Pass.str(), Function.str(),
+                           Module.str(), Clock::now(),
+                           sys::Process::GetMallocUsage(), NumAliasQueries});
+}
+
+void PassProfiler::exit(StringRef Pass, StringRef Function) {
+  auto End{Clock::now()};
+  auto Heap{sys::Process::GetMallocUsage()};
+  // If a function pass requires a module pass, the manager splits a sequence
+  // of function passes. So, the start probe may be executed for all functions
+  // before the finish probe and passes may finish in an arbitrary order.
+  auto Itr{find_if(reverse(RunningPasses), [Pass, Function](auto &P) {
+    return P.Pass == Pass && P.Function == Function;
+  })};
+  if (Itr == RunningPasses.rend()) {
+    assert(false && "Pass has not been started!");
+    return;
+  }
+  auto &P{*Itr};
+  std::lock_guard<std::mutex> Lock(mMutex);
+  mPeakHeap = std::max(mPeakHeap, Heap);
+  mEvents.push_back({std::move(P.Category), std::move(P.Pass),
+                     std::move(P.Function), std::move(P.Module),
+                     get_threadid(), P.Start,
+                     End - P.Start,
+                     static_cast<int64_t>(Heap) - static_cast<int64_t>(P.Heap),
+                     mPeakHeap, NumAliasQueries - P.AliasQueries});
+  RunningPasses.erase(std::next(Itr).base());
+}
+
+void PassProfiler::write(raw_ostream &OS) const {
+  std::lock_guard<std::mutex> Lock(mMutex);
+  writeUnlocked(OS);
+}
+
+void PassProfiler::writeUnlocked(raw_ostream &OS) const {
+  using namespace std::chrono;
+  auto PID{sys::Process::getProcessId()};
+  json::OStream J(OS);
+  J.object([this, PID, &J] {
+    J.attributeArray("traceEvents", [this, PID, &J] {
+      for (auto &E : mEvents)
+        J.object([this, PID, &J, &E] {
+          J.attribute("name", E.Pass);
+          J.attribute("cat", E.Category);
+          J.attribute("ph", "X");
+          J.attribute("pid", static_cast<int64_t>(PID));
+          J.attribute("tid", static_cast<int64_t>(E.ThreadID));
+          J.attribute("ts",
+                      duration_cast<microseconds>(E.Start - mStart).count());
+          J.attribute("dur", duration_cast<microseconds>(E.Duration).count());
+          J.attributeObject("args", [&J, &E] {
+            if (!E.Function.empty())
+              J.attribute("function", E.Function);
+            J.attribute("module", E.Module);
+            J.attribute("heap-delta", E.HeapDelta);
+            J.attribute("peak-heap", static_cast<int64_t>(E.PeakHeap));
+            J.attribute("unresolved-alias-queries",
+                        static_cast<int64_t>(E.AliasQueries));
+          });
+        });
+    });
+    J.attribute("displayTimeUnit", "ms");
+  });
+}
+
+size_t PassProfiler::getPeakHeap() const {
+  std::lock_guard<std::mutex> Lock(mMutex);
+  return mPeakHeap;
+}
+
+void PassProfiler::clear() {
+  std::lock_guard<std::mutex> Lock(mMutex);
+  mEvents.clear();
+  mPeakHeap = 0;
+}
+
+Error PassProfiler::write(StringRef Path) const {
+  // The lock is held until the file is renamed, so a profile which has been
+  // collected earlier never overwrites a more complete one.
+  std::lock_guard<std::mutex> Lock(mMutex);
+  auto OF{OutputFile::create(Path, false)};
+  if (!OF)
+    return OF.takeError();
+  writeUnlocked(OF->getStream());
+  return OF->clear();
+}
+
+void ProfilingPassManager::add(Pass *P) {
+  // Pass name is copied because the pass may be deleted by the manager
+  // before the probe is executed if the pass is redundant.
+  auto Name{P->getPassName()};
+  auto addWithProbes = [this, P](Pass *Start, Pass *Finish) {
+    legacy::PassManager::add(Start);
+    legacy::PassManager::add(P);
+    legacy::PassManager::add(Finish);
+  };
+  switch (P->getPassKind()) {
+  case PT_Module:
+    addWithProbes(new ProfilerModuleProbe(Name, true),
+                  new ProfilerModuleProbe(Name, false));
+    break;
+  case PT_CallGraphSCC:
+    addWithProbes(new ProfilerCGSCCProbe(Name, true),
+                  new ProfilerCGSCCProbe(Name, false));
+    break;
+  case PT_Function:
+    addWithProbes(new ProfilerFunctionProbe(Name, true),
+                  new ProfilerFunctionProbe(Name, false));
+    break;
+  case PT_Region:
+    addWithProbes(new ProfilerRegionProbe(Name, true),
+                  new ProfilerRegionProbe(Name, false));
+    break;
+  case PT_Loop:
+    addWithProbes(new ProfilerLoopProbe(Name, true),
+                  new ProfilerLoopProbe(Name, false));
+    break;
+  default:
+    legacy::PassManager::add(P);
+    break;
+  }
+}
@@ -33,8 +33,11 @@
 # include "tsar/APC/Passes.h"
 # include "tsar/APC/Utils.h"
 #endif
+#include "tsar/Core/AnalysisCache.h"
+#include "tsar/Core/PassProfiler.h"
 #include "tsar/Core/Query.h"
 #include "tsar/Core/TransformationContext.h"
+#include "tsar/Frontend/Clang/TransformationContext.h"
 #include "tsar/Support/GlobalOptions.h"
 #include "tsar/Support/OutputFile.h"
 #include "tsar/Support/PassBarrier.h"
@@ -43,6 +46,7 @@
 #include "tsar/Transform/Mixed/Passes.h"
 #include "tsar/Support/Clang/Utils.h"
 #include <clang/Frontend/CompilerInstance.h>
+#include <llvm/ADT/SmallPtrSet.h>
 #include <llvm/Analysis/BasicAliasAnalysis.h>
 #include <llvm/Analysis/CFLAndersAliasAnalysis.h>
 #include <llvm/Analysis/CFLSteensAliasAnalysis.h>
@@ -53,6 +57,8 @@
 #include <llvm/Analysis/TypeBasedAliasAnalysis.h>
 #include <llvm/CodeGen/Passes.h>
 #include <llvm/IR/DebugInfo.h>
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/IR/DiagnosticInfo.h>
 #include <llvm/IR/IRPrintingPasses.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/Verifier.h>
@@ -190,6 +196,14 @@ void addAfterSROAAnalysis(const GlobalOptions &GO, const DataLayout &DL,
   Passes.add(createGlobalDefinedMemoryPass());
   Passes.add(createGlobalLiveMemoryPass());
   Passes.add(createFunctionMemoryAttrsAnalysis());
+  // Note, that functions are processed sequentially after the barrier, even
+  // though interprocedural summaries have been already built. Function passes
+  // in the pipeline are not read-only with respect to the module: they create
+  // metadata and constants (for example, DIEstimateMemoryPass and
+  // ScalarEvolution do it) which are uniqued in a single LLVMContext, and the
+  // legacy pass manager updates its own state when a pass is executed.
+  // So, to process functions concurrently each job needs its own context and
+  // DIMemoryTraitPool entries would have to be remapped back to the module.
   Passes.add(createPassBarrier());
   Passes.add(createDIDependencyAnalysisPass());
 }
@@ -238,18 +252,131 @@ void DefaultQueryManager::addWithPrint(llvm::Pass *P, bool PrintResult,
   if (PrintResult) {
     auto PI = PassRegistry::getPassRegistry()->getPassInfo(P->getPassID());
     Passes.add(P);
-    Passes.add(createFunctionPassPrinter(PI, errs()));
+    Passes.add(createFunctionPassPrinter(PI, mPrintOS ? *mPrintOS : errs()));
     return;
   }
   Passes.add(P);
 };
 
+/// Write a profile of executed passes if it has been requested.
+static void writePassProfile(const GlobalOptions &GO) {
+  if (GO.PassProfile.empty())
+    return;
+  if (auto E{PassProfiler::get().write(GO.PassProfile)})
+    errs() << "warning: unable to write pass profile to " << GO.PassProfile
+           << ": " << toString(std::move(E)) << "\n";
+}
+
+namespace {
+/// Forwards LLVM diagnostics to a previously installed handler and counts
+/// errors and warnings.
+class CountingDiagnosticHandler final : public DiagnosticHandler {
+public:
+  explicit CountingDiagnosticHandler(std::unique_ptr<DiagnosticHandler> Prev)
+      : DiagnosticHandler(Prev->DiagnosticContext), mPrev(std::move(Prev)) {
+    DiagHandlerCallback = mPrev->DiagHandlerCallback;
+  }
+
+  bool handleDiagnostics(const DiagnosticInfo &DI) override {
+    if (DI.getSeverity() == DS_Error || DI.getSeverity() == DS_Warning)
+      ++mNumDiags;
+    return mPrev->handleDiagnostics(DI);
+  }
+
+  bool isAnalysisRemarkEnabled(StringRef PassName) const override {
+    return mPrev->isAnalysisRemarkEnabled(PassName);
+  }
+  bool isMissedOptRemarkEnabled(StringRef PassName) const override {
+    return mPrev->isMissedOptRemarkEnabled(PassName);
+  }
+  bool isPassedOptRemarkEnabled(StringRef PassName) const override {
+    return mPrev->isPassedOptRemarkEnabled(PassName);
+  }
+  bool isAnyRemarkEnabled() const override {
+    return mPrev->isAnyRemarkEnabled();
+  }
+
+  /// Return number of errors and warnings which have been emitted.
+  unsigned getNumDiagnostics() const noexcept { return mNumDiags; }
+
+  /// Return ownership of the previously installed handler.
+  std::unique_ptr<DiagnosticHandler> takePrevious() { return std::move(mPrev); }
+
+private:
+  std::unique_ptr<DiagnosticHandler> mPrev;
+  unsigned mNumDiags = 0;
+};
+}
+
+/// Collect consumers of Clang diagnostics which may be emitted while
+/// a module is analyzed.
+///
+/// \return False if some diagnostics can not be tracked.
+static bool collectDiagConsumers(clang::DiagnosticsEngine *Diags,
+    TransformationInfo *TfmInfo,
+    SmallPtrSetImpl<clang::DiagnosticConsumer *> &Consumers) {
+  if (Diags && Diags->getClient())
+    Consumers.insert(Diags->getClient());
+  if (!TfmInfo)
+    return true;
+  for (auto [CU, TfmCtxBase] : TfmInfo->contexts()) {
+    auto *ClangCtx{dyn_cast_or_null<ClangTransformationContext>(TfmCtxBase)};
+    if (!ClangCtx)
+      return false;
+    if (ClangCtx->hasInstance() && ClangCtx->getContext().getDiagnostics()
+                                       .getClient())
+      Consumers.insert(ClangCtx->getContext().getDiagnostics().getClient());
+  }
+  return true;
+}
+
+/// Return number of errors and warnings which have been reported to specified
+/// consumers.
+static unsigned getNumDiagnostics(
+    const SmallPtrSetImpl<clang::DiagnosticConsumer *> &Consumers) {
+  unsigned NumDiags{0};
+  for (auto *C : Consumers)
+    NumDiags += C->getNumErrors() + C->getNumWarnings();
+  return NumDiags;
+}
+
 void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
   assert(M && "Module must not be null!");
-  auto &PrintOS{errs()};
+  auto &OS{mPrintOS ? *mPrintOS : errs()};
+  // Printed results are collected in a buffer if cache is enabled. So, they
+  // can be stored in the cache after analysis.
+  Optional<AnalysisCache> Cache;
+  std::string CacheKey, CachedResults;
+  raw_string_ostream CacheOS(CachedResults);
+  // Remarks and a pass profile are produced while passes are executed, so
+  // they would be lost if cached results are used.
+  bool HasSideOutput{mHasRemarks || !mGlobalOptions->PassProfile.empty() ||
+                     M->getContext().getLLVMRemarkStreamer() ||
+                     M->getContext().getDiagHandlerPtr()->isAnyRemarkEnabled()};
+  // Diagnostics are also produced while passes are executed, so results are
+  // not stored in the cache if some errors or warnings have been emitted.
+  SmallPtrSet<clang::DiagnosticConsumer *, 4> DiagConsumers;
+  HasSideOutput |= !collectDiagConsumers(mDiags, TfmInfo, DiagConsumers);
+  if (!mUseServer && mOutputPasses.empty() && !HasSideOutput &&
+      mGlobalOptions->SummaryEmit.empty() &&
+      !mGlobalOptions->AnalysisCache.empty()) {
+    Cache.emplace(mGlobalOptions->AnalysisCache);
+    CacheKey = AnalysisCache::computeKey(*M, *mGlobalOptions, mPrintPasses,
+                                         mPrintSteps);
+    if (auto Results{Cache->load(CacheKey)}) {
+      OS << *Results;
+      return;
+    }
+  }
+  auto &PrintOS{Cache ? CacheOS : OS};
   if (!mPrintPasses.empty() && mGlobalOptions->PrintToolVersion)
     printToolVersion(PrintOS);
-  legacy::PassManager Passes;
+  std::unique_ptr<legacy::PassManager> PM;
+  if (mGlobalOptions->PassProfile.empty())
+    PM = std::make_unique<legacy::PassManager>();
+  else
+    PM = std::make_unique<ProfilingPassManager>();
+  auto &Passes{*PM};
   Passes.add(createGlobalOptionsImmutableWrapper(mGlobalOptions));
   if (TfmInfo) {
     auto TEP = static_cast<TransformationEnginePass *>(
@@ -259,13 +386,18 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
     Passes.add(createImmutableASTImportInfoPass(mImportInfo));
   }
   addImmutableAliasAnalysis(Passes);
+  // Summaries of external functions must be attached to declarations before
+  // deduction of function attributes, so the attributes will be propagated
+  // to callers.
+  if (!mGlobalOptions->SummaryUse.empty())
+    Passes.add(createFunctionSummaryReader());
   addInitialTransformations(Passes);
   auto addPrint = [&Passes, this, &PrintOS](ProcessingStep CurrentStep) {
     if (!(CurrentStep & mPrintSteps))
       return;
     for (auto PI : mPrintPasses) {
       if (!PI->getNormalCtor()) {
-        errs() << "warning: cannot create pass: " << PI->getPassName() << "\n";
+        PrintOS << "warning: cannot create pass: " << PI->getPassName() << "\n";
         continue;
       }
       if (auto *GI = PrintPassGroup::getPassRegistry().groupInfo(*PI))
@@ -330,6 +462,7 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
     Passes.add(createAnalysisCloseConnectionPass());
     Passes.add(createVerifierPass());
     Passes.run(*M);
+    writePassProfile(*mGlobalOptions);
     return;
   }
   Passes.add(createMemoryMatcherPass());
@@ -339,6 +472,26 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
   // avoid dangling handles. So, we add pool before environment in the manager.
   Passes.add(createDIMemoryTraitPoolStorage());
   Passes.add(createDIMemoryEnvironmentStorage());
+  if (!mGlobalOptions->SummaryEmit.empty()) {
+    // Summaries contain results of interprocedural analysis only, so
+    // dependence analysis is not performed.
+    Passes.add(createGlobalsAccessCollector());
+    Passes.add(createCallExtractorPass());
+    Passes.add(createGlobalDefinedMemoryPass());
+    Passes.add(createFunctionMemoryAttrsAnalysis());
+    // Mark arguments which are not captured, the writer exports 'nocapture'
+    // attributes.
+    Passes.add(createNoCaptureAnalysisPass());
+    Passes.add(createFunctionSummaryWriter());
+    Passes.add(createVerifierPass());
+    Passes.run(*M);
+    writePassProfile(*mGlobalOptions);
+    return;
+  }
+  if (mGlobalOptions->HotLoopsOnly) {
+    Passes.add(createColdLoopsStorage());
+    Passes.add(createColdLoopsCollector());
+  }
   addBeforeTfmAnalysis(Passes);
   addPrint(BeforeTfmAnalysis);
   addOutput(BeforeTfmAnalysis);
@@ -360,7 +513,38 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
   addPrint(AfterLoopRotateAnalysis);
   addOutput(AfterLoopRotateAnalysis);
   Passes.add(createVerifierPass());
+  CountingDiagnosticHandler *LLVMDiags{nullptr};
+  unsigned NumClangDiags{0};
+  if (Cache) {
+    auto Handler{std::make_unique<CountingDiagnosticHandler>(
+        M->getContext().getDiagnosticHandler())};
+    LLVMDiags = Handler.get();
+    M->getContext().setDiagnosticHandler(std::move(Handler));
+    NumClangDiags = getNumDiagnostics(DiagConsumers);
+  }
   Passes.run(*M);
+  writePassProfile(*mGlobalOptions);
+  if (Cache) {
+    bool HasDiags{LLVMDiags->getNumDiagnostics() > 0 ||
+                  getNumDiagnostics(DiagConsumers) != NumClangDiags};
+    M->getContext().setDiagnosticHandler(LLVMDiags->takePrevious());
+    OS << CacheOS.str();
+    if (HasDiags)
+      return;
+    if (auto E{Cache->store(CacheKey, CacheOS.str())})
+      errs() << "warning: unable to store analysis results in "
+             << Cache->getDirectory() << ": " << toString(std::move(E))
+             << "\n";
+  }
+}
+
+bool DefaultQueryManager::beginSourceFile(clang::DiagnosticsEngine &Diags,
+                                          StringRef InputFile,
+                                          StringRef OutputFile,
+                                          StringRef WorkingDir) {
+  mHasRemarks = !Diags.getDiagnosticOptions().Remarks.empty();
+  mDiags = &Diags;
+  return true;
 }
 
 bool EmitLLVMQueryManager::beginSourceFile(clang::DiagnosticsEngine &Diags,
@@ -25,15 +25,20 @@
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Core/IRAction.h"
+#include "tsar/Core/PassProfiler.h"
 #include "tsar/Core/Query.h"
 #include "tsar/Core/Passes.h"
 #include "tsar/Core/Tool.h"
 #include "tsar/Core/tsar-config.h"
 #include "tsar/Frontend/Clang/Action.h"
+#include "tsar/Frontend/Clang/ASTManifest.h"
 #include "tsar/Frontend/Clang/ASTMergeAction.h"
 #include "tsar/Frontend/Clang/Pragma.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "tsar/Support/OutputFile.h"
+#include <clang/Frontend/CompilerInvocation.h>
 #include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
 #include <clang/Tooling/CommonOptionsParser.h>
 #include <clang/Tooling/Tooling.h>
 #ifdef FLANG_FOUND
@@ -41,11 +46,17 @@
 # include "tsar/Frontend/Flang/Tooling.h"
 # include <flang/Frontend/FrontendOptions.h>
 #endif
+#include <llvm/ADT/Statistic.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/IR/LegacyPassNameParser.h>
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/JSON.h>
 #include <llvm/Support/Path.h>
 #include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/ThreadPool.h>
 #include <llvm/Support/CommandLine.h>
+#include <chrono>
+#include <iostream>
 
 using namespace clang;
 using namespace clang::tooling;
@@ -128,12 +139,15 @@ struct Options : private bcl::Uncopyable {
   llvm::cl::list<std::string> EnableWarnings;
   llvm::cl::opt<std::string> BuildPath;
   llvm::cl::alias BuildPathA;
+  llvm::cl::opt<unsigned> NumThreads;
+  llvm::cl::opt<bool> Batch;
 
   llvm::cl::OptionCategory DebugCategory;
   llvm::cl::opt<bool> EmitLLVM;
   llvm::cl::opt<bool> PrintAST;
   llvm::cl::opt<bool> DumpAST;
   llvm::cl::opt<bool> TimeReport;
+  llvm::cl::opt<std::string> PassProfile;
   llvm::cl::opt<bool> UseServer;
 
   llvm::cl::opt<bool> PrintAll;
@@ -171,9 +185,17 @@ struct Options : private bcl::Uncopyable {
   llvm::cl::opt<std::string> ProfileUse;
   llvm::cl::list<std::string> ObjectFilenames;
   llvm::cl::opt<unsigned> LoopParallelThreshold;
+  llvm::cl::opt<bool> HotLoopsOnly;
+  llvm::cl::opt<bool> WorklistDataFlow;
+  llvm::cl::opt<bool> Delinearize;
+  llvm::cl::opt<unsigned> ExactDependenceBudget;
   llvm::cl::opt<unsigned> UnknownFunctionWeight;
   llvm::cl::opt<unsigned> UnknownBuiltinWeight;
   llvm::cl::list<std::string> OptRegion;
+  llvm::cl::opt<std::string> AnalysisCache;
+  llvm::cl::opt<bool> IncrementalAnalysis;
+  llvm::cl::opt<std::string> SummaryEmit;
+  llvm::cl::opt<std::string> SummaryUse;
 
   llvm::cl::OptionCategory TransformCategory;
   llvm::cl::opt<bool> NoFormat;
@@ -189,7 +211,7 @@ private:
 
 Options::Options() :
   Sources(cl::Positional, cl::desc("<source0> [... <sourceN>]"),
-    cl::OneOrMore),
+    cl::ZeroOrMore),
   TfmPass(cl::desc("Transformations available (one at a time):")),
   OutputPasses(cl::desc("Analysis available:")),
   CompileCategory("Compilation options"),
@@ -231,6 +253,13 @@ Options::Options() :
   BuildPath("build-path", cl::desc("Starting point to look up for compilation database in upward direction"),
     cl::cat(CompileCategory)),
   BuildPathA("p", cl::aliasopt(BuildPath), cl::desc("Alias for -build-path")),
+  NumThreads("j", cl::cat(CompileCategory), cl::value_desc("N"), cl::init(1),
+    cl::desc("Process up to N translation units concurrently "
+             "(0 - use all available cores)"), cl::Prefix),
+  Batch("batch", cl::cat(CompileCategory),
+    cl::desc("Read jobs from the standard input (one JSON object per line: "
+             "\"args\" - list of arguments, \"output\" - file to print "
+             "results) and report latency of each job")),
   DebugCategory("Debugging options"),
   EmitLLVM("emit-llvm", cl::cat(DebugCategory),
     cl::desc("Emit llvm without analysis")),
@@ -240,6 +269,8 @@ Options::Options() :
     cl::desc("Build ASTs and then debug dump them")),
   TimeReport("ftime-report", cl::cat(DebugCategory),
     cl::desc("Print some statistics about the time consumed by each pass when it finishes")),
+  PassProfile("pass-profile", cl::cat(DebugCategory), cl::value_desc("filename"),
+    cl::desc("Write wall time, heap usage and number of alias queries for each pass and each function to a specified file in Chrome trace format")),
   UseServer("use-analysis-server", cl::cat(DebugCategory),
     cl::desc("Run default workflow on analysis server")),
   PrintAll("print-all", cl::cat(DebugCategory),
@@ -332,9 +363,41 @@ Options::Options() :
     cl::Hidden, cl::cat(AnalysisCategory),
     cl::desc("If profile is available, this value specify the lowest "
              "weight of loops will be parallelized.")),
+  HotLoopsOnly("fhot-loops-only", cl::cat(AnalysisCategory),
+    cl::desc("Do not perform expensive dependence tests for loops which "
+             "weight is less than -parallel-loop-min-weight "
+             "(a profile must be specified)")),
+  WorklistDataFlow("fworklist-data-flow", cl::cat(AnalysisCategory),
+    cl::desc("Reevaluate transfer functions only for nodes which inputs "
+             "have been changed when data-flow problems are solved")),
+  Delinearize("delinearize-da", cl::init(true), cl::Hidden,
+    cl::cat(AnalysisCategory),
+    cl::desc("Try to delinearize array references")),
+  ExactDependenceBudget("da-exact-budget", cl::init(512), cl::Hidden,
+    cl::cat(AnalysisCategory),
+    cl::desc("Maximum number of steps of the exact integer dependence test "
+             "for a pair of instructions (0 disables the test)")),
   OptRegion("foptimize-only", cl::cat(AnalysisCategory), cl::value_desc("regions"),
     cl::ZeroOrMore, cl::ValueRequired, cl::CommaSeparated,
     cl::desc("Allow optimization of specified regions (comma separated list of region names")),
+  AnalysisCache("analysis-cache", cl::cat(AnalysisCategory),
+    cl::value_desc("directory"),
+    cl::desc("Store text printed by -print-* analysis passes for a whole "
+             "source in a specified directory and replay it if the source "
+             "and options have not been changed (output passes and the "
+             "analysis server bypass the cache)")),
+  IncrementalAnalysis("fincremental-analysis", cl::cat(AnalysisCategory),
+    cl::desc("Reanalyze only changed functions and functions which depend "
+             "on them at each step of interprocedural analysis (results are "
+             "reused between steps of a single run, not between runs)")),
+  SummaryEmit("fsummary-emit", cl::cat(AnalysisCategory),
+    cl::value_desc("directory"),
+    cl::desc("Write summaries of functions to a specified directory "
+             "without dependence analysis")),
+  SummaryUse("fsummary-use", cl::cat(AnalysisCategory),
+    cl::value_desc("directory"),
+    cl::desc("Use summaries of functions from a specified directory to "
+             "analyze calls of functions defined in other sources")),
   TransformCategory("Transformation options"),
   NoFormat("no-format", cl::cat(TransformCategory),
     cl::desc("Disable format of transformed sources")),
@@ -411,47 +474,15 @@ Tool::Tool(int Argc, const char **Argv) {
   mToolName = Argv[0];
   auto Args = addInternalArgs(Argc, Argv);
   cl::ParseCommandLineOptions(Args.size(), Args.data(), Descr);
-  storeCLOptions();
+  if (!storeCLOptions(errs()))
+    exit(1);
   InitializeAllTargetInfos();
   InitializeAllTargetMCs();
   InitializeAllAsmParsers();
   cl::PrintOptionValues();
 }
 
-inline static QueryManager * getDefaultQM(bool UseServer,
-    const DefaultQueryManager::PassList &OutputPasses,
-    const DefaultQueryManager::PassList &PrintPasses,
-    const DefaultQueryManager::ProcessingStep PrintSteps,
-    const GlobalOptions &GlobalOpts) {
-  static DefaultQueryManager QM(UseServer, &GlobalOpts,
-    OutputPasses, PrintPasses, PrintSteps);
-  return &QM;
-}
-
-inline static EmitLLVMQueryManager * getEmitLLVMQM() {
-  static EmitLLVMQueryManager QM;
-  return &QM;
-}
-
-inline static InstrLLVMQueryManager * getInstrLLVMQM(
-    const GlobalOptions &GlobalOpts, StringRef InstrEntry,
-    ArrayRef<std::string> InstrStart) {
-  static InstrLLVMQueryManager QM(&GlobalOpts, InstrEntry, InstrStart);
-  return &QM;
-}
-
-inline static TransformationQueryManager * getTransformationQM(
-    const llvm::PassInfo *TfmPass, const GlobalOptions &GlobalOpts) {
-  static TransformationQueryManager QM(TfmPass, &GlobalOpts);
-  return &QM;
-}
-
-inline static CheckQueryManager * getCheckQM() {
-  static CheckQueryManager QM;
-  return &QM;
-}
-
-void Tool::storePrintOptions(OptionList &IncompatibleOpts) {
+bool Tool::storePrintOptions(OptionList &IncompatibleOpts, raw_ostream &Errs) {
   mPrint = false;
   mPrintPasses = Options::get().PrintOnly;
   if (!mPrintPasses.empty()) {
@@ -481,16 +512,28 @@ void Tool::storePrintOptions(OptionList &IncompatibleOpts) {
       if (Step > DefaultQueryManager::numberOfSteps()) {
         Options::get().PrintStep.error(
           "error - exceeded the number of available steps (maximum number is " +
-          Twine((unsigned)DefaultQueryManager::numberOfSteps()) + ")");
-        exit(1);
+          Twine((unsigned)DefaultQueryManager::numberOfSteps()) + ")", Errs);
+        return false;
       }
       mPrintSteps |= 1u << (Step - 1);
     }
   }
+  return true;
 }
 
-void Tool::storeCLOptions() {
+bool Tool::storeCLOptions(raw_ostream &Errs) {
   mSources = Options::get().Sources;
+  mBatch = Options::get().Batch;
+  if (mBatch && !mSources.empty()) {
+    Options::get().Batch.error(
+        "error - sources should be specified in jobs in a batch mode", Errs);
+    return false;
+  }
+  if (!mBatch && mSources.empty()) {
+    Options::get().Sources.error("error - at least one source is required",
+                                 Errs);
+    return false;
+  }
   mCommandLine.emplace_back("-O1");
   mCommandLine.emplace_back("-Xclang");
   mCommandLine.emplace_back("-disable-llvm-passes");
@@ -527,8 +570,8 @@ void Tool::storeCLOptions() {
   if (Options::get().MathErrno && Options::get().NoMathErrno) {
     std::string Msg("error - this option is incompatible with");
     Msg.append(" -").append(Options::get().NoMathErrno.ArgStr.data());
-    Options::get().MathErrno.error(Msg);
-    exit(1);
+    Options::get().MathErrno.error(Msg, Errs);
+    return false;
   }
   if (Options::get().MathErrno)
     mCommandLine.emplace_back("-fmath-errno");
@@ -536,9 +579,10 @@ void Tool::storeCLOptions() {
     mCommandLine.emplace_back("-fno-math-errno");
   if (!Options::get().BuildPath.empty()) {
     std::string ErrorMessage;
-    mCompilations =
-        CompilationDatabase::autoDetectFromDirectory(
-          Options::get().BuildPath, ErrorMessage);
+    // A database is loaded for each job in a batch mode, because it may be
+    // regenerated between jobs.
+    mCompilations = CompilationDatabase::autoDetectFromDirectory(
+        Options::get().BuildPath, ErrorMessage);
     if (!mCompilations && !ErrorMessage.empty()) {
       ErrorMessage.append("\n");
       llvm::errs() << "Error while trying to load a compilation database:\n"
@@ -585,22 +629,22 @@ void Tool::storeCLOptions() {
   if (Options::get().SafeTypeCast && Options::get().NoSafeTypeCast) {
     std::string Msg("error - this option is incompatible with");
     Msg.append(" -").append(Options::get().NoSafeTypeCast.ArgStr.data());
-    Options::get().SafeTypeCast.error(Msg);
-    exit(1);
+    Options::get().SafeTypeCast.error(Msg, Errs);
+    return false;
   }
   mGlobalOpts.InBoundsSubscripts = Options::get().InBoundsSubscripts;
   if (Options::get().InBoundsSubscripts && Options::get().NoInBoundsSubscripts) {
     std::string Msg("error - this option is incompatible with");
     Msg.append(" -").append(Options::get().NoInBoundsSubscripts.ArgStr.data());
-    Options::get().InBoundsSubscripts.error(Msg);
-    exit(1);
+    Options::get().InBoundsSubscripts.error(Msg, Errs);
+    return false;
   }
   mGlobalOpts.AnalyzeLibFunc = Options::get().AnalyzeLibFunc;
   if (Options::get().AnalyzeLibFunc && Options::get().NoAnalyzeLibFunc) {
     std::string Msg("error - this option is incompatible with");
     Msg.append(" -").append(Options::get().NoAnalyzeLibFunc.ArgStr.data());
-    Options::get().AnalyzeLibFunc.error(Msg);
-    exit(1);
+    Options::get().AnalyzeLibFunc.error(Msg, Errs);
+    return false;
   }
   mGlobalOpts.IgnoreRedundantMemory = Options::get().IgnoreRedundantMemory;
   mGlobalOpts.UnsafeTfmAnalysis = Options::get().UnsafeTfmAnalysis;
@@ -608,32 +652,46 @@ void Tool::storeCLOptions() {
       Options::get().NoUnsafeTfmAnalysis) {
     std::string Msg("error - this option is incompatible with");
     Msg.append(" -").append(Options::get().NoUnsafeTfmAnalysis.ArgStr.data());
-    Options::get().UnsafeTfmAnalysis.error(Msg);
-    exit(1);
+    Options::get().UnsafeTfmAnalysis.error(Msg, Errs);
+    return false;
   }
   mGlobalOpts.NoExternalCalls = Options::get().NoExternalCalls;
   if (Options::get().ExternalCalls && Options::get().NoExternalCalls) {
     std::string Msg("error - this option is incompatible with");
     Msg.append(" -").append(Options::get().NoExternalCalls.ArgStr.data());
-    Options::get().ExternalCalls.error(Msg);
-    exit(1);
+    Options::get().ExternalCalls.error(Msg, Errs);
+    return false;
   }
   mGlobalOpts.NoInline = Options::get().NoInline;
   if (Options::get().Inline && Options::get().NoInline) {
     std::string Msg("error - this option is incompatible with");
     Msg.append(" -").append(Options::get().NoInline.ArgStr.data());
-    Options::get().Inline.error(Msg);
-    exit(1);
+    Options::get().Inline.error(Msg, Errs);
+    return false;
   }
   mGlobalOpts.MemoryAccessInlineThreshold =
       Options::get().MemoryAccessInlineThreshold;
   mGlobalOpts.LoopParallelThreshold = Options::get().LoopParallelThreshold;
+  mGlobalOpts.HotLoopsOnly =
+      Options::get().HotLoopsOnly && !Options::get().ProfileUse.empty();
+  if (Options::get().HotLoopsOnly && Options::get().ProfileUse.empty())
+    errs() << "WARNING: The -fhot-loops-only option is ignored when "
+              "-fprofile-use is not set.\n";
+  mGlobalOpts.WorklistDataFlow = Options::get().WorklistDataFlow;
+  mGlobalOpts.Delinearize = Options::get().Delinearize;
+  mGlobalOpts.ExactDependenceBudget = Options::get().ExactDependenceBudget;
   mGlobalOpts.UnknownFunctionWeight = Options::get().UnknownFunctionWeight;
   mGlobalOpts.UnknownFunctionWeight = Options::get().UnknownBuiltinWeight;
   mGlobalOpts.OptRegions = Options::get().OptRegion;
+  mGlobalOpts.AnalysisCache = Options::get().AnalysisCache;
+  mGlobalOpts.IncrementalAnalysis = Options::get().IncrementalAnalysis;
+  mGlobalOpts.SummaryEmit = Options::get().SummaryEmit;
+  mGlobalOpts.SummaryUse = Options::get().SummaryUse;
   mGlobalOpts.AnalysisUse = Options::get().AnalysisUse;
   mGlobalOpts.ProfileUse = Options::get().ProfileUse;
   mGlobalOpts.ObjectFilenames = Options::get().ObjectFilenames;
+  mGlobalOpts.NumThreads = Options::get().NumThreads;
+  mGlobalOpts.PassProfile = Options::get().PassProfile;
   mEmitAST = addLLIfSet(addIfSet(Options::get().EmitAST));
   mMergeAST = mEmitAST ?
     addLLIfSet(addIfSet(Options::get().MergeAST)) :
@@ -653,11 +711,12 @@ void Tool::storeCLOptions() {
   if (Options::get().LoadSources && Options::get().NoLoadSources) {
     std::string Msg("error - this option is incompatible with");
     Msg.append(" -").append(Options::get().NoLoadSources.ArgStr.data());
-    Options::get().LoadSources.error(Msg);
-    exit(1);
+    Options::get().LoadSources.error(Msg, Errs);
+    return false;
   }
   mOutputFilename = Options::get().Output;
-  storePrintOptions(IncompatibleOpts);
+  if (!storePrintOptions(IncompatibleOpts, Errs))
+    return false;
   mLanguage = Options::get().Language;
   /// TODO (kaniandr@gmail.com): allow to use -output-suffix option for
   /// instrumentation and emit LLVM passes.
@@ -667,8 +726,8 @@ void Tool::storeCLOptions() {
   if (!Options::get().PrintStep.empty() && mServer) {
     std::string Msg("error - this option is incompatible with");
     Msg.append(" -").append(Options::get().PrintStep.ArgStr.data());
-    Options::get().UseServer.error(Msg);
-    exit(1);
+    Options::get().UseServer.error(Msg, Errs);
+    return false;
   }
   mGlobalOpts.NoFormat = addIfSetIf(Options::get().NoFormat, NoTfmPass);
   mGlobalOpts.OutputSuffix = Options::get().OutputSuffix;
@@ -680,8 +739,8 @@ void Tool::storeCLOptions() {
     std::string Msg("error - this option is incompatible with");
     for (unsigned I = 1; I < IncompatibleOpts.size(); ++I)
       Msg.append(" -").append(IncompatibleOpts[1]->ArgStr.data());
-    IncompatibleOpts[0]->error(Msg);
-    exit(1);
+    IncompatibleOpts[0]->error(Msg, Errs);
+    return false;
   }
   // Now, we check that there are no options which are incompatible with .ll
   // source file (if such file exists in the command line).
@@ -693,13 +752,167 @@ void Tool::storeCLOptions() {
     if (LLSrcItr != mSources.end()) {
       std::string Msg();
       LLIncompatibleOpts[0]->error(
-        Twine("error - this option is incompatible with ") + *LLSrcItr);
-      exit(1);
+        Twine("error - this option is incompatible with ") + *LLSrcItr, Errs);
+      return false;
     }
   }
+  return true;
+}
+
+/// Process each of specified sources with a separate tool, sources are
+/// processed concurrently.
+///
+/// Diagnostics and other output of each job are collected separately and
+/// are printed to specified streams in the order of sources when all jobs
+/// have been finished.
+/// \param [in] Run This function runs a specified tool which is
+/// configured to process I-th source and to emit diagnostics, it should print
+/// results to a specified stream.
+/// \return Zero on success, 1 if some errors occurred and 2 if some sources
+/// have been skipped (the same as ClangTool::run() returns).
+static int runConcurrently(unsigned NumThreads,
+    const CompilationDatabase &Compilations, ArrayRef<std::string> Sources,
+    ArrayRef<std::string> CommandLine, raw_ostream &DiagOS,
+    raw_ostream &ResultOS,
+    function_ref<int(ClangTool &, raw_ostream &, std::size_t)> Run) {
+  SmallVector<const char *, 16> Args;
+  for (auto &Arg : CommandLine)
+    Args.push_back(Arg.c_str());
+  auto DiagOpts{CreateAndPopulateDiagOpts(Args)};
+  std::vector<std::string> Logs(Sources.size());
+  std::vector<std::string> Outputs(Sources.size());
+  std::vector<int> Results(Sources.size(), 0);
+  ThreadPool Pool(hardware_concurrency(NumThreads));
+  for (std::size_t I = 0, EI = Sources.size(); I < EI; ++I)
+    Pool.async([&, I]() {
+      raw_string_ostream LogOS(Logs[I]);
+      raw_string_ostream OS(Outputs[I]);
+      TextDiagnosticPrinter Diags(LogOS, DiagOpts.get());
+      ClangTool CTool(Compilations, Sources[I]);
+      CTool.setDiagnosticConsumer(&Diags);
+      Results[I] = Run(CTool, OS, I);
+      LogOS.flush();
+      OS.flush();
+    });
+  Pool.wait();
+  // If both streams are the same, diagnostics and results of each source are
+  // printed together as if sources are processed sequentially.
+  for (std::size_t I = 0, EI = Sources.size(); I < EI; ++I) {
+    DiagOS << Logs[I];
+    ResultOS << Outputs[I];
+  }
+  bool ProcessingFailed{false}, FileSkipped{false};
+  for (auto Res : Results) {
+    ProcessingFailed |= Res == 1;
+    FileSkipped |= Res == 2;
+  }
+  return ProcessingFailed ? 1 : FileSkipped ? 2 : 0;
+}
+
+int Tool::runBatch() {
+  // Parse and execute a job, return status of the job and store description
+  // of an error if the job can not be executed.
+  auto runJob = [this](StringRef Line, llvm::json::Value &ID,
+                       std::string &Error) {
+    auto Job{llvm::json::parse(Line)};
+    if (!Job) {
+      Error = toString(Job.takeError());
+      return 1;
+    }
+    auto *Obj{Job->getAsObject()};
+    if (!Obj) {
+      Error = "job must be an object";
+      return 1;
+    }
+    if (auto *V{Obj->get("id")})
+      ID = *V;
+    auto *Args{Obj->getArray("args")};
+    if (!Args) {
+      Error = "list of arguments is not specified";
+      return 1;
+    }
+    std::vector<std::string> ArgStorage{mToolName};
+    for (auto &Arg : *Args) {
+      auto Str{Arg.getAsString()};
+      if (!Str) {
+        Error = "argument must be a string";
+        return 1;
+      }
+      ArgStorage.push_back(Str->str());
+    }
+    std::vector<const char *> Argv;
+    for (auto &Arg : ArgStorage)
+      Argv.push_back(Arg.c_str());
+    Optional<OutputFile> OF;
+    if (auto Output{Obj->getString("output")}) {
+      auto FileOrErr{OutputFile::create(*Output, false)};
+      if (!FileOrErr) {
+        Error = toString(FileOrErr.takeError());
+        return 1;
+      }
+      OF.emplace(std::move(*FileOrErr));
+    }
+    // Options which have been specified in the previous job are reset, so
+    // each job starts with default values of options.
+    cl::ResetAllOptionOccurrences();
+    auto InternalArgs{addInternalArgs(Argv.size(), Argv.data())};
+    raw_string_ostream ErrorOS(Error);
+    if (!cl::ParseCommandLineOptions(InternalArgs.size(), InternalArgs.data(),
+                                     "", &ErrorOS))
+      return 1;
+    if (Options::get().Batch) {
+      Error = "nested batch mode is not supported";
+      return 1;
+    }
+    Tool JobTool;
+    JobTool.mToolName = mToolName;
+    if (!JobTool.storeCLOptions(ErrorOS))
+      return 1;
+    if (OF)
+      JobTool.mOutput = &OF->getStream();
+    // Statistics and the profile describe the current job only.
+    ResetStatistics();
+    PassProfiler::get().clear();
+    auto Res{JobTool.run()};
+    if (AreStatisticsEnabled())
+      PrintStatistics();
+    ResetStatistics();
+    if (OF)
+      if (auto E{OF->clear()}) {
+        Error = toString(std::move(E));
+        return 1;
+      }
+    return Res;
+  };
+  bool HasFailedJobs{false};
+  std::string Line;
+  while (std::getline(std::cin, Line)) {
+    if (StringRef(Line).trim().empty())
+      continue;
+    auto Start{std::chrono::steady_clock::now()};
+    llvm::json::Value ID{nullptr};
+    std::string Error;
+    auto Res{runJob(Line, ID, Error)};
+    std::chrono::duration<double, std::milli> Latency{
+        std::chrono::steady_clock::now() - Start};
+    HasFailedJobs |= Res != 0;
+    llvm::json::OStream J(outs());
+    J.object([&]() {
+      J.attribute("id", ID);
+      J.attribute("status", Res);
+      J.attribute("latency-ms", Latency.count());
+      if (!Error.empty())
+        J.attribute("error", Error);
+    });
+    outs() << "\n";
+    outs().flush();
+  }
+  return HasFailedJobs ? 1 : 0;
 }
 
 int Tool::run(QueryManager *QM) {
+  if (mBatch)
+    return runBatch();
   std::vector<std::string> NoASTCSources;
   std::vector<std::string> CSourcesToMerge;
   std::vector<std::string> LLSources;
@@ -742,11 +955,8 @@ int Tool::run(QueryManager *QM) {
         errs() << "Skipping " << Src << ". Language is not recognized.\n";
     }
   }
-  // Evaluation of Clang AST files by this tool leads an error,
-  // so these sources should be excluded.
-  ClangTool EmitPCHTool(*mCompilations, NoASTCSources);
-  auto ArgumentsAdjuster = [&CSourcesToMerge, this](
-    const CommandLineArguments &CL, StringRef Filename) {
+  auto adjustToEmitAST = [this](const CommandLineArguments &CL,
+                                StringRef Filename) {
     CommandLineArguments Adjusted;
     for (std::size_t I = 0; I < CL.size(); ++I) {
       StringRef Arg = CL[I];
@@ -761,22 +971,64 @@ int Tool::run(QueryManager *QM) {
       SmallString<128> PCHFile = Filename;
       sys::path::replace_extension(PCHFile, ".ast");
       Adjusted.push_back(std::string(PCHFile));
-      CSourcesToMerge.push_back(std::string(PCHFile));
     } else {
       Adjusted.push_back(mOutputFilename);
-      CSourcesToMerge.push_back(mOutputFilename);
     }
     return Adjusted;
   };
-  EmitPCHTool.appendArgumentsAdjuster(ArgumentsAdjuster);
+  // AST files which are emitted to be merged are intermediate results, so
+  // they are regenerated only if sources or options have been changed.
+  auto newEmitASTFactory = [this]() {
+    auto Factory{
+        newClangActionFactory<GeneratePCHAction, GenPCHPragmaAction>()};
+    if (mEmitAST)
+      return Factory;
+    return std::unique_ptr<FrontendActionFactory>(
+        std::make_unique<ReuseASTActionFactory>(std::move(Factory)));
+  };
+  // Emit Clang AST files for sources in NoASTCSources. Names of emitted files
+  // are appended to CSourcesToMerge in the order of sources. Evaluation of
+  // Clang AST files by this tool leads an error, so these sources should be
+  // excluded.
+  auto emitAST = [this, &NoASTCSources, &CSourcesToMerge, &adjustToEmitAST,
+                  &newEmitASTFactory]() {
+    if (mGlobalOpts.NumThreads == 1 || NoASTCSources.size() < 2) {
+      ClangTool EmitPCHTool(*mCompilations, NoASTCSources);
+      EmitPCHTool.appendArgumentsAdjuster(
+          [&CSourcesToMerge, &adjustToEmitAST](const CommandLineArguments &CL,
+                                               StringRef Filename) {
+            auto Adjusted{adjustToEmitAST(CL, Filename)};
+            CSourcesToMerge.push_back(Adjusted.back());
+            return Adjusted;
+          });
+      return EmitPCHTool.run(newEmitASTFactory().get());
+    }
+    std::vector<std::vector<std::string>> ASTFiles(NoASTCSources.size());
+    auto Res{runConcurrently(
+        mGlobalOpts.NumThreads, *mCompilations, NoASTCSources, mCommandLine,
+        errs(), errs(),
+        [&ASTFiles, &adjustToEmitAST, &newEmitASTFactory](
+            ClangTool &EmitPCHTool, raw_ostream &, std::size_t I) {
+          EmitPCHTool.appendArgumentsAdjuster(
+              [&ASTFiles, &adjustToEmitAST, I](const CommandLineArguments &CL,
+                                               StringRef Filename) {
+                auto Adjusted{adjustToEmitAST(CL, Filename)};
+                ASTFiles[I].push_back(Adjusted.back());
+                return Adjusted;
+              });
+          return EmitPCHTool.run(newEmitASTFactory().get());
+        })};
+    for (auto &Files : ASTFiles)
+      CSourcesToMerge.insert(CSourcesToMerge.end(), Files.begin(), Files.end());
+    return Res;
+  };
   if (mEmitAST) {
     if (!mOutputFilename.empty() && NoASTCSources.size() > 1) {
       errs() << "WARNING: The -o (output filename) option is ignored when "
                 "generating multiple output files.\n";
       mOutputFilename.clear();
     }
-    return EmitPCHTool.run(
-        newClangActionFactory<GeneratePCHAction, GenPCHPragmaAction>().get());
+    return emitAST();
   }
   if (!mOutputFilename.empty())
     errs() << "WARNING: The -o (output filename) option is ignored when "
@@ -788,22 +1040,42 @@ int Tool::run(QueryManager *QM) {
   // analysis. AST files will be stored in CSourcesToMerge collection.
   // If an input file already contains Clang AST it will be pushed into
   // the CSourcesToMerge collection only.
-  if (mMergeAST) {
-    EmitPCHTool.run(
-        newClangActionFactory<GeneratePCHAction, GenPCHPragmaAction>().get());
+  if (mMergeAST)
+    emitAST();
+  // Each translation unit is analyzed in a separate context, so only the
+  // default analysis can be performed concurrently. Other query managers
+  // accumulate state between inputs.
+  bool RunConcurrently{mGlobalOpts.NumThreads != 1 && CSources.size() > 1 &&
+                       !mMergeAST && !mDumpAST && !mPrintAST};
+  if (RunConcurrently &&
+      (QM || mEmitLLVM || mInstrLLVM || mTfmPass || mCheck || mServer)) {
+    errs() << "WARNING: The -j option is ignored when the default analysis "
+              "is not performed.\n";
+    RunConcurrently = false;
   }
+  // Query manager refers to options of this tool, so it is owned by the
+  // tool rather than shared between tools (in a batch mode).
+  std::unique_ptr<QueryManager> DefaultQM;
   if (!QM) {
-    if (mEmitLLVM)
-      QM = getEmitLLVMQM();
-    else if (mInstrLLVM)
-      QM = getInstrLLVMQM(mGlobalOpts, mInstrEntry, mInstrStart);
-    else if (mTfmPass)
-      QM = getTransformationQM(mTfmPass, mGlobalOpts);
-    else if (mCheck)
-      QM = getCheckQM();
-    else
-      QM = getDefaultQM(mServer, mOutputPasses, mPrintPasses,
-        (DefaultQueryManager::ProcessingStep)mPrintSteps, mGlobalOpts);
+    if (mEmitLLVM) {
+      DefaultQM = std::make_unique<EmitLLVMQueryManager>();
+    } else if (mInstrLLVM) {
+      DefaultQM = std::make_unique<InstrLLVMQueryManager>(
+          &mGlobalOpts, mInstrEntry, mInstrStart);
+    } else if (mTfmPass) {
+      DefaultQM =
+          std::make_unique<TransformationQueryManager>(mTfmPass, &mGlobalOpts);
+    } else if (mCheck) {
+      DefaultQM = std::make_unique<CheckQueryManager>();
+    } else {
+      auto *DQM{new DefaultQueryManager(
+          mServer, &mGlobalOpts, mOutputPasses, mPrintPasses,
+          (DefaultQueryManager::ProcessingStep)mPrintSteps)};
+      if (mOutput)
+        DQM->setPrintStream(*mOutput);
+      DefaultQM.reset(DQM);
+    }
+    QM = DefaultQM.get();
   }
   auto ImportInfoStorage = QM->initializeImportInfo();
   if (mMergeAST) {
@@ -812,23 +1084,26 @@ int Tool::run(QueryManager *QM) {
     if (mDumpAST)
       return CTool.run(
           newClangActionFactory<tsar::ASTDumpAction, tsar::ASTMergeAction>(
-              std::forward_as_tuple(), std::forward_as_tuple(CSourcesToMerge))
+              std::forward_as_tuple(),
+              std::forward_as_tuple(CSourcesToMerge, mGlobalOpts.NumThreads))
               .get());
     if (mPrintAST)
       return CTool.run(
           newClangActionFactory<tsar::ASTPrintAction, tsar::ASTMergeAction>(
-              std::forward_as_tuple(), std::forward_as_tuple(CSourcesToMerge))
+              std::forward_as_tuple(),
+              std::forward_as_tuple(CSourcesToMerge, mGlobalOpts.NumThreads))
               .get());
     if (!ImportInfoStorage)
       return CTool.run(
           newClangActionFactory<ClangMainAction, tsar::ASTMergeAction>(
               std::forward_as_tuple(*mCompilations, *QM),
-              std::forward_as_tuple(CSourcesToMerge))
+              std::forward_as_tuple(CSourcesToMerge, mGlobalOpts.NumThreads))
               .get());
     return CTool.run(
         newClangActionFactory<ClangMainAction, ASTMergeActionWithInfo>(
             std::forward_as_tuple(*mCompilations, *QM),
-            std::forward_as_tuple(CSourcesToMerge, ImportInfoStorage))
+            std::forward_as_tuple(CSourcesToMerge, ImportInfoStorage,
+                                  mGlobalOpts.NumThreads))
             .get());
   }
   ClangTool CTool(*mCompilations, CSources);
@@ -841,7 +1116,23 @@ int Tool::run(QueryManager *QM) {
         newClangActionFactory<tsar::ASTPrintAction, tsar::GenPCHPragmaAction>()
             .get());
   auto CRes{
-      CTool.run(newClangActionFactory<ClangMainAction, GenPCHPragmaAction>(
+      RunConcurrently
+          ? runConcurrently(
+                mGlobalOpts.NumThreads, *mCompilations, CSources, mCommandLine,
+                errs(), mOutput ? *mOutput : errs(),
+                [this](ClangTool &JobTool, raw_ostream &OS, std::size_t) {
+                  DefaultQueryManager JobQM(
+                      false, &mGlobalOpts, mOutputPasses, mPrintPasses,
+                      (DefaultQueryManager::ProcessingStep)mPrintSteps);
+                  JobQM.setPrintStream(OS);
+                  return JobTool.run(
+                      newClangActionFactory<ClangMainAction,
+                                            GenPCHPragmaAction>(
+                          std::forward_as_tuple(*mCompilations, JobQM))
+                          .get());
+                })
+          : CTool.run(
+                newClangActionFactory<ClangMainAction, GenPCHPragmaAction>(
                     std::forward_as_tuple(*mCompilations, *QM))
                     .get())};
   int FortranRes{0};
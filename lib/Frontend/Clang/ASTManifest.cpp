@@ -0,0 +1,197 @@
+//===- ASTManifest.cpp --- Reuse of Emitted AST Files -----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a factory of actions which emit Clang AST files only if
+// previously emitted files are out of date.
+//
+// Manifest is a text file, each line contains a kind of a record, a hash and
+// an optional path:
+//   version <hash of the tool version>
+//   command <hash of compile options>
+//   output <hash of AST file>
+//   input <hash of file> <path to file>
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Frontend/Clang/ASTManifest.h"
+#include "tsar/Core/tsar-config.h"
+#include "tsar/Support/OutputFile.h"
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Serialization/ASTReader.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/Allocator.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/StringSaver.h>
+#include <llvm/Support/raw_ostream.h>
+#include <vector>
+
+using namespace clang;
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+/// Collect files which have been used to emit an AST file.
+class InputFileCollector : public ASTReaderListener {
+public:
+  explicit InputFileCollector(std::vector<std::string> &Files)
+      : mFiles(Files) {}
+
+  bool needsInputFileVisitation() override { return true; }
+  bool needsSystemInputFileVisitation() override { return true; }
+
+  bool visitInputFile(StringRef Filename, bool IsSystem, bool IsOverridden,
+                      bool IsExplicitModule) override {
+    mFiles.push_back(Filename.str());
+    return true;
+  }
+
+private:
+  std::vector<std::string> &mFiles;
+};
+
+std::string getDigest(MD5 &Hash) {
+  MD5::MD5Result Res;
+  Hash.final(Res);
+  return std::string(Res.digest());
+}
+
+Optional<std::string> computeFileHash(StringRef Path) {
+  auto FileOrErr{MemoryBuffer::getFile(Path)};
+  if (!FileOrErr)
+    return None;
+  MD5 Hash;
+  Hash.update((**FileOrErr).getBuffer());
+  return getDigest(Hash);
+}
+
+std::string computeCommandHash(const CompilerInvocation &Invocation) {
+  BumpPtrAllocator Alloc;
+  StringSaver Saver(Alloc);
+  SmallVector<const char *, 64> Args;
+  Invocation.generateCC1CommandLine(
+      Args, [&Saver](const Twine &Arg) { return Saver.save(Arg).data(); });
+  MD5 Hash;
+  for (StringRef Arg : Args) {
+    Hash.update(Arg);
+    // Separate arguments to distinguish "-a" "b" from "-ab".
+    Hash.update(StringRef("\0", 1));
+  }
+  return getDigest(Hash);
+}
+
+std::string computeVersionHash() {
+  MD5 Hash;
+  Hash.update(TSAR_VERSION_STRING);
+  return getDigest(Hash);
+}
+}
+
+std::string tsar::getASTManifestPath(StringRef ASTFile) {
+  return (ASTFile + ".manifest").str();
+}
+
+bool tsar::isASTUpToDate(StringRef ASTFile, StringRef CommandHash) {
+  auto FileOrErr{MemoryBuffer::getFile(getASTManifestPath(ASTFile))};
+  if (!FileOrErr)
+    return false;
+  bool HasVersion{false}, HasCommand{false}, HasOutput{false};
+  SmallVector<StringRef, 64> Lines;
+  (**FileOrErr).getBuffer().split(Lines, '\n', -1, false);
+  for (auto Line : Lines) {
+    auto [Kind, Tail] = Line.split(' ');
+    auto [Hash, Path] = Tail.split(' ');
+    if (Kind == "version") {
+      if (Hash != computeVersionHash())
+        return false;
+      HasVersion = true;
+    } else if (Kind == "command") {
+      if (Hash != CommandHash)
+        return false;
+      HasCommand = true;
+    } else if (Kind == "output") {
+      auto Current{computeFileHash(ASTFile)};
+      if (!Current || Hash != *Current)
+        return false;
+      HasOutput = true;
+    } else if (Kind == "input") {
+      auto Current{computeFileHash(Path)};
+      if (!Current || Hash != *Current)
+        return false;
+    } else {
+      return false;
+    }
+  }
+  return HasVersion && HasCommand && HasOutput;
+}
+
+Error tsar::writeASTManifest(StringRef ASTFile, StringRef CommandHash,
+                             FileManager &FileMgr,
+                             const PCHContainerReader &PCHContainerRdr) {
+  std::vector<std::string> Inputs;
+  InputFileCollector Collector(Inputs);
+  if (ASTReader::readASTFileControlBlock(ASTFile, FileMgr, PCHContainerRdr,
+                                         false, Collector, false))
+    return createStringError(inconvertibleErrorCode(),
+                             "unable to read inputs of '" + ASTFile + "'");
+  auto OutputHash{computeFileHash(ASTFile)};
+  if (!OutputHash)
+    return createStringError(inconvertibleErrorCode(),
+                             "unable to read '" + ASTFile + "'");
+  std::string Manifest;
+  raw_string_ostream OS(Manifest);
+  OS << "version " << computeVersionHash() << "\n";
+  OS << "command " << CommandHash << "\n";
+  OS << "output " << *OutputHash << "\n";
+  for (auto &Input : Inputs) {
+    auto Hash{computeFileHash(Input)};
+    if (!Hash)
+      return createStringError(inconvertibleErrorCode(),
+                               "unable to read '" + Input + "'");
+    OS << "input " << *Hash << " " << Input << "\n";
+  }
+  auto OF{OutputFile::create(getASTManifestPath(ASTFile), false)};
+  if (!OF)
+    return OF.takeError();
+  OF->getStream() << OS.str();
+  return OF->clear();
+}
+
+bool ReuseASTActionFactory::runInvocation(
+    std::shared_ptr<CompilerInvocation> Invocation, FileManager *Files,
+    std::shared_ptr<PCHContainerOperations> PCHContainerOps,
+    DiagnosticConsumer *DiagConsumer) {
+  auto ASTFile{Invocation->getFrontendOpts().OutputFile};
+  auto CommandHash{computeCommandHash(*Invocation)};
+  if (isASTUpToDate(ASTFile, CommandHash))
+    return true;
+  // Remove a stale manifest at first, so it will never describe a partially
+  // emitted AST file.
+  sys::fs::remove(getASTManifestPath(ASTFile));
+  auto &PCHContainerRdr{PCHContainerOps->getRawReader()};
+  if (!FrontendActionFactory::runInvocation(std::move(Invocation), Files,
+                                            PCHContainerOps, DiagConsumer))
+    return false;
+  if (auto E{writeASTManifest(ASTFile, CommandHash, *Files, PCHContainerRdr)})
+    errs() << "warning: unable to write manifest for " << ASTFile << ": "
+           << toString(std::move(E)) << "\n";
+  return true;
+}
@@ -37,6 +37,8 @@
 #include <clang/Frontend/CompilerInstance.h>
 #include <clang/Sema/SemaDiagnostic.h>
 #include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/Support/ThreadPool.h>
+#include <mutex>
 
 using namespace clang;
 using namespace llvm;
@@ -66,6 +68,25 @@ public:
 };
 }
 
+namespace {
+/// Forwards diagnostics to a consumer which may be shared between threads.
+class SynchronizedDiagnosticConsumer : public ForwardingDiagnosticConsumer {
+public:
+  SynchronizedDiagnosticConsumer(DiagnosticConsumer &Target,
+      std::recursive_mutex &Mutex) : ForwardingDiagnosticConsumer(Target),
+    mMutex(Mutex) {}
+
+  void HandleDiagnostic(DiagnosticsEngine::Level DiagLevel,
+      const Diagnostic &Info) override {
+    std::lock_guard<std::recursive_mutex> Lock(mMutex);
+    ForwardingDiagnosticConsumer::HandleDiagnostic(DiagLevel, Info);
+  }
+
+private:
+  std::recursive_mutex &mMutex;
+};
+}
+
 namespace tsar {
 /// This is implementation of ASTImporter for the general use in analyzer.
 class GeneralImporter : public ASTImporter {
@@ -268,16 +289,59 @@ void ASTMergeAction::ExecuteAction() {
   // successfully loaded. However this leads to assertion fail when deferred
   // locations f will be emitted by CodeGenModule::EmitDeferred().
   CI.getASTContext().getTranslationUnitDecl()->decls_begin();
+  // Deserialization of AST files is independent, so files are loaded in
+  // a pool of threads ahead of import. However, the import itself is
+  // sequential: all importers share the target context and ASTImportInfo
+  // refers to locations in this context, so the order of imported
+  // declarations (and conflict resolution) does not depend on the number of
+  // threads. To bound memory usage only a window of files is loaded ahead.
+  //
+  // Diagnostics engines are created and destroyed in the current thread
+  // only, because reference counters of DiagnosticIDs and DiagnosticOptions
+  // are not thread-safe.
+  Optional<ThreadPool> Pool;
+  if (mNumThreads != 1 && mASTFiles.size() > 1)
+    Pool.emplace(hardware_concurrency(mNumThreads));
+  std::recursive_mutex DiagMutex;
+  std::vector<IntrusiveRefCntPtr<DiagnosticsEngine>> UnitDiags(
+    mASTFiles.size());
+  std::vector<std::unique_ptr<ASTUnit>> Units(mASTFiles.size());
+  std::vector<std::shared_future<void>> Loaded(mASTFiles.size());
+  auto load = [this, &CI, &DiagIDs, &DiagMutex, &Pool, &UnitDiags, &Units,
+      &Loaded](unsigned I) {
+    UnitDiags[I] = new DiagnosticsEngine(DiagIDs, &CI.getDiagnosticOpts(),
+      new SynchronizedDiagnosticConsumer(
+        *CI.getDiagnostics().getClient(), DiagMutex),
+      /*ShouldOwnClient=*/true);
+    auto LoadUnit = [this, &CI, &UnitDiags, &Units, I]() {
+      Units[I] = ASTUnit::LoadFromASTFile(mASTFiles[I],
+        CI.getPCHContainerReader(), ASTUnit::LoadEverything, UnitDiags[I],
+        CI.getFileSystemOpts(), false);
+    };
+    if (Pool)
+      Loaded[I] = Pool->async(LoadUnit);
+    else
+      LoadUnit();
+  };
+  unsigned Window = Pool ? 2 * Pool->getThreadCount() : 1;
+  for (unsigned I = 0, N = std::min<unsigned>(Window, mASTFiles.size());
+       I < N; ++I)
+    load(I);
   for (unsigned I = 0, N = mASTFiles.size(); I != N; ++I) {
-    IntrusiveRefCntPtr<DiagnosticsEngine>
-      Diags(new DiagnosticsEngine(DiagIDs, &CI.getDiagnosticOpts(),
-        new ForwardingDiagnosticConsumer(
-          *CI.getDiagnostics().getClient()), /*ShouldOwnClient=*/true));
-    std::unique_ptr<ASTUnit> Unit =
-      ASTUnit::LoadFromASTFile(mASTFiles[I], CI.getPCHContainerReader(),
-        ASTUnit::LoadEverything, Diags, CI.getFileSystemOpts(), false);
+    if (Loaded[I].valid())
+      Loaded[I].wait();
+    if (I + Window < N)
+      load(I + Window);
+    std::unique_ptr<ASTUnit> Unit = std::move(Units[I]);
+    // The unit holds its own reference to the diagnostics engine.
+    UnitDiags[I].reset();
     if (!Unit)
       continue;
+    // Importer emits diagnostics to the shared consumer directly, so the
+    // consumer is locked until the unit is imported. The lock is recursive
+    // because diagnostics related to the imported unit are emitted through
+    // SynchronizedDiagnosticConsumer.
+    std::lock_guard<std::recursive_mutex> Lock(DiagMutex);
     std::unique_ptr<ASTImporter> Importer(
       newImporter(CI.getASTContext(), CI.getFileManager(),
         Unit->getASTContext(), Unit->getFileManager(), /*MinimalImport=*/false));
@@ -366,9 +430,9 @@ bool ASTMergeAction::BeginSourceFileAction(CompilerInstance &CI) {
 
 ASTMergeAction::ASTMergeAction(
     std::unique_ptr<clang::FrontendAction> WrappedAction,
-    clang::ArrayRef<std::string> ASTFiles) :
+    clang::ArrayRef<std::string> ASTFiles, unsigned NumThreads) :
   PublicWrapperFrontendAction(WrappedAction.release()),
-  mASTFiles(ASTFiles.begin(), ASTFiles.end()) {}
+  mASTFiles(ASTFiles.begin(), ASTFiles.end()), mNumThreads(NumThreads) {}
 }
 
 INITIALIZE_PASS(ImmutableASTImportInfoPass, "clang-import-info",
@@ -31,6 +31,9 @@
 #include <clang/CodeGen/ModuleBuilder.h>
 #include <clang/Frontend/CompilerInstance.h>
 #include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/DiagnosticHandler.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/DiagnosticPrinter.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
 #include <llvm/Support/Timer.h>
@@ -40,6 +43,41 @@ using namespace clang;
 using namespace llvm;
 using namespace tsar;
 
+namespace {
+/// This forwards diagnostics emitted by LLVM passes to a Clang diagnostics
+/// engine.
+///
+/// Otherwise, LLVMContext prints these diagnostics to errs() and terminates
+/// the process on errors. So, they bypass a diagnostic consumer of a source
+/// and break processing of other sources if sources are processed
+/// concurrently. Remarks are still processed by LLVMContext because it takes
+/// into account command line options which enable remarks.
+class AnalysisDiagnosticHandler final : public llvm::DiagnosticHandler {
+public:
+  explicit AnalysisDiagnosticHandler(DiagnosticsEngine &Diags)
+      : mDiags(&Diags) {}
+
+  bool handleDiagnostics(const llvm::DiagnosticInfo &DI) override {
+    DiagnosticsEngine::Level Level;
+    switch (DI.getSeverity()) {
+    case DS_Error: Level = DiagnosticsEngine::Error; break;
+    case DS_Warning: Level = DiagnosticsEngine::Warning; break;
+    case DS_Note: Level = DiagnosticsEngine::Note; break;
+    default: return false;
+    }
+    std::string Msg;
+    raw_string_ostream OS(Msg);
+    DiagnosticPrinterRawOStream DP(OS);
+    DI.print(DP);
+    mDiags->Report(mDiags->getCustomDiagID(Level, "%0")) << OS.str();
+    return true;
+  }
+
+private:
+  DiagnosticsEngine *mDiags;
+};
+}
+
 namespace clang {
 /// This consumer builds LLVM IR for the specified file and launch analysis of
 /// the LLVM IR.
@@ -54,7 +92,10 @@ public:
             CI.getDiagnostics(), InFile, &CI.getVirtualFileSystem(),
             CI.getHeaderSearchOpts(), CI.getPreprocessorOpts(),
             CI.getCodeGenOpts(), *mLLVMContext)),
-        mTransformInfo(&TfmInfo), mQueryManager(&QM) {}
+        mTransformInfo(&TfmInfo), mQueryManager(&QM) {
+    mLLVMContext->setDiagnosticHandler(
+        std::make_unique<AnalysisDiagnosticHandler>(CI.getDiagnostics()));
+  }
 
   void HandleCXXStaticMemberVarInstantiation(VarDecl *VD) override {
     mGen->HandleCXXStaticMemberVarInstantiation(VD);
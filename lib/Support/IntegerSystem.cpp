@@ -0,0 +1,485 @@
+//===- IntegerSystem.cpp -- System of Integer Constraints -------*- C++ -*-===//
+//
+//                     Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a check whether a system of linear constraints has
+// an integer solution.
+//
+// Equalities are eliminated at first. If there is no variable with a unit
+// coefficient in an equality, variables are changed (with a unimodular
+// transformation) to reduce coefficients in the equality. Then, variables are
+// eliminated from inequalities with the Fourier-Motzkin method. Elimination is
+// exact if all lower or all upper bounds of a variable have unit
+// coefficients. Otherwise, the real shadow, the dark shadow and splinters of
+// the system are explored as the Omega test suggests.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Support/IntegerSystem.h"
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/STLExtras.h>
+#include <llvm/Support/Compiler.h>
+#include <llvm/Support/Debug.h>
+#include <llvm/Support/MathExtras.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <limits>
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "integer-system"
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+using CoefficientT = IntegerSystem::CoefficientT;
+using Constraint = IntegerSystem::Constraint;
+using ConstraintList = SmallVector<Constraint, 16>;
+using FeasibilityKind = IntegerSystem::FeasibilityKind;
+
+constexpr CoefficientT MinCoefficient =
+    std::numeric_limits<CoefficientT>::min();
+
+/// Return the largest integer which is not greater than N / D.
+CoefficientT floorDiv(CoefficientT N, CoefficientT D) {
+  assert(D != 0 && "Division by zero!");
+  auto Q = N / D;
+  if (N % D != 0 && ((N < 0) != (D < 0)))
+    --Q;
+  return Q;
+}
+
+/// Compute Out = LF * L + RF * R, return false on overflow.
+bool combine(const Constraint &L, CoefficientT LF, const Constraint &R,
+             CoefficientT RF, Constraint &Out) {
+  assert(L.Coeffs.size() == R.Coeffs.size() &&
+         "Constraints must have the same number of variables!");
+  Out.Coeffs.resize(L.Coeffs.size());
+  for (unsigned I = 0, EI = L.Coeffs.size(); I < EI; ++I) {
+    CoefficientT LV, RV;
+    if (MulOverflow(L.Coeffs[I], LF, LV) || MulOverflow(R.Coeffs[I], RF, RV) ||
+        AddOverflow(LV, RV, Out.Coeffs[I]))
+      return false;
+  }
+  return true;
+}
+
+/// Implementation of the Omega test.
+class OmegaSolver {
+public:
+  OmegaSolver(unsigned NumVars, unsigned &Budget)
+      : mNumVars(NumVars), mBudget(Budget) {}
+
+  /// Check whether a specified system has an integer solution.
+  FeasibilityKind solve(ConstraintList Rows);
+
+private:
+  /// Consume a specified number of units of the budget, return false if
+  /// the budget is exhausted.
+  bool consume(unsigned Units = 1) {
+    if (mBudget < Units) {
+      mBudget = 0;
+      return false;
+    }
+    mBudget -= Units;
+    return true;
+  }
+
+  /// Divide constraints by GCD of their coefficients, remove trivial
+  /// constraints and merge constraints with the same coefficients.
+  ///
+  /// Return `Feasible` if a system has not been proved to be infeasible.
+  FeasibilityKind normalize(ConstraintList &Rows);
+
+  /// Eliminate a variable using a specified equality or change variables to
+  /// reduce coefficients in the equality.
+  bool eliminateEquality(ConstraintList &Rows, unsigned EqIdx);
+
+  /// Eliminate a specified variable from a system of inequalities. Compute
+  /// the real shadow if `IsDark` is false and the dark shadow otherwise.
+  bool project(const ConstraintList &Rows, unsigned Var, bool IsDark,
+               ConstraintList &Out);
+
+  /// Explore systems which contain an equality close to one of lower
+  /// bounds of a specified variable.
+  FeasibilityKind splinter(const ConstraintList &Rows, unsigned Var);
+
+  unsigned mNumVars;
+  unsigned &mBudget;
+};
+
+FeasibilityKind OmegaSolver::normalize(ConstraintList &Rows) {
+  for (auto &R : Rows) {
+    uint64_t GCD = 0;
+    for (unsigned I = 0; I <= mNumVars; ++I)
+      if (R.Coeffs[I] == MinCoefficient)
+        return IntegerSystem::Unknown;
+    for (unsigned I = 0; I < mNumVars; ++I)
+      GCD = GreatestCommonDivisor64(GCD, std::abs(R.Coeffs[I]));
+    auto &Const = R.Coeffs.back();
+    if (GCD == 0) {
+      if (R.IsEquality ? Const != 0 : Const < 0)
+        return IntegerSystem::Infeasible;
+      continue;
+    }
+    auto G = static_cast<CoefficientT>(GCD);
+    if (R.IsEquality && Const % G != 0)
+      return IntegerSystem::Infeasible;
+    for (unsigned I = 0; I < mNumVars; ++I)
+      R.Coeffs[I] /= G;
+    Const = R.IsEquality ? Const / G : floorDiv(Const, G);
+  }
+  // Remove constraints without variables, they are always satisfied here.
+  erase_if(Rows, [this](const Constraint &R) {
+    return all_of(make_range(R.Coeffs.begin(), R.Coeffs.begin() + mNumVars),
+                  [](CoefficientT C) { return C == 0; });
+  });
+  // Constraints C * x + c1 >= 0, -C * x + c2 >= 0 and C * x + c3 = 0 are
+  // bounds of C * x. So, sort constraints to place constraints with
+  // the same C nearby and merge them.
+  auto getSign = [this](const Constraint &R) -> CoefficientT {
+    auto Itr = std::find_if(R.Coeffs.begin(), R.Coeffs.begin() + mNumVars,
+                            [](CoefficientT C) { return C != 0; });
+    return *Itr > 0 ? 1 : -1;
+  };
+  SmallVector<unsigned, 16> Order(Rows.size());
+  for (unsigned I = 0, EI = Rows.size(); I < EI; ++I)
+    Order[I] = I;
+  auto compare = [this, &Rows, &getSign](unsigned L, unsigned R) {
+    auto LS = getSign(Rows[L]), RS = getSign(Rows[R]);
+    for (unsigned I = 0; I < mNumVars; ++I)
+      if (LS * Rows[L].Coeffs[I] != RS * Rows[R].Coeffs[I])
+        return LS * Rows[L].Coeffs[I] < RS * Rows[R].Coeffs[I];
+    return false;
+  };
+  llvm::sort(Order, compare);
+  ConstraintList Merged;
+  for (unsigned I = 0, EI = Order.size(); I < EI;) {
+    auto &Base = Rows[Order[I]];
+    auto BaseSign = getSign(Base);
+    Optional<CoefficientT> Value, Lower, Upper;
+    unsigned J = I;
+    for (; J < EI && !compare(Order[I], Order[J]); ++J) {
+      auto &R = Rows[Order[J]];
+      auto S = getSign(R);
+      auto Const = R.Coeffs.back();
+      // Bounds of C * x, where the first non-zero coefficient in C is
+      // positive.
+      if (R.IsEquality) {
+        auto V = S > 0 ? -Const : Const;
+        if (Value && *Value != V)
+          return IntegerSystem::Infeasible;
+        Value = V;
+      } else if (S > 0) {
+        Lower = Lower ? std::max(*Lower, -Const) : -Const;
+      } else {
+        Upper = Upper ? std::min(*Upper, Const) : Const;
+      }
+    }
+    auto emit = [this, &Merged, &Base, BaseSign](CoefficientT Sign,
+                                                 CoefficientT Const,
+                                                 bool IsEquality) {
+      Merged.emplace_back();
+      auto &R = Merged.back();
+      R.IsEquality = IsEquality;
+      R.Coeffs.resize(mNumVars + 1);
+      for (unsigned I = 0; I < mNumVars; ++I)
+        R.Coeffs[I] = Sign * BaseSign * Base.Coeffs[I];
+      R.Coeffs.back() = Const;
+    };
+    if (Lower && Upper && *Lower == *Upper && !Value)
+      Value = Lower;
+    if (Value) {
+      if ((Lower && *Lower > *Value) || (Upper && *Upper < *Value))
+        return IntegerSystem::Infeasible;
+      emit(1, -*Value, true);
+    } else {
+      if (Lower && Upper && *Lower > *Upper)
+        return IntegerSystem::Infeasible;
+      if (Lower)
+        emit(1, -*Lower, false);
+      if (Upper)
+        emit(-1, *Upper, false);
+    }
+    I = J;
+  }
+  Rows = std::move(Merged);
+  return IntegerSystem::Feasible;
+}
+
+bool OmegaSolver::eliminateEquality(ConstraintList &Rows, unsigned EqIdx) {
+  unsigned Var = mNumVars;
+  for (unsigned I = 0; I < mNumVars; ++I)
+    if (Rows[EqIdx].Coeffs[I] != 0 &&
+        (Var == mNumVars ||
+         std::abs(Rows[EqIdx].Coeffs[I]) < std::abs(Rows[EqIdx].Coeffs[Var])))
+      Var = I;
+  assert(Var < mNumVars && "Equality must contain a variable!");
+  auto VarCoeff = Rows[EqIdx].Coeffs[Var];
+  if (std::abs(VarCoeff) == 1) {
+    // Substitute x_Var = -VarCoeff * (other terms) to all constraints.
+    auto Eq = std::move(Rows[EqIdx]);
+    Rows.erase(Rows.begin() + EqIdx);
+    for (auto &R : Rows) {
+      if (R.Coeffs[Var] == 0)
+        continue;
+      if (!consume())
+        return false;
+      Constraint Out;
+      Out.IsEquality = R.IsEquality;
+      if (!combine(R, 1, Eq, -R.Coeffs[Var] * VarCoeff, Out))
+        return false;
+      R = std::move(Out);
+    }
+    return true;
+  }
+  // Change variables x_Var = y_Var - Q * x_I to reduce coefficients of x_I
+  // in the equality, so the smallest coefficient decreases.
+  for (unsigned I = 0; I < mNumVars; ++I) {
+    if (I == Var || Rows[EqIdx].Coeffs[I] == 0)
+      continue;
+    if (!consume())
+      return false;
+    auto Q = floorDiv(Rows[EqIdx].Coeffs[I], VarCoeff);
+    for (auto &R : Rows) {
+      CoefficientT Delta;
+      if (MulOverflow(Q, R.Coeffs[Var], Delta) ||
+          SubOverflow(R.Coeffs[I], Delta, R.Coeffs[I]))
+        return false;
+    }
+  }
+  return true;
+}
+
+bool OmegaSolver::project(const ConstraintList &Rows, unsigned Var,
+                          bool IsDark, ConstraintList &Out) {
+  Out.clear();
+  for (auto &R : Rows)
+    if (R.Coeffs[Var] == 0)
+      Out.push_back(R);
+  for (auto &L : Rows) {
+    if (L.Coeffs[Var] <= 0)
+      continue;
+    for (auto &U : Rows) {
+      if (U.Coeffs[Var] >= 0)
+        continue;
+      if (!consume())
+        return false;
+      // L: b * x + l >= 0, U: -a * x + u >= 0, so a * l + b * u >= 0 for
+      // the real shadow and a * l + b * u >= (a - 1) * (b - 1) for the dark
+      // shadow.
+      auto A = -U.Coeffs[Var], B = L.Coeffs[Var];
+      Out.emplace_back();
+      Out.back().IsEquality = false;
+      if (!combine(L, A, U, B, Out.back()))
+        return false;
+      if (IsDark) {
+        CoefficientT Gap;
+        if (MulOverflow(A - 1, B - 1, Gap) ||
+            SubOverflow(Out.back().Coeffs.back(), Gap,
+                        Out.back().Coeffs.back()))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+FeasibilityKind OmegaSolver::splinter(const ConstraintList &Rows,
+                                      unsigned Var) {
+  // If there is an integer solution which is not in the dark shadow, then
+  // b * x = l + I for some lower bound b * x >= l of x and
+  // 0 <= I <= (MaxA * b - MaxA - b) / MaxA, where MaxA is the largest
+  // coefficient of x in upper bounds.
+  CoefficientT MaxA = 0;
+  for (auto &R : Rows)
+    MaxA = std::max(MaxA, -R.Coeffs[Var]);
+  for (auto &L : Rows) {
+    auto B = L.Coeffs[Var];
+    if (B <= 0)
+      continue;
+    CoefficientT Limit;
+    if (MulOverflow(MaxA, B, Limit))
+      return IntegerSystem::Unknown;
+    Limit = floorDiv(Limit - MaxA - B, MaxA);
+    for (CoefficientT I = 0; I <= Limit; ++I) {
+      if (!consume(Rows.size()))
+        return IntegerSystem::Unknown;
+      ConstraintList Splinter(Rows);
+      Splinter.push_back(L);
+      Splinter.back().IsEquality = true;
+      Splinter.back().Coeffs.back() -= I;
+      auto Res = solve(std::move(Splinter));
+      if (Res != IntegerSystem::Infeasible)
+        return Res;
+    }
+  }
+  return IntegerSystem::Infeasible;
+}
+
+FeasibilityKind OmegaSolver::solve(ConstraintList Rows) {
+  for (;;) {
+    if (!consume())
+      return IntegerSystem::Unknown;
+    auto Res = normalize(Rows);
+    if (Res != IntegerSystem::Feasible)
+      return Res;
+    if (Rows.empty())
+      return IntegerSystem::Feasible;
+    auto EqItr = find_if(Rows, [](const Constraint &R) {
+      return R.IsEquality;
+    });
+    if (EqItr != Rows.end()) {
+      if (!eliminateEquality(Rows, std::distance(Rows.begin(), EqItr)))
+        return IntegerSystem::Unknown;
+      continue;
+    }
+    // There are inequalities only, so choose a variable to eliminate.
+    // A variable which is bounded from one side only can be always chosen to
+    // satisfy all constraints it is used in, so remove these constraints.
+    unsigned Var = mNumVars;
+    unsigned VarCost = 0;
+    bool IsVarExact = false;
+    bool IsUnbounded = false;
+    for (unsigned I = 0; I < mNumVars && !IsUnbounded; ++I) {
+      unsigned NumLower = 0, NumUpper = 0;
+      bool IsLowerUnit = true, IsUpperUnit = true;
+      for (auto &R : Rows)
+        if (R.Coeffs[I] > 0) {
+          ++NumLower;
+          IsLowerUnit &= R.Coeffs[I] == 1;
+        } else if (R.Coeffs[I] < 0) {
+          ++NumUpper;
+          IsUpperUnit &= R.Coeffs[I] == -1;
+        }
+      if (NumLower == 0 && NumUpper == 0)
+        continue;
+      if (NumLower == 0 || NumUpper == 0) {
+        Var = I;
+        IsUnbounded = true;
+        break;
+      }
+      bool IsExact = IsLowerUnit || IsUpperUnit;
+      unsigned Cost = NumLower * NumUpper;
+      if (Var == mNumVars || (IsExact && !IsVarExact) ||
+          (IsExact == IsVarExact && Cost < VarCost)) {
+        Var = I;
+        VarCost = Cost;
+        IsVarExact = IsExact;
+      }
+    }
+    assert(Var < mNumVars && "System must contain a variable!");
+    if (IsUnbounded) {
+      erase_if(Rows, [Var](const Constraint &R) { return R.Coeffs[Var] != 0; });
+      continue;
+    }
+    ConstraintList Shadow;
+    if (IsVarExact) {
+      if (!project(Rows, Var, false, Shadow))
+        return IntegerSystem::Unknown;
+      Rows = std::move(Shadow);
+      continue;
+    }
+    LLVM_DEBUG(dbgs() << "[INTEGER SYSTEM]: inexact elimination of x" << Var
+                      << "\n");
+    if (!project(Rows, Var, false, Shadow))
+      return IntegerSystem::Unknown;
+    auto RealRes = solve(std::move(Shadow));
+    if (RealRes != IntegerSystem::Feasible)
+      return RealRes;
+    if (!project(Rows, Var, true, Shadow))
+      return IntegerSystem::Unknown;
+    auto DarkRes = solve(std::move(Shadow));
+    if (DarkRes == IntegerSystem::Feasible)
+      return IntegerSystem::Feasible;
+    // Splinters cover integer points outside the dark shadow only, so the
+    // system is infeasible if the dark shadow is proved to be infeasible.
+    auto SplinterRes = splinter(Rows, Var);
+    if (SplinterRes == IntegerSystem::Infeasible)
+      return DarkRes;
+    return SplinterRes;
+  }
+}
+}
+
+void IntegerSystem::addConstraint(ArrayRef<CoefficientT> Coeffs,
+                                  CoefficientT Const, bool IsEquality) {
+  assert(Coeffs.size() == mNumVars &&
+         "Number of coefficients must be equal to the number of variables!");
+  mConstraints.emplace_back();
+  auto &R = mConstraints.back();
+  R.IsEquality = IsEquality;
+  R.Coeffs.assign(Coeffs.begin(), Coeffs.end());
+  R.Coeffs.push_back(Const);
+}
+
+void IntegerSystem::addLowerBound(unsigned Var, CoefficientT Lower) {
+  assert(Var < mNumVars && "Variable is out of range!");
+  SmallVector<CoefficientT, 8> Coeffs(mNumVars, 0);
+  Coeffs[Var] = 1;
+  addInequality(Coeffs, -Lower);
+}
+
+void IntegerSystem::addBounds(unsigned Var, CoefficientT Lower,
+                              CoefficientT Upper) {
+  addLowerBound(Var, Lower);
+  SmallVector<CoefficientT, 8> Coeffs(mNumVars, 0);
+  Coeffs[Var] = -1;
+  addInequality(Coeffs, Upper);
+}
+
+IntegerSystem::FeasibilityKind
+IntegerSystem::isFeasible(unsigned &Budget) const {
+  OmegaSolver Solver(mNumVars, Budget);
+  auto Res = Solver.solve(ConstraintList(mConstraints.begin(),
+                                         mConstraints.end()));
+  LLVM_DEBUG(dbgs() << "[INTEGER SYSTEM]: system is "
+                    << (Res == Feasible     ? "feasible"
+                        : Res == Infeasible ? "infeasible"
+                                            : "unknown")
+                    << " (remaining budget " << Budget << ")\n");
+  return Res;
+}
+
+void IntegerSystem::print(raw_ostream &OS) const {
+  for (auto &R : mConstraints) {
+    bool IsFirst = true;
+    for (unsigned I = 0; I < mNumVars; ++I) {
+      if (R.Coeffs[I] == 0)
+        continue;
+      auto C = R.Coeffs[I];
+      if (!IsFirst)
+        OS << (C < 0 ? " - " : " + ");
+      else if (C < 0)
+        OS << "-";
+      if (std::abs(C) != 1)
+        OS << std::abs(C) << "*";
+      OS << "x" << I;
+      IsFirst = false;
+    }
+    auto Const = R.Coeffs.back();
+    if (IsFirst)
+      OS << Const;
+    else if (Const != 0)
+      OS << (Const < 0 ? " - " : " + ") << std::abs(Const);
+    OS << (R.IsEquality ? " = 0\n" : " >= 0\n");
+  }
+}
+
+LLVM_DUMP_METHOD void IntegerSystem::dump() const { print(dbgs()); }
@@ -127,6 +127,188 @@ bool pointsToLocalMemory(const Value &V, const Loop &L) {
   return false;
 }
 
+namespace {
+/// Builder of a fingerprint of a function.
+///
+/// Values which are defined in a function are numbered in order of their
+/// definition, constants are hashed by value and global values are hashed by
+/// name. So, the structure of a function is hashed and addresses of values
+/// do not affect the fingerprint.
+class FingerprintBuilder {
+public:
+  explicit FingerprintBuilder(const Function &F) {
+    for (auto &A : F.args())
+      mNumbers.try_emplace(&A, mNumbers.size());
+    for (auto &BB : F) {
+      mNumbers.try_emplace(&BB, mNumbers.size());
+      for (auto &I : BB)
+        mNumbers.try_emplace(&I, mNumbers.size());
+    }
+  }
+
+  template<class T> void update(T V) {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Unsupported type of value!");
+    mHash.update(
+        makeArrayRef(reinterpret_cast<const uint8_t *>(&V), sizeof(V)));
+  }
+
+  void update(StringRef Str) {
+    update(Str.size());
+    mHash.update(Str);
+  }
+
+  template<class T> void update(ArrayRef<T> List) {
+    update(List.size());
+    for (auto V : List)
+      update(V);
+  }
+
+  void update(AttributeList AL) {
+    update(AL.getNumAttrSets());
+    for (auto AS : AL)
+      update(StringRef(AS.getAsString()));
+  }
+
+  /// Update hash with a value which is used as an operand.
+  void updateValue(const Value *V) {
+    update(V->getValueID());
+    if (auto I{mNumbers.find(V)}; I != mNumbers.end()) {
+      update(I->second);
+      return;
+    }
+    // Types and metadata are uniqued in a context and they are not released
+    // while the context exists.
+    update(V->getType());
+    if (auto *GV{dyn_cast<GlobalValue>(V)}) {
+      update(GV->getName());
+    } else if (auto *CI{dyn_cast<ConstantInt>(V)}) {
+      update(hash_value(CI->getValue()));
+    } else if (auto *CFP{dyn_cast<ConstantFP>(V)}) {
+      update(hash_value(CFP->getValueAPF()));
+    } else if (auto *CDS{dyn_cast<ConstantDataSequential>(V)}) {
+      update(CDS->getRawDataValues());
+    } else if (auto *MAV{dyn_cast<MetadataAsValue>(V)}) {
+      update(MAV->getMetadata());
+    } else if (auto *IA{dyn_cast<InlineAsm>(V)}) {
+      update(StringRef(IA->getAsmString()));
+      update(StringRef(IA->getConstraintString()));
+    } else if (auto *C{dyn_cast<Constant>(V)}) {
+      if (auto *CE{dyn_cast<ConstantExpr>(C)}) {
+        update(CE->getOpcode());
+        if (CE->isCompare())
+          update(CE->getPredicate());
+        if (CE->hasIndices())
+          update(CE->getIndices());
+        if (auto *GEP{dyn_cast<GEPOperator>(CE)})
+          update(GEP->getSourceElementType());
+        update(CE->getRawSubclassOptionalData());
+      }
+      update(C->getNumOperands());
+      for (auto &Op : C->operands())
+        updateValue(Op.get());
+    }
+  }
+
+  FunctionFingerprint final() {
+    FunctionFingerprint Res;
+    mHash.final(Res);
+    return Res;
+  }
+
+private:
+  MD5 mHash;
+  DenseMap<const Value *, unsigned> mNumbers;
+};
+}
+
+FunctionFingerprint computeFingerprint(const Function &F) {
+  FingerprintBuilder Hash(F);
+  Hash.update(F.getName());
+  Hash.update(F.getLinkage());
+  Hash.update(F.getFunctionType());
+  Hash.update(F.getAttributes());
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  for (auto &BB : F) {
+    for (auto &I : BB) {
+      Hash.update(I.getOpcode());
+      Hash.update(I.getType());
+      Hash.update(I.getRawSubclassOptionalData());
+      Hash.update(I.getNumOperands());
+      for (auto &Op : I.operands())
+        Hash.updateValue(Op.get());
+      if (auto *Phi{dyn_cast<PHINode>(&I)}) {
+        for (auto *Incoming : Phi->blocks())
+          Hash.updateValue(Incoming);
+      } else if (auto *Cmp{dyn_cast<CmpInst>(&I)}) {
+        Hash.update(Cmp->getPredicate());
+      } else if (auto *Call{dyn_cast<CallBase>(&I)}) {
+        Hash.update(Call->getCallingConv());
+        Hash.update(Call->getFunctionType());
+        Hash.update(Call->getAttributes());
+        if (auto *Callee{Call->getCalledFunction()})
+          Hash.update(Callee->getAttributes());
+      } else if (auto *LI{dyn_cast<LoadInst>(&I)}) {
+        Hash.update(LI->isVolatile());
+        Hash.update(LI->getAlign().value());
+        Hash.update(LI->getOrdering());
+      } else if (auto *SI{dyn_cast<StoreInst>(&I)}) {
+        Hash.update(SI->isVolatile());
+        Hash.update(SI->getAlign().value());
+        Hash.update(SI->getOrdering());
+      } else if (auto *AI{dyn_cast<AllocaInst>(&I)}) {
+        Hash.update(AI->getAllocatedType());
+        Hash.update(AI->getAlign().value());
+      } else if (auto *GEP{dyn_cast<GetElementPtrInst>(&I)}) {
+        Hash.update(GEP->getSourceElementType());
+      } else if (auto *EV{dyn_cast<ExtractValueInst>(&I)}) {
+        Hash.update(EV->getIndices());
+      } else if (auto *IV{dyn_cast<InsertValueInst>(&I)}) {
+        Hash.update(IV->getIndices());
+      } else if (auto *SV{dyn_cast<ShuffleVectorInst>(&I)}) {
+        Hash.update(SV->getShuffleMask());
+      }
+      I.getAllMetadata(MDs);
+      Hash.update(MDs.size());
+      for (auto &MD : MDs) {
+        Hash.update(MD.first);
+        Hash.update(MD.second);
+      }
+    }
+  }
+  return Hash.final();
+}
+
+bool FunctionFingerprintMap::isUnchanged(
+    const Function &F, const FunctionFingerprint &Fingerprint) const {
+  auto I{mFunctions.find(&F)};
+  return I != mFunctions.end() && I->second->IsValid &&
+         I->second->Fingerprint == Fingerprint;
+}
+
+void FunctionFingerprintMap::insert(Function &F,
+                                    const FunctionFingerprint &Fingerprint,
+                                    FunctionFingerprintMap *Prev) {
+  if (Prev && Prev->isUnchanged(F, Fingerprint)) {
+    auto I{Prev->mFunctions.find(&F)};
+    mFunctions[&F] = std::move(I->second);
+    Prev->mFunctions.erase(I);
+    return;
+  }
+  auto &Info{mFunctions[&F]};
+  Info = std::make_unique<FunctionInfo>();
+  Info->Fingerprint = Fingerprint;
+  Info->Values.reserve(1 + F.arg_size() + F.size() + F.getInstructionCount());
+  Info->Values.emplace_back(&F, Info->IsValid);
+  for (auto &A : F.args())
+    Info->Values.emplace_back(&A, Info->IsValid);
+  for (auto &BB : F) {
+    Info->Values.emplace_back(&BB, Info->IsValid);
+    for (auto &I : BB)
+      Info->Values.emplace_back(&I, Info->IsValid);
+  }
+}
+
 llvm::Type *getPointerElementType(const llvm::Value &V) {
   if (!llvm::isa<llvm::PointerType>(V.getType()))
     return nullptr;
@@ -0,0 +1,176 @@
+//===- IntegerSystem.cpp ---- Integer System Benchmark ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This benchmark checks the exact integer test (see IntegerSystem) against
+// brute-force enumeration of integer points and measures the time of the
+// test.
+//
+// Random systems have 1-3 variables bounded by [0, MaxBound] and up to
+// 5 additional equalities and inequalities with small coefficients. So,
+// the enumeration is cheap and it gives the expected result. The exit code
+// is not zero if the test disagrees with the enumeration.
+//
+//===----------------------------------------------------------------------===//
+
+#include <tsar/Support/IntegerSystem.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+using CoefficientT = IntegerSystem::CoefficientT;
+
+/// Maximum upper bound of a variable.
+constexpr CoefficientT MaxBound = 6;
+
+/// Constraint which is stored to evaluate it at enumerated points.
+struct BenchConstraint {
+  std::vector<CoefficientT> Coeffs;
+  CoefficientT Const;
+  bool IsEquality;
+};
+
+struct BenchSystem {
+  explicit BenchSystem(unsigned NumVars) : System(NumVars) {}
+  IntegerSystem System;
+  std::vector<BenchConstraint> Constraints;
+};
+
+BenchSystem generate(std::mt19937 &Rng) {
+  unsigned NumVars = 1 + Rng() % 3;
+  BenchSystem S(NumVars);
+  for (unsigned Var = 0; Var < NumVars; ++Var) {
+    CoefficientT UB = Rng() % (MaxBound + 1);
+    S.System.addBounds(Var, 0, UB);
+    std::vector<CoefficientT> Coeffs(NumVars, 0);
+    Coeffs[Var] = 1;
+    S.Constraints.push_back({Coeffs, 0, false});
+    Coeffs[Var] = -1;
+    S.Constraints.push_back({Coeffs, UB, false});
+  }
+  unsigned NumConstraints = Rng() % 6;
+  for (unsigned I = 0; I < NumConstraints; ++I) {
+    std::vector<CoefficientT> Coeffs(NumVars);
+    for (auto &C : Coeffs)
+      C = CoefficientT(Rng() % 19) - 9;
+    CoefficientT Const = CoefficientT(Rng() % 21) - 10;
+    bool IsEquality = Rng() % 2;
+    if (IsEquality)
+      S.System.addEquality(Coeffs, Const);
+    else
+      S.System.addInequality(Coeffs, Const);
+    S.Constraints.push_back({std::move(Coeffs), Const, IsEquality});
+  }
+  return S;
+}
+
+bool isSatisfied(const BenchSystem &S, const std::vector<CoefficientT> &X) {
+  for (auto &C : S.Constraints) {
+    CoefficientT Sum = C.Const;
+    for (unsigned Var = 0, EVar = X.size(); Var < EVar; ++Var)
+      Sum += C.Coeffs[Var] * X[Var];
+    if (C.IsEquality ? Sum != 0 : Sum < 0)
+      return false;
+  }
+  return true;
+}
+
+/// Enumerate all points in [0, MaxBound]^N.
+bool isFeasibleBruteForce(const BenchSystem &S) {
+  std::vector<CoefficientT> X(S.System.getNumVars(), 0);
+  for (;;) {
+    if (isSatisfied(S, X))
+      return true;
+    unsigned Var = 0;
+    for (; Var < X.size() && X[Var] == MaxBound; ++Var)
+      X[Var] = 0;
+    if (Var == X.size())
+      return false;
+    ++X[Var];
+  }
+}
+
+unsigned run(std::size_t Size, unsigned Seed, unsigned Budget) {
+  std::mt19937 Rng(Seed);
+  std::vector<BenchSystem> Systems;
+  Systems.reserve(Size);
+  for (std::size_t I = 0; I < Size; ++I)
+    Systems.push_back(generate(Rng));
+  std::vector<IntegerSystem::FeasibilityKind> Results(Size);
+  auto StartTime = std::chrono::steady_clock::now();
+  for (std::size_t I = 0; I < Size; ++I) {
+    unsigned RemainingBudget = Budget;
+    Results[I] = Systems[I].System.isFeasible(RemainingBudget);
+  }
+  auto Time = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - StartTime).count();
+  unsigned NumMismatches = 0, NumUnknown = 0, NumFeasible = 0;
+  for (std::size_t I = 0; I < Size; ++I) {
+    if (Results[I] == IntegerSystem::Unknown) {
+      ++NumUnknown;
+      continue;
+    }
+    bool IsFeasible = isFeasibleBruteForce(Systems[I]);
+    NumFeasible += IsFeasible;
+    if (IsFeasible == (Results[I] == IntegerSystem::Feasible))
+      continue;
+    if (NumMismatches++ < 5) {
+      outs() << "mismatch: expected "
+             << (IsFeasible ? "feasible" : "infeasible") << " system\n";
+      Systems[I].System.print(outs());
+    }
+  }
+  outs() << "number of systems: " << Size << "\n";
+  outs() << "  feasible: " << NumFeasible << "\n";
+  outs() << "  unknown: " << NumUnknown << "\n";
+  outs() << "  mismatches: " << NumMismatches << "\n";
+  outs() << "time of exact test: " << Time << " us\n";
+  return NumMismatches;
+}
+}
+
+int main(int Argc, const char **Argv) {
+  std::string Help =
+    "parameter: <number of systems> [seed] [budget]\n";
+  if (Argc < 2) {
+    errs() << "error: too few arguments\n" << Help;
+    return 1;
+  } else if (Argc > 4) {
+    errs() << "error: too many arguments\n" << Help;
+    return 2;
+  }
+  std::size_t Size = std::atoll(Argv[1]);
+  unsigned Seed = (Argc > 2) ? std::atoi(Argv[2]) : 42;
+  unsigned Budget = (Argc > 3) ? std::atoi(Argv[3]) : 100000;
+  if (Size == 0) {
+    errs() << "error: invalid number of systems\n" << Help;
+    return 3;
+  }
+  if (Budget == 0) {
+    errs() << "error: invalid budget\n" << Help;
+    return 4;
+  }
+  return run(Size, Seed, Budget) == 0 ? 0 : 5;
+}
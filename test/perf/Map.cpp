@@ -23,8 +23,14 @@
 //===----------------------------------------------------------------------===//
 
 #include <tsar/Core/tsar-config.h>
+#include <tsar/ADT/PersistentIteratorInfo.h>
 #include <tsar/ADT/PersistentMap.h>
+#include <tsar/ADT/SlabPersistentMap.h>
 #include <tsar/ADT/Bimap.h>
+#include <tsar/ADT/FlatBimap.h>
+#include <tsar/ADT/FlatListBimap.h>
+#include <tsar/ADT/ListBimap.h>
+#include <llvm/ADT/DenseSet.h>
 #include <llvm/Config/llvm-config.h>
 #include <llvm/Support/raw_ostream.h>
 #include <chrono>
@@ -162,7 +168,7 @@ void accumulateDataSet(unsigned AccumulateMaxIter, const DataSetT &D,
 #define ACCUMULATE_TIME(accumulate_, find_) \
 template<class MapT> TimeT accumulate_##Time(unsigned AccumulateMaxIter, \
     std::size_t Size, const MapT &M, AccumulateDataT &Sum) { \
-  TimeT Find; \
+  TimeT Find(0); \
   AccumulateDataT Tmp{ 0 }; \
   for (unsigned J = 0; J < AccumulateMaxIter; ++J) \
     Find += find_##Time(Size, M, Tmp); \
@@ -174,16 +180,112 @@ ACCUMULATE_TIME(accumulate, find)
 ACCUMULATE_TIME(accumulate_first, find_first)
 ACCUMULATE_TIME(accumulate_second, find_second)
 
+/// Measure a map of lists, keys are addresses of elements in a storage.
+template<class MapT> void measureListBimap(const DataSetT &D,
+    const std::vector<KeyT> &Storage, unsigned AccumulateMaxIter,
+    TimeT &Emplace, TimeT &Find, TimeT &Erase, AccumulateDataT &Sum) {
+  MapT M;
+  auto Start = std::chrono::high_resolution_clock::now();
+  for (std::size_t I = 0, EI = D.size(); I < EI; ++I)
+    M.emplace(TinyPtrVector<const KeyT *>(&Storage[D[I]]),
+              TinyPtrVector<const KeyT *>(&Storage[D[I]]));
+  auto End = std::chrono::high_resolution_clock::now();
+  Emplace += End - Start;
+  Start = End;
+  AccumulateDataT Tmp{ 0 };
+  for (unsigned J = 0; J < AccumulateMaxIter; ++J)
+    for (std::size_t I = 0, EI = D.size(); I < EI; ++I) {
+      auto Itr = M.find_first(&Storage[I]);
+      if (Itr != M.end())
+        Tmp += *Itr->first.front();
+    }
+  Sum += Tmp / AccumulateMaxIter;
+  End = std::chrono::high_resolution_clock::now();
+  Find += End - Start;
+  Start = End;
+  for (std::size_t I = 0, EI = D.size(); I < EI; ++I)
+    M.erase_second(&Storage[I]);
+  End = std::chrono::high_resolution_clock::now();
+  Erase += End - Start;
+}
+
+/// \brief Measure a pool of traits similar to DIMemoryTraitRegionPool.
+///
+/// Keys are addresses of memory locations in a storage. Persistent references
+/// to traits are grouped into sets which are similar to DIAliasTrait, so
+/// references are hashed by a referenced location (see
+/// DIMTraitPersistentSetInfo). References are created while the pool grows.
+/// At the end, a half of locations are removed from the pool and remaining
+/// valid references are counted.
+template<class PoolT> void measureTraitPool(const DataSetT &D,
+    const std::vector<KeyT> &Storage, unsigned AccumulateMaxIter,
+    TimeT &Build, TimeT &Access, TimeT &Erase, AccumulateDataT &Sum) {
+  using RefT = typename PoolT::persistent_iterator;
+  struct RefInfo {
+    static inline RefT getEmptyKey() {
+      return DenseMapInfo<RefT>::getEmptyKey();
+    }
+    static inline RefT getTombstoneKey() {
+      return DenseMapInfo<RefT>::getTombstoneKey();
+    }
+    static unsigned getHashValue(const RefT &Val) {
+      return DenseMapInfo<const KeyT *>::getHashValue(Val->getFirst());
+    }
+    static bool isEqual(const RefT &LHS, const RefT &RHS) {
+      return LHS == RHS;
+    }
+  };
+  // Average number of memory locations in an alias node.
+  constexpr std::size_t NodeSize = 4;
+  PoolT Pool;
+  std::vector<DenseSet<RefT, RefInfo>> Nodes((D.size() + NodeSize - 1) /
+                                             NodeSize);
+  auto Start = std::chrono::high_resolution_clock::now();
+  for (std::size_t I = 0, EI = D.size(); I < EI; ++I)
+    Nodes[I / NodeSize].insert(
+      Pool.try_emplace(&Storage[D[I]], D[I]).first);
+  auto End = std::chrono::high_resolution_clock::now();
+  Build += End - Start;
+  Start = End;
+  AccumulateDataT Tmp{ 0 };
+  for (unsigned J = 0; J < AccumulateMaxIter; ++J)
+    for (auto &N : Nodes)
+      for (auto &Ref : N)
+        Tmp += Ref->getSecond();
+  Sum += Tmp / AccumulateMaxIter;
+  End = std::chrono::high_resolution_clock::now();
+  Access += End - Start;
+  Start = End;
+  for (std::size_t I = 0, EI = D.size(); I < EI; I += 2)
+    Pool.erase(&Storage[I]);
+  for (auto &N : Nodes)
+    for (auto &Ref : N)
+      Sum += Ref ? 1 : 0;
+  Nodes.clear();
+  End = std::chrono::high_resolution_clock::now();
+  Erase += End - Start;
+}
+
 void run(std::size_t Size,
     unsigned MaxIter = 5, unsigned AccumulateMaxIter = 10) {
   TimeT EmplaceSM(0), TryEmplacePM(0), TryEmplacePMP(0), TryEmplaceDM(0),
-    EmplaceSUM(0), EmplaceBM(0);
+    EmplaceSUM(0), EmplaceBM(0), EmplaceFBM(0), EmplaceLBM(0), EmplaceFLBM(0),
+    TryEmplaceSPM(0), TryEmplaceSPMP(0);
   TimeT EraseSM(0), ErasePM(0), ErasePMP(0), EraseDM(0),
-    EraseSUM(0), EraseBM(0);
-  TimeT FindSM(0), FindPM(0), FindPMP(0), FindDM(0), FindSUM(0), FindBM(0);
+    EraseSUM(0), EraseBM(0), EraseFBM(0), EraseLBM(0), EraseFLBM(0),
+    EraseSPM(0), EraseSPMP(0);
+  TimeT FindSM(0), FindPM(0), FindPMP(0), FindDM(0), FindSUM(0), FindBM(0),
+    FindFBM(0), FindLBM(0), FindFLBM(0), FindSPM(0), FindSPMP(0);
+  TimeT BuildTP(0), AccessTP(0), EraseTP(0);
+  TimeT BuildSTP(0), AccessSTP(0), EraseSTP(0);
   AccumulateDataT Sum{ 0 }, SumSM{ 0 }, SumPM{ 0 }, SumPMP{ 0 }, SumDM{ 0 };
-  AccumulateDataT SumSUM{ 0 }, SumBM{ 0 };
+  AccumulateDataT SumSUM{ 0 }, SumBM{ 0 }, SumFBM{ 0 };
+  AccumulateDataT SumLBM{ 0 }, SumFLBM{ 0 };
+  AccumulateDataT SumSPM{ 0 }, SumSPMP{ 0 }, SumTP{ 0 }, SumSTP{ 0 };
   auto Data = initializeDataSet(Size);
+  std::vector<KeyT> Storage(Size);
+  for (std::size_t I = 0; I < Size; ++I)
+    Storage[I] = initializeData(I);
   accumulateDataSet(AccumulateMaxIter, Data, Sum);
   Sum *= MaxIter;
   Sum += AccumulateMaxIter * MaxIter * Size;
@@ -209,6 +311,17 @@ void run(std::size_t Size,
       SumBM += BML.size();
       EraseBM += erase_firstTime(Size, BM);
       BML.clear();
+      FlatBimap<KeyT, ValueT, MapInfo<KeyT>, MapInfo<ValueT>> FBM;
+      std::vector<decltype(FBM)::iterator> FBML;
+      EmplaceFBM += emplaceTime(AccumulateMaxIter, Data, FBM, FBML);
+      FindFBM += accumulate_firstTime(AccumulateMaxIter, Size, FBM, SumFBM);
+      SumFBM += FBML.size();
+      EraseFBM += erase_firstTime(Size, FBM);
+      FBML.clear();
+      measureListBimap<ListBimap<const KeyT *, const KeyT *>>(Data, Storage,
+        AccumulateMaxIter, EmplaceLBM, FindLBM, EraseLBM, SumLBM);
+      measureListBimap<FlatListBimap<const KeyT *, const KeyT *>>(Data,
+        Storage, AccumulateMaxIter, EmplaceFLBM, FindFLBM, EraseFLBM, SumFLBM);
       PersistentMap<KeyT, ValueT, MapInfo<KeyT>> PM;
       std::vector<decltype(PM)::iterator> PML;
       TryEmplacePM += try_emplaceTime(AccumulateMaxIter, Data, PM, PML);
@@ -223,6 +336,24 @@ void run(std::size_t Size,
       SumPMP += PMPL.size();
       ErasePMP += eraseTime(Size, PMP);
       PMPL.clear();
+      SlabPersistentMap<KeyT, ValueT, MapInfo<KeyT>> SPM;
+      std::vector<decltype(SPM)::iterator> SPML;
+      TryEmplaceSPM += try_emplaceTime(AccumulateMaxIter, Data, SPM, SPML);
+      FindSPM += accumulateTime(AccumulateMaxIter, Size, SPM, SumSPM);
+      SumSPM += SPML.size();
+      EraseSPM += eraseTime(Size, SPM);
+      SPML.clear();
+      SlabPersistentMap<KeyT, ValueT, MapInfo<KeyT>> SPMP;
+      std::vector<decltype(SPMP)::persistent_iterator> SPMPL;
+      TryEmplaceSPMP += try_emplaceTime(AccumulateMaxIter, Data, SPMP, SPMPL);
+      FindSPMP += accumulateTime(AccumulateMaxIter, Size, SPMP, SumSPMP);
+      SumSPMP += SPMPL.size();
+      EraseSPMP += eraseTime(Size, SPMP);
+      SPMPL.clear();
+      measureTraitPool<PersistentMap<const KeyT *, ValueT>>(Data, Storage,
+        AccumulateMaxIter, BuildTP, AccessTP, EraseTP, SumTP);
+      measureTraitPool<SlabPersistentMap<const KeyT *, ValueT>>(Data, Storage,
+        AccumulateMaxIter, BuildSTP, AccessSTP, EraseSTP, SumSTP);
       DenseMap<KeyT, ValueT, MapInfo<KeyT>> DM;
       std::vector<decltype(DM)::iterator> DML;
       TryEmplaceDM += try_emplaceTime(AccumulateMaxIter, Data, DM, DML);
@@ -280,11 +411,41 @@ void run(std::size_t Size,
   else
     outs() << "  tsar::PersistentMap accumulated sum is NOT correct (difference "
       << (Sum > SumPMP ? Sum - SumPMP : SumPMP - Sum) << ")\n";
+  if (SumSPM == Sum)
+    outs() << "  tsar::SlabPersistentMap (without persistent) accumulated sum"
+      " is correct\n";
+  else
+    outs() << "  tsar::SlabPersistentMap (without persistent) accumulated sum"
+      " is NOT correct (difference "
+      << (Sum > SumSPM ? Sum - SumSPM : SumSPM - Sum) << ")\n";
+  if (SumSPMP == Sum)
+    outs() << "  tsar::SlabPersistentMap accumulated sum is correct\n";
+  else
+    outs() << "  tsar::SlabPersistentMap accumulated sum is NOT correct"
+      " (difference " << (Sum > SumSPMP ? Sum - SumSPMP : SumSPMP - Sum)
+      << ")\n";
+  if (SumTP == SumSTP)
+    outs() << "  tsar::PersistentMap and tsar::SlabPersistentMap trait pool"
+      " sums are equal\n";
+  else
+    outs() << "  tsar::PersistentMap and tsar::SlabPersistentMap trait pool"
+      " sums are NOT equal\n";
   if (SumBM == Sum)
     outs() << "  tsar::Bimap accumulated sum is correct\n";
   else
     outs() << "  tsar::Bimap accumulated sum is NOT correct (difference "
       << (SumBM > Sum ? Sum - SumBM : SumBM - Sum) << ")\n";
+  if (SumFBM == Sum)
+    outs() << "  tsar::FlatBimap accumulated sum is correct\n";
+  else
+    outs() << "  tsar::FlatBimap accumulated sum is NOT correct (difference "
+      << (Sum > SumFBM ? Sum - SumFBM : SumFBM - Sum) << ")\n";
+  if (SumLBM == SumFLBM)
+    outs() << "  tsar::ListBimap and tsar::FlatListBimap accumulated sums are"
+      " equal\n";
+  else
+    outs() << "  tsar::ListBimap and tsar::FlatListBimap accumulated sums are"
+      " NOT equal\n";
   outs() << "\n";
   std::map<double, std::string> Time;
   Time.emplace((EmplaceSM / MaxIter).count(),
@@ -297,8 +458,18 @@ void run(std::size_t Size,
     "  tsar::PersistentMap (without persistent) try_emplace() time (.s) ");
   Time.emplace((TryEmplacePMP / MaxIter).count(),
     "  tsar::PersistentMap try_emplace() time (.s) ");
+  Time.emplace((TryEmplaceSPM / MaxIter).count(),
+    "  tsar::SlabPersistentMap (without persistent) try_emplace() time (.s) ");
+  Time.emplace((TryEmplaceSPMP / MaxIter).count(),
+    "  tsar::SlabPersistentMap try_emplace() time (.s) ");
   Time.emplace((EmplaceBM / MaxIter).count(),
     "  tsar::Bimap emplace() time (.s) ");
+  Time.emplace((EmplaceFBM / MaxIter).count(),
+    "  tsar::FlatBimap emplace() time (.s) ");
+  Time.emplace((EmplaceLBM / MaxIter).count(),
+    "  tsar::ListBimap emplace() time (.s) ");
+  Time.emplace((EmplaceFLBM / MaxIter).count(),
+    "  tsar::FlatListBimap emplace() time (.s) ");
   for (auto &T : Time)
     outs() << T.second << T.first << "\n";
   outs() << "\n";
@@ -313,8 +484,18 @@ void run(std::size_t Size,
     "  tsar::PersistentMap (without persistent) find() time (.s) ");
   Time.emplace((FindPMP / MaxIter).count(),
     "  tsar::PersistentMap find() time (.s) ");
+  Time.emplace((FindSPM / MaxIter).count(),
+    "  tsar::SlabPersistentMap (without persistent) find() time (.s) ");
+  Time.emplace((FindSPMP / MaxIter).count(),
+    "  tsar::SlabPersistentMap find() time (.s) ");
   Time.emplace((FindBM / MaxIter).count(),
     "  tsar::Bimap find_first() time (.s) ");
+  Time.emplace((FindFBM / MaxIter).count(),
+    "  tsar::FlatBimap find_first() time (.s) ");
+  Time.emplace((FindLBM / MaxIter).count(),
+    "  tsar::ListBimap find_first() time (.s) ");
+  Time.emplace((FindFLBM / MaxIter).count(),
+    "  tsar::FlatListBimap find_first() time (.s) ");
   for (auto &T : Time)
     outs() << T.second << T.first << "\n";
   outs() << "\n";
@@ -329,10 +510,33 @@ void run(std::size_t Size,
     "  tsar::PersistentMap (without persistent) erase() time (.s) ");
   Time.emplace((ErasePMP / MaxIter).count(),
     "  tsar::PersistentMap erase() time (.s) ");
+  Time.emplace((EraseSPM / MaxIter).count(),
+    "  tsar::SlabPersistentMap (without persistent) erase() time (.s) ");
+  Time.emplace((EraseSPMP / MaxIter).count(),
+    "  tsar::SlabPersistentMap erase() time (.s) ");
   Time.emplace((EraseBM / MaxIter).count(),
     "  tsar::Bimap erase_first() time (.s) ");
+  Time.emplace((EraseFBM / MaxIter).count(),
+    "  tsar::FlatBimap erase_first() time (.s) ");
+  Time.emplace((EraseLBM / MaxIter).count(),
+    "  tsar::ListBimap erase_second() time (.s) ");
+  Time.emplace((EraseFLBM / MaxIter).count(),
+    "  tsar::FlatListBimap erase_second() time (.s) ");
   for (auto &T : Time)
     outs() << T.second << T.first << "\n";
+  outs() << "\n";
+  outs() << "  trait pool, tsar::PersistentMap build time (.s) "
+         << (BuildTP / MaxIter).count() << "\n";
+  outs() << "  trait pool, tsar::PersistentMap access time (.s) "
+         << (AccessTP / MaxIter).count() << "\n";
+  outs() << "  trait pool, tsar::PersistentMap erase time (.s) "
+         << (EraseTP / MaxIter).count() << "\n";
+  outs() << "  trait pool, tsar::SlabPersistentMap build time (.s) "
+         << (BuildSTP / MaxIter).count() << "\n";
+  outs() << "  trait pool, tsar::SlabPersistentMap access time (.s) "
+         << (AccessSTP / MaxIter).count() << "\n";
+  outs() << "  trait pool, tsar::SlabPersistentMap erase time (.s) "
+         << (EraseSTP / MaxIter).count() << "\n";
 }
 
 int main(int Argc, const char **Argv) {
@@ -0,0 +1,264 @@
+//===- MemorySet.cpp ---------- Memory Set Benchmark ------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This benchmark compares range queries in a set of memory locations with
+// and without interval index of locations (see MemorySetIndex).
+//
+// Locations are ranges [Lower, Upper) which have the same base pointer.
+// Scalar locations (byte ranges) and collapsed locations (ranges of indexes
+// in the first dimension of an array) are measured separately.
+//
+//===----------------------------------------------------------------------===//
+
+#include <tsar/Analysis/Memory/MemorySet.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+struct BenchLocation {
+  const Value *Ptr = nullptr;
+  uint64_t Lower = 0;
+  uint64_t Upper = 0;
+  bool IsCollapsed = false;
+  AAMDNodes AATags;
+};
+
+/// Traits for locations in a set, if `HasIndex` is false
+/// the index is never used.
+template<bool HasIndex> struct BenchInfo {
+  static const Value * getPtr(const BenchLocation &Loc) { return Loc.Ptr; }
+  static uint64_t getLowerBound(const BenchLocation &Loc) { return Loc.Lower; }
+  static uint64_t getUpperBound(const BenchLocation &Loc) { return Loc.Upper; }
+  static void setLowerBound(uint64_t Size, BenchLocation &Loc) {
+    Loc.Lower = Size;
+  }
+  static void setUpperBound(uint64_t Size, BenchLocation &Loc) {
+    Loc.Upper = Size;
+  }
+  static int8_t sizecmp(uint64_t LHS, uint64_t RHS) {
+    return LHS < RHS ? -1 : LHS == RHS ? 0 : 1;
+  }
+  static const AAMDNodes & getAATags(const BenchLocation &Loc) {
+    return Loc.AATags;
+  }
+  static void setAATags(const AAMDNodes &AATags, BenchLocation &Loc) {
+    Loc.AATags = AATags;
+  }
+  static BenchLocation make(const BenchLocation &Loc) { return Loc; }
+  static uint64_t getNumDims(const BenchLocation &Loc) {
+    return Loc.IsCollapsed ? 1 : 0;
+  }
+  static bool areJoinable(const BenchLocation &LHS, const BenchLocation &RHS) {
+    return LHS.IsCollapsed == RHS.IsCollapsed && LHS.Upper >= RHS.Lower &&
+           LHS.Lower <= RHS.Upper;
+  }
+  static bool join(const BenchLocation &What, BenchLocation &To) {
+    bool IsChanged = false;
+    if (To.Upper < What.Upper) {
+      To.Upper = What.Upper;
+      IsChanged = true;
+    }
+    if (To.Lower > What.Lower) {
+      To.Lower = What.Lower;
+      IsChanged = true;
+    }
+    return IsChanged;
+  }
+  static Optional<BenchLocation> intersect(const BenchLocation &LHS,
+      const BenchLocation &RHS, SmallVectorImpl<BenchLocation> *L = nullptr,
+      SmallVectorImpl<BenchLocation> *R = nullptr) {
+    assert(LHS.IsCollapsed == RHS.IsCollapsed && "Unsupported locations!");
+    if (LHS.Upper <= RHS.Lower || LHS.Lower >= RHS.Upper)
+      return None;
+    BenchLocation Int(LHS);
+    Int.Lower = std::max(LHS.Lower, RHS.Lower);
+    Int.Upper = std::min(LHS.Upper, RHS.Upper);
+    if (L) {
+      if (LHS.Lower < Int.Lower)
+        L->push_back(LHS), L->back().Upper = Int.Lower;
+      if (LHS.Upper > Int.Upper)
+        L->push_back(LHS), L->back().Lower = Int.Upper;
+    }
+    if (R) {
+      if (RHS.Lower < Int.Lower)
+        R->push_back(RHS), R->back().Upper = Int.Lower;
+      if (RHS.Upper > Int.Upper)
+        R->push_back(RHS), R->back().Lower = Int.Upper;
+    }
+    return Int;
+  }
+  static bool hasIntersection(const BenchLocation &LHS,
+                              const BenchLocation &RHS) {
+    return intersect(LHS, RHS).hasValue();
+  }
+  static void setNonCollapsable(BenchLocation &) {}
+  static MemoryInterval getInterval(const BenchLocation &Loc) {
+    if (!HasIndex)
+      return MemoryInterval();
+    return Loc.IsCollapsed ?
+      MemoryInterval::getCollapsed(1, 0, Loc.Lower, Loc.Upper) :
+      MemoryInterval::getScalar(Loc.Lower, Loc.Upper);
+  }
+};
+
+using TimeT = std::chrono::duration<double>;
+using DataSetT = std::vector<BenchLocation>;
+
+/// Build a list of locations which can not be joined.
+DataSetT initializeDataSet(std::size_t Size, bool IsCollapsed) {
+  auto *Ptr = reinterpret_cast<const Value *>(alignof(Value));
+  DataSetT Data(Size);
+  for (std::size_t I = 0; I < Size; ++I) {
+    Data[I].Ptr = Ptr;
+    Data[I].Lower = I * 16;
+    Data[I].Upper = I * 16 + 4 + std::rand() % 8;
+    Data[I].IsCollapsed = IsCollapsed;
+  }
+  // Mix up a set of data.
+  for (std::size_t I = 0; I < Size; ++I)
+    std::swap(Data[I], Data[std::rand() % Size]);
+  return Data;
+}
+
+/// Build a list of queries, each query overlaps a few locations.
+DataSetT initializeQuerySet(std::size_t Size, std::size_t QuerySize,
+                            bool IsCollapsed) {
+  auto *Ptr = reinterpret_cast<const Value *>(alignof(Value));
+  DataSetT Data(QuerySize);
+  for (std::size_t I = 0; I < QuerySize; ++I) {
+    Data[I].Ptr = Ptr;
+    Data[I].Lower = std::rand() % (Size * 16);
+    Data[I].Upper = Data[I].Lower + 1 + std::rand() % 48;
+    Data[I].IsCollapsed = IsCollapsed;
+  }
+  return Data;
+}
+
+struct Result {
+  TimeT Insert{0};
+  TimeT Overlap{0};
+  TimeT Contain{0};
+  TimeT Subtract{0};
+  std::size_t Sum = 0;
+};
+
+template<class SetT>
+void measure(const DataSetT &D, const DataSetT &Q, Result &R) {
+  auto Start = std::chrono::high_resolution_clock::now();
+  SetT S;
+  for (auto &Loc : D)
+    S.insert(Loc);
+  auto End = std::chrono::high_resolution_clock::now();
+  R.Insert += End - Start;
+  Start = End;
+  for (auto &Loc : Q)
+    R.Sum += S.overlap(Loc);
+  End = std::chrono::high_resolution_clock::now();
+  R.Overlap += End - Start;
+  Start = End;
+  for (auto &Loc : Q) {
+    SmallVector<BenchLocation, 4> Locs;
+    R.Sum += S.findContaining(Loc, Locs);
+    R.Sum += Locs.size();
+  }
+  End = std::chrono::high_resolution_clock::now();
+  R.Contain += End - Start;
+  Start = End;
+  for (auto &Loc : Q) {
+    SmallVector<BenchLocation, 4> Locs;
+    R.Sum += S.subtractFrom(Loc, Locs);
+    R.Sum += Locs.size();
+  }
+  End = std::chrono::high_resolution_clock::now();
+  R.Subtract += End - Start;
+}
+
+void print(StringRef Name, const Result &R, unsigned MaxIter) {
+  outs() << "  " << Name << " insert() time (.s) "
+         << (R.Insert / MaxIter).count() << "\n";
+  outs() << "  " << Name << " overlap() time (.s) "
+         << (R.Overlap / MaxIter).count() << "\n";
+  outs() << "  " << Name << " findContaining() time (.s) "
+         << (R.Contain / MaxIter).count() << "\n";
+  outs() << "  " << Name << " subtractFrom() time (.s) "
+         << (R.Subtract / MaxIter).count() << "\n";
+}
+
+void run(std::size_t Size, std::size_t QuerySize, unsigned MaxIter) {
+  outs() << "Parameters:\n";
+  outs() << "  number of locations " << Size << "\n";
+  outs() << "  number of queries " << QuerySize << "\n";
+  outs() << "  number of iterations " << MaxIter << "\n";
+  for (bool IsCollapsed : {false, true}) {
+    Result Linear, Indexed;
+    for (unsigned I = 0; I < MaxIter; ++I) {
+      auto D = initializeDataSet(Size, IsCollapsed);
+      auto Q = initializeQuerySet(Size, QuerySize, IsCollapsed);
+      measure<MemorySet<BenchLocation, BenchInfo<false>>>(D, Q, Linear);
+      measure<MemorySet<BenchLocation, BenchInfo<true>>>(D, Q, Indexed);
+    }
+    outs() << "\n";
+    outs() << (IsCollapsed ? "Collapsed locations:\n" : "Scalar locations:\n");
+    if (Linear.Sum == Indexed.Sum)
+      outs() << "  results of queries are equal\n";
+    else
+      outs() << "  results of queries are NOT equal\n";
+    outs() << "\n";
+    print("linear scan", Linear, MaxIter);
+    outs() << "\n";
+    print("interval index", Indexed, MaxIter);
+  }
+}
+}
+
+int main(int Argc, const char **Argv) {
+  std::string Help =
+    "parameter: <number of locations> [number of queries]"
+    "[number of iterations]\n";
+  if (Argc < 2) {
+    errs() << "error: too few arguments\n" << Help;
+    return 1;
+  } else if (Argc > 4) {
+    errs() << "error: too many arguments\n" << Help;
+    return 2;
+  }
+  std::size_t Size = std::atoll(Argv[1]);
+  std::size_t QuerySize = (Argc > 2) ? std::atoll(Argv[2]) : 10000;
+  unsigned MaxIter = (Argc > 3) ? std::atoi(Argv[3]) : 10;
+  if (Size == 0) {
+    errs() << "error: invalid number of locations\n" << Help;
+    return 3;
+  }
+  if (QuerySize == 0) {
+    errs() << "error: invalid number of queries\n" << Help;
+    return 4;
+  }
+  if (MaxIter == 0) {
+    errs() << "error: invalid number of iterations\n" << Help;
+    return 5;
+  }
+  run(Size, QuerySize, MaxIter);
+  return 0;
+}
@@ -0,0 +1,510 @@
+//===- Pipeline.cpp ------ Analysis Pipeline Benchmark ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This benchmark runs the whole analysis pipeline on a set of built-in C
+// kernels and measures time of separate stages of analysis. Results are
+// written in JSON format which is similar to the format of Google Benchmark
+// (--benchmark_format=json), so they can be compared between different
+// versions of the analyzer.
+//
+// Time of stages is obtained from timers of the legacy pass manager, so
+// analysis passes which are implicitly scheduled as dependencies of other
+// passes are also taken into account.
+//
+//===----------------------------------------------------------------------===//
+
+#include <tsar/Core/tsar-config.h>
+#include <tsar/Core/Tool.h>
+#include <llvm/ADT/ArrayRef.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/Chrono.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/FormatVariadic.h>
+#include <llvm/Support/Host.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/ManagedStatic.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+/// Source code of a kernel to analyze.
+struct Kernel {
+  const char *Name;
+  const char *Source;
+};
+
+/// Kernels which cover typical patterns of memory accesses.
+const Kernel Kernels[] = {
+  {"stencil", R"(
+#define N 256
+#define T 16
+double A[N][N], B[N][N];
+
+void jacobi() {
+  for (int t = 0; t < T; ++t) {
+    for (int i = 1; i < N - 1; ++i)
+      for (int j = 1; j < N - 1; ++j)
+        B[i][j] =
+            0.25 * (A[i - 1][j] + A[i + 1][j] + A[i][j - 1] + A[i][j + 1]);
+    for (int i = 1; i < N - 1; ++i)
+      for (int j = 1; j < N - 1; ++j)
+        A[i][j] = B[i][j];
+  }
+}
+
+int main() {
+  for (int i = 0; i < N; ++i)
+    for (int j = 0; j < N; ++j)
+      A[i][j] = B[i][j] = (i * (j + 2)) / N;
+  jacobi();
+  return A[N / 2][N / 2] > 0;
+}
+)"},
+  {"spmv", R"(
+#define NR 1024
+#define NNZ 8
+int RowPtr[NR + 1], Col[NR * NNZ];
+double Val[NR * NNZ], X[NR], Y[NR];
+
+void spmv(int NRows, const int *RowPtr, const int *Col, const double *Val,
+          const double *X, double *Y) {
+  for (int I = 0; I < NRows; ++I) {
+    double S = 0.0;
+    for (int K = RowPtr[I]; K < RowPtr[I + 1]; ++K)
+      S += Val[K] * X[Col[K]];
+    Y[I] = S;
+  }
+}
+
+int main() {
+  for (int I = 0; I < NR; ++I) {
+    RowPtr[I] = I * NNZ;
+    X[I] = I;
+    for (int K = 0; K < NNZ; ++K) {
+      Col[I * NNZ + K] = (I + K * 31) % NR;
+      Val[I * NNZ + K] = K + 1;
+    }
+  }
+  RowPtr[NR] = NR * NNZ;
+  spmv(NR, RowPtr, Col, Val, X, Y);
+  return Y[0] > 0;
+}
+)"},
+  {"reduction", R"(
+#define N 100000
+double A[N], B[N];
+
+double dot(int Size, const double *X, const double *Y) {
+  double S = 0.0;
+  for (int I = 0; I < Size; ++I)
+    S += X[I] * Y[I];
+  return S;
+}
+
+void minmax(int Size, const double *X, double *Min, double *Max) {
+  double L = X[0], H = X[0];
+  for (int I = 1; I < Size; ++I) {
+    if (X[I] < L)
+      L = X[I];
+    if (X[I] > H)
+      H = X[I];
+  }
+  *Min = L;
+  *Max = H;
+}
+
+int main() {
+  double Min, Max, Sum = 0.0;
+  for (int I = 0; I < N; ++I) {
+    A[I] = I % 17;
+    B[I] = I % 13;
+  }
+  for (int I = 0; I < N; ++I)
+    Sum += A[I];
+  minmax(N, A, &Min, &Max);
+  return dot(N, A, B) + Sum > Max - Min;
+}
+)"},
+  {"pointer", R"(
+#include <stdlib.h>
+
+struct Node {
+  double Value;
+  struct Node *Next;
+};
+
+struct Tree {
+  struct Tree *Left, *Right;
+  int Key;
+};
+
+struct Node * build(int Size) {
+  struct Node *Head = 0;
+  for (int I = 0; I < Size; ++I) {
+    struct Node *N = malloc(sizeof(struct Node));
+    N->Value = I;
+    N->Next = Head;
+    Head = N;
+  }
+  return Head;
+}
+
+void scale(struct Node *Head, double F) {
+  for (struct Node *N = Head; N; N = N->Next)
+    N->Value *= F;
+}
+
+double sum(struct Node *Head) {
+  double S = 0.0;
+  for (struct Node *N = Head; N; N = N->Next)
+    S += N->Value;
+  return S;
+}
+
+struct Tree * insert(struct Tree *T, int Key) {
+  if (!T) {
+    T = malloc(sizeof(struct Tree));
+    T->Left = T->Right = 0;
+    T->Key = Key;
+    return T;
+  }
+  if (Key < T->Key)
+    T->Left = insert(T->Left, Key);
+  else
+    T->Right = insert(T->Right, Key);
+  return T;
+}
+
+int count(struct Tree *T) {
+  return T ? count(T->Left) + count(T->Right) + 1 : 0;
+}
+
+int main() {
+  struct Node *List = build(1000);
+  struct Tree *Root = 0;
+  scale(List, 2.0);
+  for (struct Node *N = List; N; N = N->Next)
+    Root = insert(Root, (int)N->Value % 101);
+  return sum(List) > count(Root);
+}
+)"},
+  {"matmul", R"(
+#define N 128
+double A[N][N], B[N][N], C[N][N];
+
+void matmul() {
+  for (int I = 0; I < N; ++I)
+    for (int J = 0; J < N; ++J) {
+      double S = 0.0;
+      for (int K = 0; K < N; ++K)
+        S += A[I][K] * B[K][J];
+      C[I][J] = S;
+    }
+}
+
+void transpose() {
+  for (int I = 0; I < N; ++I)
+    for (int J = I + 1; J < N; ++J) {
+      double Tmp = C[I][J];
+      C[I][J] = C[J][I];
+      C[J][I] = Tmp;
+    }
+}
+
+int main() {
+  for (int I = 0; I < N; ++I)
+    for (int J = 0; J < N; ++J) {
+      A[I][J] = I + J;
+      B[I][J] = I - J;
+    }
+  matmul();
+  transpose();
+  return C[1][2] > 0;
+}
+)"}
+};
+
+/// Set of output passes which are executed after analysis.
+struct Configuration {
+  const char *Name;
+  std::vector<const char *> Args;
+};
+
+const Configuration Configurations[] = {
+  {"analysis", {}},
+  {"openmp", {"-clang-openmp-parallel"}},
+  {"dvmh", {"-clang-dvmh-sm-parallel"}}
+};
+
+/// Stage of analysis and a prefix of names of timers which measure it.
+///
+/// The legacy pass manager names timers according to pass arguments
+/// (time.pass.<argument>). Note, that DVMH writer is implicitly executed by
+/// DVMH-based parallelization.
+struct Stage {
+  const char *Name;
+  const char *Timer;
+};
+
+const Stage Stages[] = {
+  {"AliasTree", "time.pass.estimate-mem"},
+  {"DefinedMemory", "time.pass.def-mem"},
+  {"LiveMemory", "time.pass.live-mem"},
+  {"DependenceInfo::depends", "time.tsar-da.depends"},
+  {"PrivateRecognitionPass", "time.pass.private"},
+  {"DIDependencyAnalysisPass", "time.pass.da-di"},
+  {"ClangOpenMPParallelization", "time.pass.clang-openmp-parallel"},
+  {"ClangDVMHSMParallelization", "time.pass.clang-dvmh-sm-parallel"},
+  {"ClangDVMHWriter", "time.pass.clang-dvmh-writer"}
+};
+
+/// Wall and CPU time (in milliseconds) of a stage.
+struct StageTime {
+  double Real = 0;
+  double CPU = 0;
+};
+
+/// Return accumulated values of all triggered timers and reset timers.
+///
+/// Names of values look like time.<group>.<timer>.<wall|user|sys>. If there
+/// are multiple timers with the same name their values are summed up.
+StringMap<double> collectTimers() {
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  TimerGroup::printAllJSONValues(OS, "");
+  OS.flush();
+  TimerGroup::clearAll();
+  StringMap<double> Values;
+  SmallVector<StringRef, 64> Lines;
+  StringRef(Buffer).split(Lines, '\n', -1, false);
+  for (auto Line : Lines) {
+    auto KeyValue{Line.trim().rtrim(',').rsplit(':')};
+    auto Key{KeyValue.first.trim().trim('"')};
+    double Value;
+    if (!Key.empty() && !KeyValue.second.trim().getAsDouble(Value))
+      Values[Key] += Value;
+  }
+  return Values;
+}
+
+/// Return time of a stage which is measured by timers with a specified prefix.
+StageTime getStageTime(const StringMap<double> &Values, StringRef Timer) {
+  auto get = [&Values, Timer](StringRef Suffix) {
+    auto I{Values.find((Timer + Suffix).str())};
+    return I != Values.end() ? I->second * 1000 : 0.0;
+  };
+  return {get(".wall"), get(".user") + get(".sys")};
+}
+
+/// Analyze a specified file and return time of each stage or an empty list
+/// if analysis fails.
+std::vector<StageTime> runPipeline(StringRef ToolName, StringRef File,
+                                   const Configuration &Config) {
+  std::vector<std::string> ArgStorage{ToolName.str(), File.str(),
+                                      "-no-format",
+                                      std::string("-output-suffix=") +
+                                          Config.Name};
+  for (auto *Arg : Config.Args)
+    ArgStorage.emplace_back(Arg);
+  std::vector<const char *> Argv;
+  for (auto &Arg : ArgStorage)
+    Argv.push_back(Arg.c_str());
+  // Options which have been specified in the previous run are reset, so
+  // each run starts with default values of options.
+  cl::ResetAllOptionOccurrences();
+  Tool Analyzer(Argv.size(), Argv.data());
+  TimerGroup::clearAll();
+  TimePassesIsEnabled = true;
+  auto Start{std::chrono::steady_clock::now()};
+  sys::TimePoint<> Elapsed;
+  std::chrono::nanoseconds UserStart, SysStart;
+  sys::Process::GetTimeUsage(Elapsed, UserStart, SysStart);
+  auto Res{Analyzer.run()};
+  std::chrono::nanoseconds UserEnd, SysEnd;
+  sys::Process::GetTimeUsage(Elapsed, UserEnd, SysEnd);
+  std::chrono::duration<double, std::milli> Real{
+      std::chrono::steady_clock::now() - Start};
+  std::chrono::duration<double, std::milli> CPU{(UserEnd - UserStart) +
+                                                (SysEnd - SysStart)};
+  TimePassesIsEnabled = false;
+  auto Values{collectTimers()};
+  if (Res != 0)
+    return {};
+  std::vector<StageTime> Times;
+  for (auto &S : Stages)
+    Times.push_back(getStageTime(Values, S.Timer));
+  Times.push_back({Real.count(), CPU.count()});
+  return Times;
+}
+
+/// Emit results of a single run or an aggregate of runs in Google Benchmark
+/// format.
+void emitRun(json::OStream &J, StringRef Name, unsigned Repetitions,
+             StringRef RunType, StringRef Aggregate, unsigned Index,
+             const StageTime &T) {
+  J.object([&]() {
+    J.attribute("name", RunType == "aggregate"
+                            ? (Name + "_" + Aggregate).str()
+                            : Name.str());
+    J.attribute("run_name", Name);
+    J.attribute("run_type", RunType);
+    J.attribute("repetitions", static_cast<int64_t>(Repetitions));
+    if (RunType == "aggregate")
+      J.attribute("aggregate_name", Aggregate);
+    else
+      J.attribute("repetition_index", static_cast<int64_t>(Index));
+    J.attribute("threads", 1);
+    J.attribute("iterations", 1);
+    J.attribute("real_time", T.Real);
+    J.attribute("cpu_time", T.CPU);
+    J.attribute("time_unit", "ms");
+  });
+}
+
+int run(StringRef ToolName, unsigned Repetitions, raw_ostream &OS) {
+  SmallString<128> Dir;
+  if (auto EC{sys::fs::createUniqueDirectory("tsar-pipeline-perf", Dir)}) {
+    errs() << "error: unable to create temporary directory: " << EC.message()
+           << "\n";
+    return 6;
+  }
+  bool HasFailures{false};
+  json::OStream J(OS, 2);
+  J.object([&]() {
+    J.attributeObject("context", [&]() {
+      J.attribute("date", formatv("{0:%Y-%m-%d %H:%M:%S}",
+                                  std::chrono::system_clock::now())
+                              .str());
+      J.attribute("host_cpu", sys::getHostCPUName());
+      J.attribute("executable", ToolName);
+      J.attribute("num_cpus",
+                  static_cast<int64_t>(sys::getHostNumPhysicalCores()));
+      J.attribute("tsar_version", TSAR_VERSION_STRING);
+      J.attribute("llvm_version", LLVM_VERSION_STRING);
+#ifdef LLVM_DEBUG_BUILD
+      J.attribute("library_build_type", "debug");
+#else
+      J.attribute("library_build_type", "release");
+#endif
+    });
+    J.attributeArray("benchmarks", [&]() {
+      for (auto &K : Kernels) {
+        SmallString<128> File{Dir};
+        sys::path::append(File, Twine(K.Name) + ".c");
+        {
+          std::error_code EC;
+          raw_fd_ostream SrcOS(File, EC);
+          if (EC) {
+            errs() << "error: unable to write " << File << ": "
+                   << EC.message() << "\n";
+            HasFailures = true;
+            continue;
+          }
+          SrcOS << K.Source;
+        }
+        for (auto &Config : Configurations) {
+          std::vector<std::vector<StageTime>> Runs;
+          for (unsigned I = 0; I < Repetitions; ++I) {
+            auto Times{runPipeline(ToolName, File, Config)};
+            if (Times.empty()) {
+              errs() << "error: analysis of '" << K.Name << "' ("
+                     << Config.Name << ") failed\n";
+              HasFailures = true;
+              break;
+            }
+            Runs.push_back(std::move(Times));
+          }
+          if (Runs.size() != Repetitions)
+            continue;
+          auto NumStages{Runs.front().size()};
+          for (std::size_t S = 0; S < NumStages; ++S) {
+            SmallString<64> Name;
+            (Twine(K.Name) + "/" + Config.Name + "/" +
+             (S < std::size(Stages) ? Stages[S].Name : "Total"))
+                .toVector(Name);
+            std::vector<StageTime> Times;
+            for (auto &R : Runs)
+              Times.push_back(R[S]);
+            // Omit stages which are not executed for this configuration.
+            if (all_of(Times, [](auto &T) { return T.Real == 0; }))
+              continue;
+            for (unsigned I = 0; I < Repetitions; ++I)
+              emitRun(J, Name, Repetitions, "iteration", "", I, Times[I]);
+            if (Repetitions < 2)
+              continue;
+            StageTime Mean;
+            for (auto &T : Times) {
+              Mean.Real += T.Real / Repetitions;
+              Mean.CPU += T.CPU / Repetitions;
+            }
+            emitRun(J, Name, Repetitions, "aggregate", "mean", 0, Mean);
+            auto Mid{Times.begin() + Times.size() / 2};
+            std::nth_element(Times.begin(), Mid, Times.end(),
+                             [](auto &L, auto &R) { return L.Real < R.Real; });
+            emitRun(J, Name, Repetitions, "aggregate", "median", 0, *Mid);
+          }
+        }
+      }
+    });
+  });
+  OS << "\n";
+  sys::fs::remove_directories(Dir);
+  return HasFailures ? 7 : 0;
+}
+}
+
+int main(int Argc, const char **Argv) {
+  llvm_shutdown_obj ShutdownObj;
+  std::string Help =
+    "parameter: [number of repetitions] [output file]\n";
+  if (Argc > 3) {
+    errs() << "error: too many arguments\n" << Help;
+    return 1;
+  }
+  unsigned Repetitions = (Argc > 1) ? std::atoi(Argv[1]) : 3;
+  if (Repetitions == 0) {
+    errs() << "error: invalid number of repetitions\n" << Help;
+    return 2;
+  }
+  if (Argc < 3)
+    return run(Argv[0], Repetitions, outs());
+  std::error_code EC;
+  raw_fd_ostream OS(Argv[2], EC);
+  if (EC) {
+    errs() << "error: unable to open " << Argv[2] << ": " << EC.message()
+           << "\n";
+    return 3;
+  }
+  return run(Argv[0], Repetitions, OS);
+}
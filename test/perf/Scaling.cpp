@@ -0,0 +1,337 @@
+//===- Scaling.cpp ------ Analysis Scalability Benchmark --------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This benchmark generates C programs of a growing size and measures how
+// time and memory of the default analysis pipeline depend on the size.
+//
+// A generated program contains a loop nest which accesses multiple arrays.
+// The number of arrays, the depth of the nest and the number of statements
+// in the body of the nest are varied separately. Accesses through pointers
+// which may alias and calls of functions may be optionally generated.
+//
+// For each varied parameter a table (<parameter>.csv) and a gnuplot script
+// which plots this table (<parameter>.gp) are written to an output directory.
+// Generated sources are kept in the same directory, so a program which
+// exposes a problem can be reproduced without the benchmark.
+//
+//===----------------------------------------------------------------------===//
+
+#include <tsar/Core/PassProfiler.h>
+#include <tsar/Core/Tool.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Pass.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/ManagedStatic.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/Timer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+/// Extent of each dimension of generated arrays.
+constexpr unsigned Extent = 16;
+
+/// Parameters of a generated program.
+struct KernelShape {
+  /// Number of arrays which are accessed in a loop nest.
+  unsigned Arrays = 4;
+  /// Depth of a loop nest (and number of dimensions of each array).
+  unsigned Depth = 2;
+  /// Number of statements in the body of a loop nest.
+  unsigned Statements = 4;
+  /// Access arrays through pointer parameters which may alias.
+  bool Aliasing = false;
+  /// Call functions from the body of a loop nest.
+  bool Calls = false;
+};
+
+/// Print a subscript expression in a specified dimension of an array access.
+///
+/// Each statement reads neighbour elements in one of dimensions, so there
+/// are loop-carried dependencies between statements.
+void printSubscripts(unsigned Depth, unsigned ShiftDim, int Shift,
+                     raw_ostream &OS) {
+  for (unsigned D = 0; D < Depth; ++D) {
+    OS << "[I" << D;
+    if (D == ShiftDim && Shift != 0)
+      OS << (Shift > 0 ? " + " : " - ") << std::abs(Shift);
+    OS << "]";
+  }
+}
+
+/// Print a C program of a specified shape.
+void generate(const KernelShape &Shape, raw_ostream &OS) {
+  std::string Dims, TailDims;
+  for (unsigned D = 0; D < Shape.Depth; ++D)
+    (D == 0 ? Dims : TailDims) += "[E]";
+  Dims += TailDims;
+  OS << "#define E " << Extent << "\n\n";
+  for (unsigned A = 0; A < Shape.Arrays; ++A)
+    OS << "double A" << A << Dims << ";\n";
+  if (Shape.Calls) {
+    OS << "double Counter[E];\n\n";
+    OS << "double combine(double X, double Y) {\n"
+          "  return X * 0.5 + Y;\n"
+          "}\n\n";
+    OS << "void touch(int I) {\n"
+          "  Counter[I % E] += 1.0;\n"
+          "}\n";
+  }
+  OS << "\nvoid kernel(";
+  auto Base{Shape.Aliasing ? "P" : "A"};
+  if (Shape.Aliasing)
+    for (unsigned A = 0; A < Shape.Arrays; ++A)
+      OS << (A == 0 ? "" : ", ") << "double (*P" << A << ")" << TailDims;
+  else
+    OS << "void";
+  OS << ") {\n";
+  std::string Indent{"  "};
+  for (unsigned D = 0; D < Shape.Depth; ++D, Indent += "  ")
+    OS << Indent << "for (int I" << D << " = 1; I" << D << " < E - 1; ++I"
+       << D << ")" << (D + 1 == Shape.Depth ? " {" : "") << "\n";
+  for (unsigned S = 0; S < Shape.Statements; ++S) {
+    auto ShiftDim{S % Shape.Depth};
+    OS << Indent << Base << S % Shape.Arrays;
+    printSubscripts(Shape.Depth, ShiftDim, 0, OS);
+    OS << " = " << (Shape.Calls ? "combine(" : "");
+    OS << Base << (S + 1) % Shape.Arrays;
+    printSubscripts(Shape.Depth, ShiftDim, -1, OS);
+    OS << (Shape.Calls ? ", " : " * 0.5 + ");
+    OS << Base << (S + 2) % Shape.Arrays;
+    printSubscripts(Shape.Depth, ShiftDim, 1, OS);
+    OS << (Shape.Calls ? ")" : "") << ";\n";
+    if (Shape.Calls)
+      OS << Indent << "touch(I" << ShiftDim << ");\n";
+  }
+  Indent.resize(Indent.size() - 2);
+  OS << Indent << "}\n";
+  OS << "}\n\n";
+  OS << "int main() {\n  kernel(";
+  // The last parameter points to the same array as the first one, so
+  // an alias analysis can not disambiguate all parameters.
+  if (Shape.Aliasing)
+    for (unsigned A = 0; A < Shape.Arrays; ++A)
+      OS << (A == 0 ? "" : ", ") << "A"
+         << (A + 1 == Shape.Arrays && A > 0 ? 0 : A);
+  OS << ");\n  return 0;\n}\n";
+}
+
+/// Results of analysis of a single program.
+struct Measurement {
+  double Total = 0;
+  double AliasTree = 0;
+  double DefinedMemory = 0;
+  double Depends = 0;
+  std::size_t PeakHeap = 0;
+};
+
+/// Return accumulated wall time (in milliseconds) of all timers with
+/// a specified name and reset all timers.
+StringMap<double> collectWallTimers() {
+  std::string Buffer;
+  raw_string_ostream OS(Buffer);
+  TimerGroup::printAllJSONValues(OS, "");
+  OS.flush();
+  TimerGroup::clearAll();
+  StringMap<double> Values;
+  SmallVector<StringRef, 64> Lines;
+  StringRef(Buffer).split(Lines, '\n', -1, false);
+  for (auto Line : Lines) {
+    auto KeyValue{Line.trim().rtrim(',').rsplit(':')};
+    auto Key{KeyValue.first.trim().trim('"')};
+    double Value;
+    if (Key.consume_back(".wall") &&
+        !KeyValue.second.trim().getAsDouble(Value))
+      Values[Key] += Value * 1000;
+  }
+  return Values;
+}
+
+/// Analyze a specified file, return false if analysis fails.
+bool analyze(StringRef ToolName, StringRef File, StringRef Profile,
+             Measurement &M) {
+  std::string ProfileArg{("-pass-profile=" + Profile).str()};
+  const char *Argv[] = {ToolName.data(), File.data(), ProfileArg.c_str()};
+  // Options which have been specified in the previous run are reset, so
+  // each run starts with default values of options.
+  cl::ResetAllOptionOccurrences();
+  Tool Analyzer(std::size(Argv), Argv);
+  TimerGroup::clearAll();
+  PassProfiler::get().clear();
+  TimePassesIsEnabled = true;
+  auto BaseHeap{sys::Process::GetMallocUsage()};
+  auto Start{std::chrono::steady_clock::now()};
+  auto Res{Analyzer.run()};
+  std::chrono::duration<double, std::milli> Total{
+      std::chrono::steady_clock::now() - Start};
+  TimePassesIsEnabled = false;
+  auto Timers{collectWallTimers()};
+  if (Res != 0)
+    return false;
+  M.Total = Total.count();
+  M.AliasTree = Timers.lookup("time.pass.estimate-mem");
+  M.DefinedMemory = Timers.lookup("time.pass.def-mem");
+  M.Depends = Timers.lookup("time.tsar-da.depends");
+  auto PeakHeap{PassProfiler::get().getPeakHeap()};
+  M.PeakHeap = PeakHeap > BaseHeap ? PeakHeap - BaseHeap : 0;
+  return true;
+}
+
+/// Parameter of a program which is varied.
+struct Sweep {
+  const char *Name;
+  const char *Label;
+  unsigned KernelShape::*Param;
+  std::vector<unsigned> Values;
+};
+
+/// Write a gnuplot script which plots time and memory against a parameter.
+void writePlot(const Sweep &S, raw_ostream &OS) {
+  OS << "set datafile separator ','\n"
+     << "set terminal pngcairo size 1024,768\n"
+     << "set output '" << S.Name << ".png'\n"
+     << "set key left top autotitle columnhead\n"
+     << "set xlabel '" << S.Label << "'\n"
+     << "set ylabel 'time, ms'\n"
+     << "set y2label 'peak heap, KiB'\n"
+     << "set ytics nomirror\n"
+     << "set y2tics\n"
+     << "plot '" << S.Name << ".csv' using 1:2 with linespoints, \\\n"
+     << "  '' using 1:3 with linespoints, \\\n"
+     << "  '' using 1:4 with linespoints, \\\n"
+     << "  '' using 1:5 with linespoints, \\\n"
+     << "  '' using 1:6 axes x1y2 with linespoints\n";
+}
+
+int run(StringRef ToolName, StringRef Dir, const KernelShape &BaseShape,
+        unsigned MaxIter) {
+  if (auto EC{sys::fs::create_directories(Dir)}) {
+    errs() << "error: unable to create " << Dir << ": " << EC.message()
+           << "\n";
+    return 6;
+  }
+  SmallString<128> Profile{Dir};
+  sys::path::append(Profile, "profile.json");
+  const Sweep Sweeps[] = {
+    {"arrays", "number of arrays", &KernelShape::Arrays,
+     {1, 2, 4, 8, 16, 32}},
+    {"depth", "depth of a loop nest", &KernelShape::Depth,
+     {1, 2, 3, 4, 5, 6}},
+    {"statements", "number of statements", &KernelShape::Statements,
+     {1, 2, 4, 8, 16, 32, 64}}
+  };
+  bool HasFailures{false};
+  for (auto &S : Sweeps) {
+    outs() << "Vary " << S.Label << "\n";
+    SmallString<128> TableFile{Dir}, PlotFile{Dir};
+    sys::path::append(TableFile, Twine(S.Name) + ".csv");
+    sys::path::append(PlotFile, Twine(S.Name) + ".gp");
+    std::error_code EC;
+    raw_fd_ostream TableOS(TableFile, EC);
+    if (EC) {
+      errs() << "error: unable to open " << TableFile << ": " << EC.message()
+             << "\n";
+      return 7;
+    }
+    TableOS << S.Name << ",total (ms),alias tree (ms),defined memory (ms),"
+            << "dependence tests (ms),peak heap (KiB)\n";
+    for (auto V : S.Values) {
+      auto Shape{BaseShape};
+      Shape.*S.Param = V;
+      SmallString<128> File{Dir};
+      sys::path::append(File, Twine(S.Name) + "-" + Twine(V) + ".c");
+      {
+        raw_fd_ostream SrcOS(File, EC);
+        if (EC) {
+          errs() << "error: unable to write " << File << ": " << EC.message()
+                 << "\n";
+          return 7;
+        }
+        generate(Shape, SrcOS);
+      }
+      // The fastest run is used to reduce noise, memory usage does not
+      // depend on a run.
+      Measurement Best;
+      bool IsOk{true};
+      for (unsigned I = 0; I < MaxIter && IsOk; ++I) {
+        Measurement M;
+        if (!(IsOk = analyze(ToolName, File, Profile, M)))
+          break;
+        if (I == 0 || M.Total < Best.Total)
+          Best = M;
+      }
+      if (!IsOk) {
+        errs() << "error: analysis of " << File << " failed\n";
+        HasFailures = true;
+        continue;
+      }
+      TableOS << V << "," << Best.Total << "," << Best.AliasTree << ","
+              << Best.DefinedMemory << "," << Best.Depends << ","
+              << Best.PeakHeap / 1024 << "\n";
+      outs() << "  " << S.Name << " = " << V << ": total " << Best.Total
+             << "ms, alias tree " << Best.AliasTree << "ms, defined memory "
+             << Best.DefinedMemory << "ms, dependence tests " << Best.Depends
+             << "ms, peak heap " << Best.PeakHeap / 1024 << "KiB\n";
+    }
+    raw_fd_ostream PlotOS(PlotFile, EC);
+    if (EC) {
+      errs() << "error: unable to open " << PlotFile << ": " << EC.message()
+             << "\n";
+      return 7;
+    }
+    writePlot(S, PlotOS);
+  }
+  sys::fs::remove(Profile);
+  return HasFailures ? 8 : 0;
+}
+}
+
+int main(int Argc, const char **Argv) {
+  llvm_shutdown_obj ShutdownObj;
+  std::string Help =
+    "parameter: <output directory> [alias pointers (0|1)] [calls (0|1)] "
+    "[number of iterations]\n";
+  if (Argc < 2) {
+    errs() << "error: too few arguments\n" << Help;
+    return 1;
+  } else if (Argc > 5) {
+    errs() << "error: too many arguments\n" << Help;
+    return 2;
+  }
+  KernelShape Shape;
+  Shape.Aliasing = (Argc > 2) ? std::atoi(Argv[2]) != 0 : false;
+  Shape.Calls = (Argc > 3) ? std::atoi(Argv[3]) != 0 : false;
+  unsigned MaxIter = (Argc > 4) ? std::atoi(Argv[4]) : 3;
+  if (MaxIter == 0) {
+    errs() << "error: invalid number of iterations\n" << Help;
+    return 3;
+  }
+  return run(Argv[0], Argv[1], Shape, MaxIter);
+}
@@ -0,0 +1,291 @@
+//===- SpanningTree.cpp ----- Spanning Tree Benchmark -----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2022 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This benchmark compares queries to relation between nodes in a spanning
+// tree with dense arrays of node numbers (see SpanningTreeRelation) and with
+// a map from nodes to their numbers (see GraphNumbering).
+//
+//===----------------------------------------------------------------------===//
+
+#include <tsar/ADT/GraphNumbering.h>
+#include <tsar/ADT/SpanningTreeRelation.h>
+#include <llvm/ADT/DenseSet.h>
+#include <llvm/Support/raw_ostream.h>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+struct TreeNode {
+  TreeNode *Parent = nullptr;
+  std::vector<TreeNode *> Children;
+};
+
+struct Tree {
+  std::vector<std::unique_ptr<TreeNode>> Nodes;
+};
+}
+
+namespace llvm {
+template<> struct GraphTraits<Tree *> {
+  using NodeRef = TreeNode *;
+  using ChildIteratorType = std::vector<TreeNode *>::iterator;
+  static NodeRef getEntryNode(Tree *T) { return T->Nodes.front().get(); }
+  static ChildIteratorType child_begin(NodeRef N) {
+    return N->Children.begin();
+  }
+  static ChildIteratorType child_end(NodeRef N) { return N->Children.end(); }
+  static std::size_t size(Tree *T) { return T->Nodes.size(); }
+};
+
+template<> struct GraphTraits<Inverse<Tree *>> {
+  using NodeRef = TreeNode *;
+  using ChildIteratorType = TreeNode **;
+  static NodeRef getEntryNode(Inverse<Tree *> T) {
+    return T.Graph->Nodes.front().get();
+  }
+  static ChildIteratorType child_begin(NodeRef N) { return &N->Parent; }
+  static ChildIteratorType child_end(NodeRef N) {
+    return N->Parent ? &N->Parent + 1 : &N->Parent;
+  }
+  static std::size_t size(Inverse<Tree *> T) { return T.Graph->Nodes.size(); }
+};
+}
+
+namespace {
+/// Relation between nodes which uses a map from nodes to their numbers.
+class MapTreeRelation {
+public:
+  explicit MapTreeRelation(Tree *T) { numberGraph(T, &mNumbering); }
+
+  TreeRelation compare(TreeNode *LHS, TreeNode *RHS) const {
+    if (LHS == RHS)
+      return TR_EQUAL;
+    auto LeftItr = mNumbering.find(LHS);
+    auto RightItr = mNumbering.find(RHS);
+    if (LeftItr->get<Preorder>() < RightItr->get<Preorder>() &&
+        LeftItr->get<ReversePostorder>() < RightItr->get<ReversePostorder>())
+      return TR_ANCESTOR;
+    if (LeftItr->get<Preorder>() > RightItr->get<Preorder>() &&
+        LeftItr->get<ReversePostorder>() > RightItr->get<ReversePostorder>())
+      return TR_DESCENDANT;
+    return TR_UNREACHABLE;
+  }
+
+  /// Find a common ancestor (not equal to any node) climbing to parents.
+  template<class ItrTy>
+  TreeNode *findLCA(ItrTy BeginItr, ItrTy EndItr) const {
+    auto *LCA = (*BeginItr)->Parent;
+    for (auto I = BeginItr; LCA && I != EndItr; ++I)
+      while (LCA && compare(LCA, *I) != TR_ANCESTOR)
+        LCA = LCA->Parent;
+    return LCA;
+  }
+
+private:
+  GraphNumbering<TreeNode *> mNumbering;
+};
+
+using TimeT = std::chrono::duration<double>;
+
+/// Build a random tree, each node has a random parent from previous nodes,
+/// however, the depth of a tree is limited by the `Depth` parameter.
+std::unique_ptr<Tree> initializeTree(std::size_t Size, std::size_t Depth) {
+  auto T = std::make_unique<Tree>();
+  std::vector<std::size_t> Levels(Size, 0);
+  T->Nodes.push_back(std::make_unique<TreeNode>());
+  for (std::size_t I = 1; I < Size; ++I) {
+    std::size_t ParentIdx;
+    do {
+      ParentIdx = std::rand() % I;
+    } while (Levels[ParentIdx] + 1 > Depth);
+    Levels[I] = Levels[ParentIdx] + 1;
+    T->Nodes.push_back(std::make_unique<TreeNode>());
+    T->Nodes.back()->Parent = T->Nodes[ParentIdx].get();
+    T->Nodes[ParentIdx]->Children.push_back(T->Nodes.back().get());
+  }
+  return T;
+}
+
+struct Result {
+  TimeT Build{0};
+  TimeT Compare{0};
+  TimeT LCA{0};
+  TimeT Descendants{0};
+  std::size_t CompareSum = 0;
+  std::size_t LCASum = 0;
+  std::size_t DescendantsSum = 0;
+};
+
+template<class Fn> TimeT measure(Fn &&F) {
+  auto Start = std::chrono::high_resolution_clock::now();
+  F();
+  return std::chrono::high_resolution_clock::now() - Start;
+}
+
+void print(StringRef Name, const Result &R, unsigned MaxIter) {
+  outs() << "  " << Name << " construction time (.s) "
+         << (R.Build / MaxIter).count() << "\n";
+  outs() << "  " << Name << " compare() time (.s) "
+         << (R.Compare / MaxIter).count() << "\n";
+  outs() << "  " << Name << " findLCA() time (.s) "
+         << (R.LCA / MaxIter).count() << "\n";
+  outs() << "  " << Name << " descendants in a set time (.s) "
+         << (R.Descendants / MaxIter).count() << "\n";
+}
+
+void run(std::size_t Size, std::size_t Depth, std::size_t QuerySize,
+         unsigned MaxIter) {
+  outs() << "Parameters:\n";
+  outs() << "  number of nodes " << Size << "\n";
+  outs() << "  maximum depth " << Depth << "\n";
+  outs() << "  number of queries " << QuerySize << "\n";
+  outs() << "  number of iterations " << MaxIter << "\n";
+  Result Map, Dense, Index;
+  for (unsigned Iter = 0; Iter < MaxIter; ++Iter) {
+    auto T = initializeTree(Size, Depth);
+    std::vector<std::pair<TreeNode *, TreeNode *>> Queries(QuerySize);
+    for (auto &Q : Queries)
+      Q = std::make_pair(T->Nodes[std::rand() % Size].get(),
+                         T->Nodes[std::rand() % Size].get());
+    DenseSet<TreeNode *> Set;
+    for (std::size_t I = 0; I < std::max<std::size_t>(Size / 10, 1); ++I)
+      Set.insert(T->Nodes[std::rand() % Size].get());
+    std::unique_ptr<MapTreeRelation> MapSTR;
+    Map.Build += measure([&MapSTR, &T]() {
+      MapSTR = std::make_unique<MapTreeRelation>(T.get());
+    });
+    Map.Compare += measure([&Map, &MapSTR, &Queries]() {
+      for (auto &Q : Queries)
+        Map.CompareSum += MapSTR->compare(Q.first, Q.second);
+    });
+    Map.LCA += measure([&Map, &MapSTR, &Queries]() {
+      for (auto &Q : Queries) {
+        std::array<TreeNode *, 2> Nodes{ Q.first, Q.second };
+        Map.LCASum += reinterpret_cast<std::uintptr_t>(
+            MapSTR->findLCA(Nodes.begin(), Nodes.end()));
+      }
+    });
+    Map.Descendants += measure([&Map, &MapSTR, &Set, &Queries]() {
+      for (auto &Q : Queries)
+        for (auto *N : Set)
+          Map.DescendantsSum += MapSTR->compare(N, Q.first) == TR_DESCENDANT;
+    });
+    std::unique_ptr<SpanningTreeRelation<Tree *>> STR;
+    auto BuildTime = measure([&STR, &T]() {
+      STR = std::make_unique<SpanningTreeRelation<Tree *>>(T.get());
+    });
+    Dense.Build += BuildTime;
+    Index.Build += BuildTime;
+    Dense.Compare += measure([&Dense, &STR, &Queries]() {
+      for (auto &Q : Queries)
+        Dense.CompareSum += STR->compare(Q.first, Q.second);
+    });
+    Dense.LCA += measure([&Dense, &STR, &Queries]() {
+      for (auto &Q : Queries) {
+        std::array<TreeNode *, 2> Nodes{ Q.first, Q.second };
+        Dense.LCASum += reinterpret_cast<std::uintptr_t>(
+            STR->findLCA(Nodes.begin(), Nodes.end()).getValueOr(nullptr));
+      }
+    });
+    Dense.Descendants += measure([&Dense, &STR, &Set, &Queries]() {
+      for (auto &Q : Queries) {
+        SmallVector<TreeNode *, 16> Descendants;
+        STR->findDescendants(Q.first, Set, Descendants);
+        Dense.DescendantsSum += Descendants.size();
+      }
+    });
+    std::vector<std::pair<unsigned, unsigned>> IndexQueries;
+    IndexQueries.reserve(QuerySize);
+    for (auto &Q : Queries)
+      IndexQueries.emplace_back(STR->getIndex(Q.first),
+                                STR->getIndex(Q.second));
+    Index.Compare += measure([&Index, &STR, &IndexQueries]() {
+      for (auto &Q : IndexQueries)
+        Index.CompareSum += STR->compareByIndex(Q.first, Q.second);
+    });
+    Index.LCA += measure([&Index, &STR, &Queries]() {
+      for (auto &Q : Queries) {
+        std::array<TreeNode *, 2> Nodes{ Q.first, Q.second };
+        Index.LCASum += reinterpret_cast<std::uintptr_t>(
+            findLCA(*STR, Nodes.begin(), Nodes.end()).getValueOr(nullptr));
+      }
+    });
+  }
+  outs() << "\n";
+  if (Map.CompareSum == Dense.CompareSum &&
+      Map.CompareSum == Index.CompareSum && Map.LCASum == Dense.LCASum &&
+      Map.LCASum == Index.LCASum &&
+      Map.DescendantsSum == Dense.DescendantsSum)
+    outs() << "Results of queries are equal\n";
+  else
+    outs() << "Results of queries are NOT equal\n";
+  outs() << "\n";
+  print("map", Map, MaxIter);
+  outs() << "\n";
+  print("dense", Dense, MaxIter);
+  outs() << "\n";
+  outs() << "  dense compareByIndex() time (.s) "
+         << (Index.Compare / MaxIter).count() << "\n";
+  outs() << "  dense findLCA() over inverse graph time (.s) "
+         << (Index.LCA / MaxIter).count() << "\n";
+}
+}
+
+int main(int Argc, const char **Argv) {
+  std::string Help =
+    "parameter: <number of nodes> [maximum depth] [number of queries] "
+    "[number of iterations]\n";
+  if (Argc < 2) {
+    errs() << "error: too few arguments\n" << Help;
+    return 1;
+  } else if (Argc > 5) {
+    errs() << "error: too many arguments\n" << Help;
+    return 2;
+  }
+  std::size_t Size = std::atoll(Argv[1]);
+  std::size_t Depth = (Argc > 2) ? std::atoll(Argv[2]) : 16;
+  std::size_t QuerySize = (Argc > 3) ? std::atoll(Argv[3]) : 10000;
+  unsigned MaxIter = (Argc > 4) ? std::atoi(Argv[4]) : 10;
+  if (Size == 0) {
+    errs() << "error: invalid number of nodes\n" << Help;
+    return 3;
+  }
+  if (Depth == 0) {
+    errs() << "error: invalid maximum depth\n" << Help;
+    return 4;
+  }
+  if (QuerySize == 0) {
+    errs() << "error: invalid number of queries\n" << Help;
+    return 5;
+  }
+  if (MaxIter == 0) {
+    errs() << "error: invalid number of iterations\n" << Help;
+    return 6;
+  }
+  run(Size, Depth, QuerySize, MaxIter);
+  return 0;
+}